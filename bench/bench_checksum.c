@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../scomlib_extra/scomlib_extra.h"
+
+// bytes checksummed per measurement, so that every payload size runs for a comparable time
+#define TOTAL_BYTES (256u * 1024 * 1024)
+
+static const size_t k_sizes[] = {10, 16, 64, 256, 1024, 4096, 16384, 65535};
+
+static char g_src[65536];
+static char g_dst[65536];
+
+static double now_sec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+typedef enum { KERNEL_REF, KERNEL_SCOM, KERNEL_DISPATCH, KERNEL_MEMCPY_DISPATCH, KERNEL_FUSED } kernel_t;
+
+static const char *k_kernel_names[] = {"reference", "scom_calc_checksum", "scomx_checksum", "memcpy+checksum", "scomx_copy_checksum"};
+
+static uint16_t run(kernel_t kernel, size_t size)
+{
+    switch (kernel) {
+    case KERNEL_REF:
+        return scomx_checksum_ref(g_src, size);
+    case KERNEL_SCOM:
+        return scom_calc_checksum(g_src, size);
+    case KERNEL_DISPATCH:
+        return scomx_checksum(g_src, size);
+    case KERNEL_MEMCPY_DISPATCH:
+        memcpy(g_dst, g_src, size);
+        return scomx_checksum(g_dst, size);
+    case KERNEL_FUSED:
+        return scomx_copy_checksum(g_dst, g_src, size);
+    }
+    return 0;
+}
+
+int main()
+{
+    srand(1);
+    for (size_t i = 0; i < sizeof(g_src); i++) {
+        g_src[i] = (char)rand();
+    }
+
+    printf("kernel: %s\n", scomx_checksum_kernel_name());
+    printf("%-20s %8s %12s %10s\n", "function", "size", "ns/op", "MB/s");
+
+    for (size_t s = 0; s < SCOM_NBR_ELEMENTS(k_sizes); s++) {
+        size_t size = k_sizes[s];
+        unsigned iterations = TOTAL_BYTES / size;
+        uint16_t expected = scomx_checksum_ref(g_src, size);
+
+        for (kernel_t k = KERNEL_REF; k <= KERNEL_FUSED; k++) {
+            volatile uint16_t sink = 0;
+
+            if (run(k, size) != expected) {
+                printf("%s: checksum mismatch for size %zu\n", k_kernel_names[k], size);
+                return 1;
+            }
+
+            double start = now_sec();
+            for (unsigned i = 0; i < iterations; i++) {
+                sink ^= run(k, size);
+            }
+            double elapsed = now_sec() - start;
+
+            printf("%-20s %8zu %12.1f %10.0f\n", k_kernel_names[k], size, elapsed * 1e9 / iterations, (double)iterations * size / elapsed / 1e6);
+            (void)sink;
+        }
+    }
+
+    return 0;
+}
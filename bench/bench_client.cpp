@@ -0,0 +1,240 @@
+// Compares the typed C++ reads of scomlib_extra_client.hpp with the equivalent hand-written C calls
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include "../scomlib_extra/scomlib_extra_client.hpp"
+
+// minimum measured time per benchmark; the iteration count is doubled until it is reached
+#define MIN_RUN_SEC 0.25
+
+// slowdown of the C++ code against the C code, in percent, reported as a regression
+#define DEFAULT_THRESHOLD_PCT 10.0
+
+#define OBJECT SCOMX_INFO_XTENDER_BATT_VOLTAGE
+
+typedef struct {
+    // response of the device to reading OBJECT, returned by the loopback transport after each request
+    char response[64];
+    size_t response_length;
+    int response_pending;
+
+    scomx_dec_result_t res;
+    char parser_buffer[256];
+    scomx_parser_t parser;
+    scomx_transport_t transport;
+
+    // read through a volatile so that the encoding can't be hoisted out of the loop
+    volatile uint32_t dst_addr;
+    // accumulates results so that the measured calls can't be optimized out
+    volatile float sink;
+} bench_state_t;
+
+typedef struct {
+    const char *name;
+    void (*run)(bench_state_t *st);
+} bench_case_t;
+
+static bench_state_t g_state;
+static scomx::client<> *g_client;
+
+static double now_sec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static long loopback_write(void *user, const char *data, size_t length, int64_t deadline_ms)
+{
+    (void)data;
+    (void)deadline_ms;
+    static_cast<bench_state_t *>(user)->response_pending = 1;
+    return (long)length;
+}
+
+static long loopback_read(void *user, char *buffer, size_t size, int64_t deadline_ms)
+{
+    bench_state_t *st = static_cast<bench_state_t *>(user);
+
+    (void)deadline_ms;
+    if (!st->response_pending || size < st->response_length) {
+        return 0;
+    }
+    st->response_pending = 0;
+    memcpy(buffer, st->response, st->response_length);
+    return (long)st->response_length;
+}
+
+static int64_t loopback_now_ms(void *user)
+{
+    (void)user;
+    return 0;
+}
+
+static void prepare(bench_state_t *st)
+{
+    scomx_ctx_t ctx;
+    char ctx_buffer[64];
+    char value[4];
+
+    scom_write_le_float(value, 25.5f);
+    scomx_ctx_init(&ctx, ctx_buffer, sizeof(ctx_buffer));
+    scomx_enc_result_t enc = scomx_ctx_encode_property_response(&ctx, SCOMX_DEST_XTM(0), scomx_frame_flags_from_byte(0), SCOM_READ_PROPERTY_SERVICE,
+                                                                 SCOM_USER_INFO_OBJECT_TYPE, OBJECT, SCOMX_PROP_USER_INFO_VALUE, value, sizeof(value));
+    memcpy(st->response, enc.data, enc.length);
+    st->response_length = enc.length;
+
+    // kept decoded for the decoding benchmarks
+    static char decoded[64];
+    memcpy(decoded, st->response, st->response_length);
+    st->res = scomx_decode_frame_inplace(decoded, st->response_length);
+
+    scomx_parser_init(&st->parser, st->parser_buffer, sizeof(st->parser_buffer));
+    st->transport.user = st;
+    st->transport.write = loopback_write;
+    st->transport.read = loopback_read;
+    st->transport.now_ms = loopback_now_ms;
+    st->transport.timeout_ms = 100;
+    st->dst_addr = SCOMX_DEST_XTM(0);
+}
+
+static void run_c_encode(bench_state_t *st)
+{
+    scomx_enc_result_t enc = scomx_encode_read_user_info_value(st->dst_addr, OBJECT);
+    st->sink = st->sink + (unsigned char)enc.data[SCOM_FRAME_HEADER_SIZE - 1];
+}
+
+static void run_cpp_encode(bench_state_t *st)
+{
+    scomx::request_frame frame = scomx::object<OBJECT>::encode(st->dst_addr);
+    st->sink = st->sink + (unsigned char)frame.data[SCOM_FRAME_HEADER_SIZE - 1];
+}
+
+static void run_c_decode(bench_state_t *st) { st->sink = st->sink + scomx_result_float(st->res); }
+
+static void run_cpp_decode(bench_state_t *st) { st->sink = st->sink + scomx::object<OBJECT>::decode(st->res).value; }
+
+// the whole read over the loopback transport, as an application without the C++ layer writes it
+static void run_c_read(bench_state_t *st)
+{
+    const scomx_transport_t *transport = &st->transport;
+    uint32_t dst_addr = st->dst_addr;
+    scomx_dec_result_t res;
+
+    scomx_enc_result_t enc = scomx_encode_read_user_info_value(dst_addr, OBJECT);
+    int64_t deadline = transport->now_ms(transport->user) + transport->timeout_ms;
+
+    scomx_parser_reset(&st->parser);
+    if (transport->write(transport->user, enc.data, enc.length, deadline) != (long)enc.length) {
+        return;
+    }
+    if (scomx_receive_response(transport, &st->parser, dst_addr, SCOM_USER_INFO_OBJECT_TYPE, OBJECT, SCOMX_PROP_USER_INFO_VALUE, deadline, &res) ==
+        SCOM_ERROR_NO_ERROR) {
+        st->sink = st->sink + scomx_result_float(res);
+    }
+}
+
+static void run_cpp_read(bench_state_t *st)
+{
+    scomx::result<float> v = g_client->read<OBJECT>(st->dst_addr);
+    if (v) {
+        st->sink = st->sink + v.value;
+    }
+}
+
+// the frames encoded at compile time, by object<>::encode and by the C encoders must be the same bytes
+static int check_frames()
+{
+    static constexpr scomx::request_frame k_frame = scomx::read_user_info_frame(SCOMX_DEST_XTM(0), OBJECT);
+    static const uint32_t k_dst_addrs[] = {SCOMX_DEST_XTM(0), SCOMX_DEST_XTM(1), SCOMX_DEST_MPPT(0), 0x12345678};
+    char c_frame[SCOMX_READ_REQUEST_SIZE];
+
+    scomx_enc_result_t enc = scomx_encode_read_user_info_value(SCOMX_DEST_XTM(0), OBJECT);
+    if (enc.length != k_frame.size() || memcmp(enc.data, k_frame.data, enc.length) != 0) {
+        return 1;
+    }
+
+    for (uint32_t dst_addr : k_dst_addrs) {
+        scomx_encode_read_request_frame(c_frame, dst_addr, SCOM_USER_INFO_OBJECT_TYPE, OBJECT, SCOMX_PROP_USER_INFO_VALUE);
+        scomx::request_frame info = scomx::read_user_info_frame(dst_addr, OBJECT);
+        scomx::request_frame encoded = scomx::object<OBJECT>::encode(dst_addr);
+        if (memcmp(c_frame, info.data, sizeof(c_frame)) != 0 || memcmp(c_frame, encoded.data, sizeof(c_frame)) != 0) {
+            return 1;
+        }
+
+        scomx_encode_read_request_frame(c_frame, dst_addr, SCOM_PARAMETER_OBJECT_TYPE, SCOMX_PARAM_XTENDER_AC_IN_CURRENT_MAX, SCOMX_PROP_PARAMETER_VALUE_QSP);
+        scomx::request_frame param = scomx::read_parameter_frame(dst_addr, SCOMX_PARAM_XTENDER_AC_IN_CURRENT_MAX);
+        if (memcmp(c_frame, param.data, sizeof(c_frame)) != 0) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+// each C++ case follows the C case it is compared with
+static const bench_case_t k_cases[] = {
+    {"c_encode_read_user_info_value", run_c_encode}, {"cpp_object_encode", run_cpp_encode}, {"c_result_float", run_c_decode},
+    {"cpp_object_decode", run_cpp_decode},           {"c_read", run_c_read},                {"cpp_client_read", run_cpp_read},
+};
+
+static double measure(const bench_case_t *bc)
+{
+    unsigned long iterations = 1024;
+
+    for (;;) {
+        double start = now_sec();
+        for (unsigned long i = 0; i < iterations; i++) {
+            bc->run(&g_state);
+        }
+        double elapsed = now_sec() - start;
+
+        if (elapsed >= MIN_RUN_SEC) {
+            return elapsed * 1e9 / iterations;
+        }
+        iterations *= 2;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    double threshold = DEFAULT_THRESHOLD_PCT;
+    int regressions = 0;
+
+    if (argc > 2 && strcmp(argv[1], "-t") == 0) {
+        threshold = atof(argv[2]);
+    } else if (argc > 1) {
+        fprintf(stderr, "usage: %s [-t threshold_pct]\n", argv[0]);
+        fprintf(stderr, "  exits with 1 when a C++ case is slower than its C counterpart by more than the threshold (default %.0f)\n", DEFAULT_THRESHOLD_PCT);
+        return 2;
+    }
+
+    prepare(&g_state);
+    scomx::client<> client(g_state.transport, SCOMX_DEST_XTM(0));
+    g_client = &client;
+
+    if (scomx_result_float(g_state.res) != scomx::object<OBJECT>::decode(g_state.res).value || client.read<OBJECT>().value != 25.5f) {
+        fprintf(stderr, "C and C++ results differ\n");
+        return 2;
+    }
+    if (check_frames() != 0) {
+        fprintf(stderr, "C and C++ request frames differ\n");
+        return 2;
+    }
+
+    printf("%-35s %10s %10s\n", "function", "ns/op", "vs C");
+    for (unsigned i = 0; i + 1 < SCOM_NBR_ELEMENTS(k_cases); i += 2) {
+        double c = measure(&k_cases[i]);
+        double cpp = measure(&k_cases[i + 1]);
+        double change = (cpp - c) * 100.0 / c;
+
+        printf("%-35s %10.1f\n", k_cases[i].name, c);
+        printf("%-35s %10.1f %+9.1f%%%s\n", k_cases[i + 1].name, cpp, change, change > threshold ? " REGRESSION" : "");
+        regressions += change > threshold;
+    }
+
+    return regressions ? 1 : 0;
+}
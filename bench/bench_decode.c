@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "../scomlib_extra/scomlib_extra.h"
+
+#define ITERATIONS 5000000
+
+// response of XTM 101 to reading SCOMX_INFO_XTENDER_OUT_AC_POWER, value 1.5
+static const char k_response[] = {
+    (char)0xAA, 0x00, 0x65, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x0E, 0x00, 0x73, 0x09,       // header
+    0x02, 0x01, 0x01, 0x00, (char)0xCF, 0x0B, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, (char)0xC0, 0x3F, // data
+    (char)0xDD, 0x65,                                                                               // data checksum
+};
+
+static double now_sec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, double elapsed, float check)
+{
+    printf("%-10s %8.1f ns/frame %12.0f frames/sec (value %.1f)\n", name, elapsed * 1e9 / ITERATIONS, ITERATIONS / elapsed, check);
+}
+
+// header and body copied into the context buffer, as done by scomx_decode_frame_header/scomx_decode_frame
+static void bench_copy()
+{
+    char buffer[256];
+    scomx_ctx_t ctx;
+    float sum = 0;
+
+    scomx_ctx_init(&ctx, buffer, sizeof(buffer));
+
+    double start = now_sec();
+    for (unsigned i = 0; i < ITERATIONS; i++) {
+        scomx_header_dec_result_t hdr = scomx_ctx_decode_frame_header(&ctx, k_response, SCOM_FRAME_HEADER_SIZE);
+        scomx_dec_result_t res = scomx_ctx_decode_frame(&ctx, k_response + SCOM_FRAME_HEADER_SIZE, hdr.length_to_read);
+        sum += scomx_result_float(res);
+    }
+    report("copy", now_sec() - start, sum / ITERATIONS);
+}
+
+// frame decoded where it sits in the receive buffer
+static void bench_inplace()
+{
+    char rxbuf[sizeof(k_response)];
+    float sum = 0;
+
+    memcpy(rxbuf, k_response, sizeof(rxbuf));
+
+    double start = now_sec();
+    for (unsigned i = 0; i < ITERATIONS; i++) {
+        scomx_header_dec_result_t hdr = scomx_decode_frame_header_inplace(rxbuf, SCOM_FRAME_HEADER_SIZE);
+        scomx_dec_result_t res = scomx_decode_frame_inplace(rxbuf, SCOM_FRAME_HEADER_SIZE + hdr.length_to_read);
+        sum += scomx_result_float(res);
+    }
+    report("in-place", now_sec() - start, sum / ITERATIONS);
+}
+
+int main()
+{
+    bench_copy();
+    bench_inplace();
+    return 0;
+}
@@ -0,0 +1,335 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../scomlib/scom_property.h"
+#include "../scomlib_extra/scomlib_extra.h"
+
+// minimum measured time per benchmark; the iteration count is doubled until it is reached
+#define MIN_RUN_SEC 0.25
+
+// slowdown against the baseline, in percent, reported as a regression
+#define DEFAULT_THRESHOLD_PCT 10.0
+
+#define MAX_BASELINE_ENTRIES 32
+
+// response of XTM 101 to reading SCOMX_INFO_XTENDER_OUT_AC_POWER, value 1.5
+static const char k_response[] = {
+    (char)0xAA, 0x00, 0x65, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x0E, 0x00, 0x73, 0x09,       // header
+    0x02, 0x01, 0x01, 0x00, (char)0xCF, 0x0B, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, (char)0xC0, 0x3F, // data
+    (char)0xDD, 0x65,                                                                               // data checksum
+};
+
+typedef struct {
+    char buffer[256];
+    scom_frame_t frame;
+    scom_property_t property;
+    scomx_ctx_t ctx;
+    char ctx_buffer[256];
+    scomx_dec_result_t res;
+    // accumulates results so that the measured calls can't be optimized out
+    volatile unsigned sink;
+} bench_state_t;
+
+typedef struct {
+    const char *name;
+    void (*prepare)(bench_state_t *st);
+    void (*run)(bench_state_t *st);
+} bench_case_t;
+
+typedef struct {
+    const char *name;
+    unsigned long iterations;
+    double ns_per_op;
+} bench_result_t;
+
+typedef struct {
+    char name[64];
+    double ns_per_op;
+} baseline_entry_t;
+
+static double now_sec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// FRAME LAYER
+
+static void prepare_request(bench_state_t *st)
+{
+    scom_initialize_frame(&st->frame, st->buffer, sizeof(st->buffer));
+    scom_initialize_property(&st->property, &st->frame);
+
+    st->frame.src_addr = 1;
+    st->frame.dst_addr = SCOMX_DEST_XTM(0);
+    st->property.object_type = SCOM_USER_INFO_OBJECT_TYPE;
+    st->property.object_id = SCOMX_INFO_XTENDER_OUT_AC_POWER;
+    st->property.property_id = SCOMX_PROP_USER_INFO_VALUE;
+    scom_encode_read_property(&st->property);
+}
+
+static void run_encode_request_frame(bench_state_t *st)
+{
+    scom_encode_request_frame(&st->frame);
+    st->sink += (unsigned char)st->buffer[SCOM_FRAME_HEADER_SIZE - 1];
+}
+
+static void prepare_response(bench_state_t *st)
+{
+    scom_initialize_frame(&st->frame, st->buffer, sizeof(st->buffer));
+    scom_initialize_property(&st->property, &st->frame);
+    memcpy(st->buffer, k_response, sizeof(k_response));
+}
+
+static void run_decode_frame_header(bench_state_t *st)
+{
+    st->frame.last_error = SCOM_ERROR_NO_ERROR;
+    scom_decode_frame_header(&st->frame);
+    st->sink += st->frame.data_length + st->frame.last_error;
+}
+
+static void prepare_response_data(bench_state_t *st)
+{
+    prepare_response(st);
+    scom_decode_frame_header(&st->frame);
+}
+
+static void run_decode_frame_data(bench_state_t *st)
+{
+    st->frame.last_error = SCOM_ERROR_NO_ERROR;
+    scom_decode_frame_data(&st->frame);
+    st->sink += st->frame.service_id + st->frame.last_error;
+}
+
+// PROPERTY LAYER
+
+static void run_encode_read_property(bench_state_t *st)
+{
+    scom_encode_read_property(&st->property);
+    st->sink += st->frame.data_length;
+}
+
+static void prepare_response_property(bench_state_t *st)
+{
+    prepare_response_data(st);
+    scom_decode_frame_data(&st->frame);
+}
+
+static void run_decode_read_property(bench_state_t *st)
+{
+    scom_decode_read_property(&st->property);
+    st->sink += st->property.object_id + st->property.value_length;
+}
+
+// SCOMLIB EXTRA
+
+static void prepare_ctx(bench_state_t *st) { scomx_ctx_init(&st->ctx, st->ctx_buffer, sizeof(st->ctx_buffer)); }
+
+static void run_encode_user_info_value(bench_state_t *st)
+{
+    scomx_enc_result_t enc = scomx_ctx_encode_read_user_info_value(&st->ctx, SCOMX_DEST_XTM(0), SCOMX_INFO_XTENDER_OUT_AC_POWER);
+    st->sink += enc.length;
+}
+
+static void run_decode_response(bench_state_t *st)
+{
+    scomx_header_dec_result_t hdr = scomx_ctx_decode_frame_header(&st->ctx, k_response, SCOM_FRAME_HEADER_SIZE);
+    scomx_dec_result_t res = scomx_ctx_decode_frame(&st->ctx, k_response + SCOM_FRAME_HEADER_SIZE, hdr.length_to_read);
+    st->sink += res.length + res.error;
+}
+
+static void run_encode_read_request_frame(bench_state_t *st)
+{
+    scomx_encode_read_request_frame(st->ctx_buffer, SCOMX_DEST_XTM(0), SCOM_USER_INFO_OBJECT_TYPE, SCOMX_INFO_XTENDER_OUT_AC_POWER, SCOMX_PROP_USER_INFO_VALUE);
+    st->sink += (unsigned char)st->ctx_buffer[SCOMX_READ_REQUEST_SIZE - 1];
+}
+
+static void prepare_decoded(bench_state_t *st)
+{
+    prepare_ctx(st);
+    scomx_header_dec_result_t hdr = scomx_ctx_decode_frame_header(&st->ctx, k_response, SCOM_FRAME_HEADER_SIZE);
+    st->res = scomx_ctx_decode_frame(&st->ctx, k_response + SCOM_FRAME_HEADER_SIZE, hdr.length_to_read);
+}
+
+// metadata lookup and decoding by the object's format, against the plain float decoding
+static void run_decode_typed(bench_state_t *st)
+{
+    scomx_typed_value_t v = scomx_decode_typed(&st->res);
+    st->sink += (unsigned)v.value + v.error;
+}
+
+static void run_result_float(bench_state_t *st) { st->sink += (unsigned)scomx_result_float(st->res); }
+
+// request encoded and the canned response decoded, as one polling cycle of a gateway does
+static void run_round_trip(bench_state_t *st)
+{
+    run_encode_user_info_value(st);
+    run_decode_response(st);
+}
+
+static const bench_case_t k_cases[] = {
+    {"scom_encode_request_frame", prepare_request, run_encode_request_frame},
+    {"scom_decode_frame_header", prepare_response, run_decode_frame_header},
+    {"scom_decode_frame_data", prepare_response_data, run_decode_frame_data},
+    {"scom_encode_read_property", prepare_request, run_encode_read_property},
+    {"scom_decode_read_property", prepare_response_property, run_decode_read_property},
+    {"scomx_encode_read_user_info_value", prepare_ctx, run_encode_user_info_value},
+    {"scomx_encode_read_request_frame", prepare_ctx, run_encode_read_request_frame},
+    {"scomx_decode_frame", prepare_ctx, run_decode_response},
+    {"scomx_round_trip", prepare_ctx, run_round_trip},
+    {"scomx_result_float", prepare_decoded, run_result_float},
+    {"scomx_decode_typed", prepare_decoded, run_decode_typed},
+};
+
+static bench_result_t measure(const bench_case_t *bc)
+{
+    static bench_state_t st;
+    bench_result_t res = {bc->name, 0, 0};
+    unsigned long iterations = 1024;
+
+    memset(&st, 0, sizeof(st));
+    bc->prepare(&st);
+
+    for (;;) {
+        double start = now_sec();
+        for (unsigned long i = 0; i < iterations; i++) {
+            bc->run(&st);
+        }
+        double elapsed = now_sec() - start;
+
+        if (elapsed >= MIN_RUN_SEC) {
+            res.iterations = iterations;
+            res.ns_per_op = elapsed * 1e9 / iterations;
+            return res;
+        }
+        iterations *= 2;
+    }
+}
+
+// reads a file written with -j; every benchmark is on its own line
+static int load_baseline(const char *path, baseline_entry_t *entries, unsigned max_entries)
+{
+    char line[256];
+    unsigned count = 0;
+    FILE *f = fopen(path, "r");
+
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+
+    while (count < max_entries && fgets(line, sizeof(line), f)) {
+        const char *name = strstr(line, "\"name\": \"");
+        const char *ns = strstr(line, "\"ns_per_op\": ");
+
+        if (name && ns && sscanf(name + 9, "%63[^\"]", entries[count].name) == 1 && sscanf(ns + 13, "%lf", &entries[count].ns_per_op) == 1) {
+            count++;
+        }
+    }
+
+    fclose(f);
+    return (int)count;
+}
+
+static const baseline_entry_t *find_baseline(const baseline_entry_t *entries, int count, const char *name)
+{
+    for (int i = 0; i < count; i++) {
+        if (strcmp(entries[i].name, name) == 0) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+static double slowdown_pct(const bench_result_t *res, const baseline_entry_t *base) { return (res->ns_per_op - base->ns_per_op) * 100.0 / base->ns_per_op; }
+
+static void print_json(const bench_result_t *results, unsigned count)
+{
+    printf("{\n");
+    printf("  \"checksum_kernel\": \"%s\",\n", scomx_checksum_kernel_name());
+    printf("  \"benchmarks\": [\n");
+    for (unsigned i = 0; i < count; i++) {
+        printf("    {\"name\": \"%s\", \"ns_per_op\": %.2f, \"frames_per_sec\": %.0f, \"iterations\": %lu}%s\n", results[i].name, results[i].ns_per_op,
+               1e9 / results[i].ns_per_op, results[i].iterations, i + 1 < count ? "," : "");
+    }
+    printf("  ]\n");
+    printf("}\n");
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-j] [-b baseline.json] [-t threshold_pct] [filter]\n", prog);
+    fprintf(stderr, "  -j  print results as JSON, suitable as a baseline\n");
+    fprintf(stderr, "  -b  compare with a baseline and exit with 1 on a regression\n");
+    fprintf(stderr, "  -t  slowdown in percent considered a regression (default %.0f)\n", DEFAULT_THRESHOLD_PCT);
+    fprintf(stderr, "  filter  run only benchmarks whose name contains it\n");
+}
+
+int main(int argc, char **argv)
+{
+    bench_result_t results[SCOM_NBR_ELEMENTS(k_cases)];
+    baseline_entry_t baseline[MAX_BASELINE_ENTRIES];
+    int baseline_count = -1;
+    double threshold = DEFAULT_THRESHOLD_PCT;
+    const char *filter = NULL;
+    int json = 0;
+    int regressions = 0;
+    unsigned count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0) {
+            json = 1;
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            baseline_count = load_baseline(argv[++i], baseline, MAX_BASELINE_ENTRIES);
+            if (baseline_count < 0) {
+                return 2;
+            }
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            threshold = atof(argv[++i]);
+        } else if (argv[i][0] != '-' && !filter) {
+            filter = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    for (unsigned i = 0; i < SCOM_NBR_ELEMENTS(k_cases); i++) {
+        if (!filter || strstr(k_cases[i].name, filter)) {
+            results[count++] = measure(&k_cases[i]);
+        }
+    }
+
+    for (unsigned i = 0; i < count && baseline_count > 0; i++) {
+        const baseline_entry_t *base = find_baseline(baseline, baseline_count, results[i].name);
+        regressions += base && slowdown_pct(&results[i], base) > threshold;
+    }
+
+    if (json) {
+        print_json(results, count);
+    } else {
+        printf("%-35s %10s %14s", "function", "ns/op", "frames/sec");
+        if (baseline_count >= 0) {
+            printf(" %10s %8s", "baseline", "change");
+        }
+        printf("\n");
+
+        for (unsigned i = 0; i < count; i++) {
+            printf("%-35s %10.1f %14.0f", results[i].name, results[i].ns_per_op, 1e9 / results[i].ns_per_op);
+
+            const baseline_entry_t *base = baseline_count > 0 ? find_baseline(baseline, baseline_count, results[i].name) : NULL;
+            if (base) {
+                double change = slowdown_pct(&results[i], base);
+                printf(" %10.1f %+7.1f%%%s", base->ns_per_op, change, change > threshold ? " REGRESSION" : "");
+            } else if (baseline_count >= 0) {
+                printf(" %10s", "-");
+            }
+            printf("\n");
+        }
+    }
+
+    return regressions ? 1 : 0;
+}
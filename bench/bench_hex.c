@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "../scomlib_extra/scomlib_extra.h"
+
+// a log of read requests and their responses, as written by field loggers
+#define FRAME_PAIRS 4096
+#define MAX_FRAME_SIZE 64
+#define ROUNDS 200
+
+// one long run of digits, to see the kernels without the per-frame overhead
+#define BLOCK_SIZE 65536
+#define BLOCK_ROUNDS 4000
+
+static char g_frames[2 * FRAME_PAIRS][MAX_FRAME_SIZE];
+static size_t g_lengths[2 * FRAME_PAIRS];
+static char g_log[2 * FRAME_PAIRS * (2 * MAX_FRAME_SIZE + 1)];
+static size_t g_log_length;
+
+static char g_block[BLOCK_SIZE];
+static char g_block_hex[2 * BLOCK_SIZE];
+static char g_out[2 * BLOCK_SIZE];
+
+static double now_sec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void build_log()
+{
+    char buffer[256];
+    scomx_ctx_t ctx;
+    scom_frame_flags_t flags;
+
+    memset(&flags, 0, sizeof(flags));
+    scomx_ctx_init(&ctx, buffer, sizeof(buffer));
+
+    for (unsigned i = 0; i < FRAME_PAIRS; i++) {
+        uint32_t object_id = 3000 + i % 100;
+        float value = i * 0.25f;
+        char data[4];
+        scomx_enc_result_t enc[2];
+
+        memcpy(data, &value, sizeof(data));
+        enc[0] = scomx_ctx_encode_read_property(&ctx, 101, SCOM_USER_INFO_OBJECT_TYPE, object_id, 1);
+        memcpy(g_frames[2 * i], enc[0].data, enc[0].length);
+        g_lengths[2 * i] = enc[0].length;
+        enc[1] = scomx_ctx_encode_property_response(&ctx, 101, flags, SCOM_READ_PROPERTY_SERVICE, SCOM_USER_INFO_OBJECT_TYPE, object_id, 1, data, sizeof(data));
+        memcpy(g_frames[2 * i + 1], enc[1].data, enc[1].length);
+        g_lengths[2 * i + 1] = enc[1].length;
+    }
+
+    for (unsigned f = 0; f < 2 * FRAME_PAIRS; f++) {
+        scomx_hex_encode_ref(g_log + g_log_length, g_frames[f], g_lengths[f]);
+        g_log_length += 2 * g_lengths[f];
+        g_log[g_log_length++] = '\n';
+    }
+}
+
+// the usual way, each pair terminated on its own as sscanf runs strlen over its whole input
+static long decode_sscanf(char *dst, const char *src, size_t length)
+{
+    for (size_t i = 0; i + 1 < length; i += 2) {
+        char pair[3] = {src[i], src[i + 1], 0};
+        unsigned char byte;
+        if (sscanf(pair, "%2hhx", &byte) != 1) {
+            return -1;
+        }
+        dst[i / 2] = (char)byte;
+    }
+    return (long)(length / 2);
+}
+
+typedef long (*decode_fn_t)(char *dst, const char *src, size_t length);
+typedef void (*encode_fn_t)(char *dst, const char *src, size_t length);
+
+static void report(const char *name, size_t bytes, unsigned frames, double elapsed)
+{
+    printf("%-22s %10.1f %14.0f %10.1f\n", name, elapsed * 1e9 / frames, frames / elapsed, bytes / elapsed / 1e6);
+}
+
+// decodes every line of the log; returns 1 when a frame doesn't match the original
+static int bench_decode(const char *name, decode_fn_t decode, unsigned rounds)
+{
+    char frame[MAX_FRAME_SIZE];
+    size_t offset = 0;
+
+    for (unsigned f = 0; f < 2 * FRAME_PAIRS; f++) {
+        if (decode(frame, g_log + offset, 2 * g_lengths[f]) != (long)g_lengths[f] || memcmp(frame, g_frames[f], g_lengths[f]) != 0) {
+            printf("%s: frame %u decoded wrong\n", name, f);
+            return 1;
+        }
+        offset += 2 * g_lengths[f] + 1;
+    }
+
+    double start = now_sec();
+    for (unsigned r = 0; r < rounds; r++) {
+        offset = 0;
+        for (unsigned f = 0; f < 2 * FRAME_PAIRS; f++) {
+            decode(frame, g_log + offset, 2 * g_lengths[f]);
+            offset += 2 * g_lengths[f] + 1;
+        }
+    }
+    report(name, (size_t)rounds * g_log_length, rounds * 2 * FRAME_PAIRS, now_sec() - start);
+
+    return 0;
+}
+
+static int bench_encode(const char *name, encode_fn_t encode)
+{
+    char line[2 * MAX_FRAME_SIZE];
+    size_t offset = 0;
+
+    for (unsigned f = 0; f < 2 * FRAME_PAIRS; f++) {
+        encode(line, g_frames[f], g_lengths[f]);
+        if (memcmp(line, g_log + offset, 2 * g_lengths[f]) != 0) {
+            printf("%s: frame %u encoded wrong\n", name, f);
+            return 1;
+        }
+        offset += 2 * g_lengths[f] + 1;
+    }
+
+    double start = now_sec();
+    for (unsigned r = 0; r < ROUNDS; r++) {
+        for (unsigned f = 0; f < 2 * FRAME_PAIRS; f++) {
+            encode(line, g_frames[f], g_lengths[f]);
+        }
+    }
+    report(name, (size_t)ROUNDS * g_log_length, ROUNDS * 2 * FRAME_PAIRS, now_sec() - start);
+
+    return 0;
+}
+
+// the whole log decoder: line splitting, hex decoding, frame and value decoding
+static int bench_hexlog()
+{
+    char frame[MAX_FRAME_SIZE];
+    scomx_hexlog_t log;
+    scomx_hexlog_record_t rec;
+    double sum = 0;
+
+    double start = now_sec();
+    for (unsigned r = 0; r < ROUNDS; r++) {
+        scomx_hexlog_init(&log, g_log, g_log_length, frame, sizeof(frame));
+        while (scomx_hexlog_next(&log, &rec)) {
+            if (rec.result.error != SCOM_ERROR_NO_ERROR) {
+                printf("scomx_hexlog_next: line %lu: %s\n", rec.line, scomx_err2str(rec.result.error));
+                return 1;
+            }
+            sum += rec.value.value;
+        }
+        if (log.records != 2 * FRAME_PAIRS || log.invalid_lines != 0) {
+            printf("scomx_hexlog_next: %lu records, %lu invalid lines\n", log.records, log.invalid_lines);
+            return 1;
+        }
+    }
+    report("scomx_hexlog_next", (size_t)ROUNDS * g_log_length, ROUNDS * 2 * FRAME_PAIRS, now_sec() - start);
+    (void)sum;
+
+    return 0;
+}
+
+static int bench_block(const char *name, decode_fn_t decode, encode_fn_t encode)
+{
+    if (decode) {
+        if (decode(g_out, g_block_hex, sizeof(g_block_hex)) != BLOCK_SIZE || memcmp(g_out, g_block, BLOCK_SIZE) != 0) {
+            printf("%s: block decoded wrong\n", name);
+            return 1;
+        }
+    } else {
+        encode(g_out, g_block, BLOCK_SIZE);
+        if (memcmp(g_out, g_block_hex, sizeof(g_block_hex)) != 0) {
+            printf("%s: block encoded wrong\n", name);
+            return 1;
+        }
+    }
+
+    double start = now_sec();
+    for (unsigned r = 0; r < BLOCK_ROUNDS; r++) {
+        if (decode) {
+            decode(g_out, g_block_hex, sizeof(g_block_hex));
+        } else {
+            encode(g_out, g_block, BLOCK_SIZE);
+        }
+    }
+    double elapsed = now_sec() - start;
+    printf("%-22s %10.1f MB/s of text\n", name, (double)BLOCK_ROUNDS * sizeof(g_block_hex) / elapsed / 1e6);
+
+    return 0;
+}
+
+int main()
+{
+    build_log();
+    for (size_t i = 0; i < BLOCK_SIZE; i++) {
+        g_block[i] = (char)(i * 7 + (i >> 8));
+    }
+    scomx_hex_encode_ref(g_block_hex, g_block, BLOCK_SIZE);
+
+    printf("kernel: %s, %u frames, %zu bytes of text\n", scomx_hex_kernel_name(), 2 * FRAME_PAIRS, g_log_length);
+    printf("%-22s %10s %14s %10s\n", "function", "ns/frame", "frames/s", "MB/s");
+
+    if (bench_decode("sscanf %2hhx", decode_sscanf, ROUNDS / 20) || bench_decode("scomx_hex_decode_ref", scomx_hex_decode_ref, ROUNDS) ||
+        bench_decode("scomx_hex_decode", scomx_hex_decode, ROUNDS) || bench_encode("scomx_hex_encode_ref", scomx_hex_encode_ref) ||
+        bench_encode("scomx_hex_encode", scomx_hex_encode) || bench_hexlog()) {
+        return 1;
+    }
+
+    printf("\n%u KiB blocks:\n", BLOCK_SIZE / 1024);
+    if (bench_block("scomx_hex_decode_ref", scomx_hex_decode_ref, NULL) || bench_block("scomx_hex_decode", scomx_hex_decode, NULL) ||
+        bench_block("scomx_hex_encode_ref", NULL, scomx_hex_encode_ref) || bench_block("scomx_hex_encode", NULL, scomx_hex_encode)) {
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,167 @@
+// Contention of the sample history: one producer pushing as fast as it can while 0 to 4 consumer
+// threads copy the samples, compared with the same ring protected by a mutex. The consumers can't
+// keep up with a producer running flat out, so most samples are lost; what is measured is the cost
+// they add to the producer, and the run fails when a torn or reordered sample is ever copied.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../scomlib_extra/scomlib_extra.h"
+
+#define CAPACITY 1024
+#define PUSHES 20000000u
+#define MAX_READERS 4
+
+// samples copied per read call
+#define READ_BATCH 64
+
+static const unsigned k_reader_counts[] = {0, 1, 2, 4};
+
+typedef enum { RING_SEQLOCK, RING_MUTEX } ring_kind_t;
+
+static const char *k_ring_names[] = {"scomx_history", "mutex ring"};
+
+// the same ring, locked
+typedef struct {
+    pthread_mutex_t lock;
+    scomx_sample_t samples[CAPACITY];
+    uint32_t head;
+} mutex_ring_t;
+
+typedef struct {
+    pthread_t thread;
+    unsigned long samples;
+    unsigned long lost;
+    unsigned long reads;
+    unsigned long torn;
+} reader_t;
+
+static scomx_history_slot_t g_slots[CAPACITY];
+static scomx_history_t g_history;
+static mutex_ring_t g_mutex_ring;
+static ring_kind_t g_kind;
+static volatile int g_done;
+
+static double now_sec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void mutex_push(int64_t timestamp_ms, float value, scom_error_t error)
+{
+    pthread_mutex_lock(&g_mutex_ring.lock);
+    scomx_sample_t *s = &g_mutex_ring.samples[g_mutex_ring.head % CAPACITY];
+    s->timestamp_ms = timestamp_ms;
+    s->value = value;
+    s->error = error;
+    g_mutex_ring.head++;
+    pthread_mutex_unlock(&g_mutex_ring.lock);
+}
+
+static size_t mutex_read(uint32_t *cursor, scomx_sample_t *samples, size_t max, uint32_t *lost)
+{
+    size_t count = 0;
+
+    pthread_mutex_lock(&g_mutex_ring.lock);
+    uint32_t head = g_mutex_ring.head;
+    uint32_t n = *cursor;
+    *lost = 0;
+    if (head - n > CAPACITY) {
+        *lost = head - n - CAPACITY;
+        n = head - CAPACITY;
+    }
+    for (; n != head && count < max; n++) {
+        samples[count++] = g_mutex_ring.samples[n % CAPACITY];
+    }
+    pthread_mutex_unlock(&g_mutex_ring.lock);
+
+    *cursor = n;
+    return count;
+}
+
+// the producer pushes sample n with timestamp n and value n, so that a consumer can tell torn or reordered samples
+static void *read_loop(void *arg)
+{
+    reader_t *r = (reader_t *)arg;
+    scomx_sample_t samples[READ_BATCH];
+    uint32_t cursor = 0;
+    int64_t last = -1;
+
+    while (!g_done) {
+        uint32_t lost;
+        size_t count = g_kind == RING_SEQLOCK ? scomx_history_read(&g_history, &cursor, samples, READ_BATCH, &lost)
+                                              : mutex_read(&cursor, samples, READ_BATCH, &lost);
+
+        for (size_t i = 0; i < count; i++) {
+            if (samples[i].timestamp_ms <= last || samples[i].value != (float)(samples[i].timestamp_ms & 0xFFFFF)) {
+                r->torn++;
+            }
+            last = samples[i].timestamp_ms;
+        }
+        r->samples += count;
+        r->lost += lost;
+        r->reads++;
+    }
+
+    return NULL;
+}
+
+int main()
+{
+    reader_t readers[MAX_READERS];
+    int failed = 0;
+
+    pthread_mutex_init(&g_mutex_ring.lock, NULL);
+
+    printf("%-15s %8s %12s %14s %12s %12s\n", "ring", "readers", "push ns/op", "samples read/s", "lost %", "torn");
+
+    for (ring_kind_t kind = RING_SEQLOCK; kind <= RING_MUTEX; kind++) {
+        for (size_t c = 0; c < SCOM_NBR_ELEMENTS(k_reader_counts); c++) {
+            unsigned reader_count = k_reader_counts[c];
+
+            scomx_history_init(&g_history, g_slots, CAPACITY);
+            g_mutex_ring.head = 0;
+            g_kind = kind;
+            g_done = 0;
+            memset(readers, 0, sizeof(readers));
+
+            for (unsigned i = 0; i < reader_count; i++) {
+                pthread_create(&readers[i].thread, NULL, read_loop, &readers[i]);
+            }
+
+            double start = now_sec();
+            for (uint32_t n = 0; n < PUSHES; n++) {
+                if (kind == RING_SEQLOCK) {
+                    scomx_history_push(&g_history, n, (float)(n & 0xFFFFF), SCOM_ERROR_NO_ERROR);
+                } else {
+                    mutex_push(n, (float)(n & 0xFFFFF), SCOM_ERROR_NO_ERROR);
+                }
+            }
+            double elapsed = now_sec() - start;
+            g_done = 1;
+
+            unsigned long samples = 0, lost = 0, torn = 0;
+            for (unsigned i = 0; i < reader_count; i++) {
+                pthread_join(readers[i].thread, NULL);
+                samples += readers[i].samples;
+                lost += readers[i].lost;
+                torn += readers[i].torn;
+            }
+
+            printf("%-15s %8u %12.1f %14.0f %12.1f %12lu\n", k_ring_names[kind], reader_count, elapsed * 1e9 / PUSHES, samples / elapsed,
+                   samples + lost ? lost * 100.0 / (samples + lost) : 0.0, torn);
+            failed |= torn > 0;
+        }
+    }
+
+    if (failed) {
+        printf("torn samples were read\n");
+    }
+
+    return failed ? 1 : 0;
+}
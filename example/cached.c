@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <termios.h> // for baud rate constant
+
+#include "gateway_cache.h"
+
+// consumers asking for overlapping values at their own rates, as a dashboard, a battery controller
+// and a logger running in the same process do
+typedef struct {
+    const char *name;
+    uint32_t interval_ms;
+    const scomx_user_info_object_t *objects;
+    unsigned object_count;
+
+    int64_t next_ms;
+    unsigned outstanding;
+    unsigned long values;
+    unsigned long errors;
+} consumer_t;
+
+static const scomx_user_info_object_t k_dashboard[] = {SCOMX_INFO_XTENDER_OUT_ACTIVE_POWER, SCOMX_INFO_XTENDER_BATT_VOLTAGE, SCOMX_INFO_XTENDER_IN_AC_VOLT,
+                                                       SCOMX_INFO_XTENDER_OPERATING_STATE};
+static const scomx_user_info_object_t k_controller[] = {SCOMX_INFO_XTENDER_BATT_VOLTAGE, SCOMX_INFO_XTENDER_BATT_CHARGE_CURR, SCOMX_INFO_XTENDER_OUT_ACTIVE_POWER};
+static const scomx_user_info_object_t k_logger[] = {SCOMX_INFO_XTENDER_BATT_VOLTAGE, SCOMX_INFO_XTENDER_OUT_ACTIVE_POWER, SCOMX_INFO_XTENDER_IN_AC_VOLT,
+                                                    SCOMX_INFO_XTENDER_OENERG_CURR_DAY};
+
+static consumer_t g_consumers[] = {
+    {"dashboard", 1000, k_dashboard, SCOM_NBR_ELEMENTS(k_dashboard), 0, 0, 0, 0},
+    {"controller", 500, k_controller, SCOM_NBR_ELEMENTS(k_controller), 0, 0, 0, 0},
+    {"logger", 5000, k_logger, SCOM_NBR_ELEMENTS(k_logger), 0, 0, 0, 0},
+};
+
+static gateway_port_t g_port;
+static gateway_cache_t g_cache;
+
+static void on_value(gateway_port_t *port, const scomx_dec_result_t *res, void *user)
+{
+    consumer_t *consumer = (consumer_t *)user;
+
+    (void)port;
+    consumer->outstanding--;
+    if (res->error == SCOM_ERROR_NO_ERROR) {
+        consumer->values++;
+    } else {
+        consumer->errors++;
+    }
+}
+
+// parameters may have been changed on the RCC, so cached ones are read again
+static void on_flags(void *user, uint8_t raised, uint8_t cleared, uint8_t flags)
+{
+    (void)cleared;
+    (void)flags;
+
+    if (raised & SCOMX_FLAG_RCC_RESET) {
+        scomx_cache_invalidate_type(&((gateway_cache_t *)user)->cache, SCOM_PARAMETER_OBJECT_TYPE);
+    }
+}
+
+static void poll_consumer(consumer_t *consumer, int64_t now)
+{
+    if (now < consumer->next_ms || consumer->outstanding > 0) {
+        return;
+    }
+
+    consumer->next_ms = now + consumer->interval_ms;
+    for (unsigned i = 0; i < consumer->object_count; i++) {
+        consumer->outstanding++;
+        if (gateway_read_cached(&g_cache, &g_port, SCOMX_DEST_XTM(0), SCOM_USER_INFO_OBJECT_TYPE, consumer->objects[i], SCOMX_PROP_USER_INFO_VALUE, on_value,
+                                consumer) != 0) {
+            consumer->outstanding--;
+            consumer->errors++;
+        }
+    }
+}
+
+int main(int argc, const char *argv[])
+{
+    gateway_loop_t loop;
+
+    if (argc < 3) {
+        printf("Usage: %s <seconds> <port>\n", argv[0]);
+        return 1;
+    }
+
+    int seconds = atoi(argv[1]);
+
+    if (gateway_loop_init(&loop) != 0) {
+        perror("epoll");
+        return 1;
+    }
+    if (serial_open(&g_port.serial, argv[2], B38400, PARITY_EVEN, 1) != 0 || gateway_loop_add_port(&loop, &g_port) != 0) {
+        return 1;
+    }
+
+    // power values are served for a fraction of the fastest consumer interval, counters for longer
+    gateway_cache_init(&g_cache, 400);
+    scomx_cache_set_ttl(&g_cache.cache, SCOMX_DEST_XTM(0), SCOM_USER_INFO_OBJECT_TYPE, SCOMX_INFO_XTENDER_OENERG_CURR_DAY, SCOMX_PROP_USER_INFO_VALUE, 60000);
+
+    scomx_flags_watch_init(&g_port.flags, SCOMX_FLAG_RCC_RESET, on_flags, &g_cache);
+
+    int64_t start = serial_now_ms();
+    int64_t end = start + seconds * 1000;
+    int64_t now;
+    while ((now = serial_now_ms()) < end && !g_port.failed) {
+        int64_t wake = end;
+
+        for (unsigned i = 0; i < SCOM_NBR_ELEMENTS(g_consumers); i++) {
+            poll_consumer(&g_consumers[i], now);
+            // a consumer still waiting for its reads is polled again when they complete
+            if (g_consumers[i].outstanding == 0 && g_consumers[i].next_ms < wake) {
+                wake = g_consumers[i].next_ms;
+            }
+        }
+
+        gateway_loop_run_once(&loop, wake > now ? (int)(wake - now) : 0);
+    }
+
+    unsigned long values = 0;
+    for (unsigned i = 0; i < SCOM_NBR_ELEMENTS(g_consumers); i++) {
+        printf("%-10s %6lu values %4lu errors\n", g_consumers[i].name, g_consumers[i].values, g_consumers[i].errors);
+        values += g_consumers[i].values;
+    }
+
+    const scomx_cache_t *cache = &g_cache.cache;
+    printf("%lu values from %lu reads on the wire (%lu hits, %lu misses, %lu coalesced)\n", values, g_cache.reads, cache->hits, cache->misses, cache->coalesced);
+
+    serial_close(&g_port.serial);
+    gateway_loop_close(&loop);
+
+    return 0;
+}
@@ -0,0 +1,228 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <termios.h> // for baud rate constant
+
+#include "gateway_coro.hpp"
+
+// values read round-robin by every reader
+static const scomx_user_info_object_t k_objects[] = {
+    SCOMX_INFO_XTENDER_BATT_VOLTAGE, SCOMX_INFO_XTENDER_OUT_AC_POWER, SCOMX_INFO_XTENDER_OUT_ACTIVE_POWER,
+    SCOMX_INFO_XTENDER_IN_AC_VOLT,   SCOMX_INFO_XTENDER_IN_AC_CURR,   SCOMX_INFO_XTENDER_OPERATING_STATE,
+};
+
+// reads give up after this long, including the time waiting for their turn on the port
+#define READ_TIMEOUT_MS 30000
+
+// the input current limit is set this often by the control loop, alternating between two values
+#define CONTROL_PERIOD_MS 1000
+#define CONTROL_TIMEOUT_MS 5000
+
+typedef struct {
+    unsigned long ok;
+    unsigned long failed;
+    unsigned long cancelled;
+} read_stats_t;
+
+typedef struct {
+    unsigned long ok;
+    unsigned long failed;
+    int64_t total_ms;
+    int64_t max_ms;
+} write_stats_t;
+
+static gateway_port_t g_ports[GATEWAY_MAX_PORTS];
+static read_stats_t g_stats[GATEWAY_MAX_PORTS];
+static write_stats_t g_write_stats[GATEWAY_MAX_PORTS];
+static unsigned g_tasks_running;
+static unsigned g_in_flight;
+static unsigned g_max_in_flight;
+
+// one logical reader; many of them share a port and wait for their turn in the client
+static gateway::task read_loop(gateway::client &client, read_stats_t &stats, unsigned first, std::stop_token stop)
+{
+    g_tasks_running++;
+
+    for (unsigned i = first; !stop.stop_requested(); i++) {
+        g_in_flight++;
+        if (g_in_flight > g_max_in_flight) {
+            g_max_in_flight = g_in_flight;
+        }
+
+        gateway::request_result r = co_await client.read_user_info(SCOMX_DEST_XTM(0), k_objects[i % SCOM_NBR_ELEMENTS(k_objects)], stop, READ_TIMEOUT_MS);
+
+        g_in_flight--;
+        if (r) {
+            stats.ok++;
+        } else if (r.cancelled) {
+            stats.cancelled++;
+        } else {
+            stats.failed++;
+        }
+    }
+
+    g_tasks_running--;
+}
+
+// control logic writing a parameter while the readers keep the port busy; the writes go ahead of
+// the queued reads, so their latency stays close to one request on the wire
+static gateway::task control_loop(gateway::scheduler &sched, gateway::client &client, write_stats_t &stats, std::stop_token stop)
+{
+    g_tasks_running++;
+
+    for (unsigned i = 0; !stop.stop_requested(); i++) {
+        co_await sched.sleep(CONTROL_PERIOD_MS);
+        if (stop.stop_requested()) {
+            break;
+        }
+
+        int64_t start = sched.now_ms();
+        gateway::request_result r =
+            co_await client.write_parameter(SCOMX_DEST_XTM(0), SCOMX_PARAM_XTENDER_AC_IN_CURRENT_MAX, i % 2 ? 16.0f : 10.0f, stop, CONTROL_TIMEOUT_MS);
+        int64_t latency = sched.now_ms() - start;
+
+        if (r) {
+            stats.ok++;
+            stats.total_ms += latency;
+            if (latency > stats.max_ms) {
+                stats.max_ms = latency;
+            }
+        } else if (!r.cancelled) {
+            stats.failed++;
+        }
+    }
+
+    g_tasks_running--;
+}
+
+// other I/O handled by the same thread: a line "q" on stdin stops the reads
+static gateway::task read_stdin(gateway::scheduler &sched, std::stop_source &stop)
+{
+    char line[128];
+
+    g_tasks_running++;
+
+    while (!stop.stop_requested()) {
+        // checks for the stop now and then
+        int ready = co_await sched.readable(STDIN_FILENO, 200);
+        if (ready < 0) {
+            break;
+        } else if (ready == 0) {
+            continue;
+        }
+
+        ssize_t n = read(STDIN_FILENO, line, sizeof(line) - 1);
+        if (n <= 0) {
+            break;
+        }
+        if (line[0] == 'q') {
+            stop.request_stop();
+        }
+    }
+
+    g_tasks_running--;
+}
+
+static gateway::task report(gateway::scheduler &sched, unsigned port_count, std::stop_token stop)
+{
+    unsigned long last = 0;
+
+    g_tasks_running++;
+
+    while (!stop.stop_requested()) {
+        co_await sched.sleep(1000);
+
+        unsigned long ok = 0;
+        for (unsigned i = 0; i < port_count; i++) {
+            ok += g_stats[i].ok;
+        }
+        printf("%lu reads/s, %u reads in flight\n", ok - last, g_in_flight);
+        last = ok;
+    }
+
+    g_tasks_running--;
+}
+
+int main(int argc, const char *argv[])
+{
+    gateway_loop_t loop;
+    unsigned readers = 100;
+    int arg = 1;
+
+    if (argc > 2 && strcmp(argv[1], "-n") == 0) {
+        readers = atoi(argv[2]);
+        arg = 3;
+    }
+    if (argc - arg < 2) {
+        printf("Usage: %s [-n readers per port] <seconds> <port> [port...]\n", argv[0]);
+        return 1;
+    }
+
+    int seconds = atoi(argv[arg]);
+    unsigned port_count = argc - arg - 1;
+    if (port_count > GATEWAY_MAX_PORTS) {
+        port_count = GATEWAY_MAX_PORTS;
+    }
+
+    if (gateway_loop_init(&loop) != 0) {
+        perror("epoll");
+        return 1;
+    }
+
+    gateway::scheduler sched(loop);
+    std::vector<std::unique_ptr<gateway::client>> clients;
+    std::stop_source stop;
+
+    for (unsigned i = 0; i < port_count; i++) {
+        if (serial_open(&g_ports[i].serial, argv[arg + 1 + i], B38400, PARITY_EVEN, 1) != 0 || gateway_loop_add_port(&loop, &g_ports[i]) != 0) {
+            return 1;
+        }
+        clients.push_back(std::make_unique<gateway::client>(sched, g_ports[i]));
+    }
+
+    for (unsigned i = 0; i < port_count; i++) {
+        for (unsigned r = 0; r < readers; r++) {
+            read_loop(*clients[i], g_stats[i], r, stop.get_token());
+        }
+        control_loop(sched, *clients[i], g_write_stats[i], stop.get_token());
+    }
+    read_stdin(sched, stop);
+    report(sched, port_count, stop.get_token());
+
+    int64_t end = sched.now_ms() + seconds * 1000;
+    while (!stop.stop_requested()) {
+        int64_t now = sched.now_ms();
+        if (now >= end) {
+            // cancels the reads still waiting or in flight
+            stop.request_stop();
+            break;
+        }
+        sched.run_once((int)(end - now));
+    }
+
+    // let the cancelled reads and the other tasks return
+    while (g_tasks_running > 0) {
+        sched.run_once(100);
+    }
+
+    printf("%-20s %8s %8s %10s %10s\n", "port", "ok", "failed", "cancelled", "timeouts");
+    for (unsigned i = 0; i < port_count; i++) {
+        printf("%-20s %8lu %8lu %10lu %10lu\n", argv[arg + 1 + i], g_stats[i].ok, g_stats[i].failed, g_stats[i].cancelled, g_ports[i].timeouts);
+    }
+    printf("%u readers per port, at most %u reads in flight\n", readers, g_max_in_flight);
+
+    printf("\n%-20s %8s %8s %12s %12s\n", "port", "writes", "failed", "avg ms", "max ms");
+    for (unsigned i = 0; i < port_count; i++) {
+        const write_stats_t *w = &g_write_stats[i];
+        printf("%-20s %8lu %8lu %12.1f %12lld\n", argv[arg + 1 + i], w->ok, w->failed, w->ok ? (double)w->total_ms / w->ok : 0.0, (long long)w->max_ms);
+    }
+
+    clients.clear();
+    for (unsigned i = 0; i < port_count; i++) {
+        serial_close(&g_ports[i].serial);
+    }
+    gateway_loop_close(&loop);
+
+    return 0;
+}
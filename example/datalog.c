@@ -0,0 +1,145 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <termios.h> // for baud rate constant
+#include <unistd.h>
+
+#include "serial_transport.h"
+
+#define MAX_FILES 1024
+
+typedef struct {
+    int fd;
+    uint32_t written;
+} output_t;
+
+static serial_port_t g_port;
+static char g_rxbuf[SCOMX_DATALOG_BUFFER_SIZE];
+static uint32_t g_file_ids[MAX_FILES];
+static volatile sig_atomic_t g_interrupted;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    g_interrupted = 1;
+}
+
+// blocks go straight to the file, so only the receive buffer is held in memory
+static int write_block(void *user, const char *data, size_t length)
+{
+    output_t *out = (output_t *)user;
+
+    if (g_interrupted) {
+        return -1;
+    }
+
+    while (length > 0) {
+        ssize_t ret = write(out->fd, data, length);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        } else if (ret <= 0) {
+            perror("write");
+            return -1;
+        }
+        data += ret;
+        length -= ret;
+        out->written += ret;
+    }
+
+    return 0;
+}
+
+// downloads a file into <dir>/LGxxxxxx.CSV; the bytes received so far are kept in a .part file
+// whose size is the offset to resume from
+static int download(scomx_datalog_t *dl, const char *dir, uint32_t file_id)
+{
+    char path[512], part_path[520];
+    struct stat st;
+    output_t out = {-1, 0};
+
+    snprintf(path, sizeof(path), "%s/LG%06u.CSV", dir, file_id);
+    snprintf(part_path, sizeof(part_path), "%s.part", path);
+
+    if (stat(path, &st) == 0) {
+        printf("%s: already downloaded\n", path);
+        return 0;
+    }
+
+    out.fd = open(part_path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (out.fd < 0 || fstat(out.fd, &st) != 0) {
+        perror(part_path);
+        return -1;
+    }
+    uint32_t skip = (uint32_t)st.st_size;
+
+    uint64_t received_before = dl->bytes_received;
+    int64_t start = serial_now_ms();
+    scom_error_t error = scomx_datalog_fetch(dl, file_id, skip, write_block, &out);
+    double elapsed = (serial_now_ms() - start) / 1000.0;
+    uint64_t received = dl->bytes_received - received_before;
+
+    close(out.fd);
+
+    if (error != SCOM_ERROR_NO_ERROR) {
+        const char *reason = g_interrupted ? "interrupted" : dl->sink_refused ? "write failed" : scomx_err2str(error);
+        printf("%s: %s after %u bytes, run again to resume\n", path, reason, skip + out.written);
+        return -1;
+    }
+    if (rename(part_path, path) != 0) {
+        perror(path);
+        return -1;
+    }
+
+    printf("%s: %u bytes (%u resumed) in %.1f s, %.0f bytes/s\n", path, dl->file_size, skip, elapsed, elapsed > 0 ? received / elapsed : 0);
+    return 0;
+}
+
+int main(int argc, const char *argv[])
+{
+    scomx_transport_t transport;
+    scomx_datalog_t dl;
+    size_t count = 0;
+    int failed = 0;
+
+    if (argc < 3) {
+        printf("Usage: %s <port> <directory>\n", argv[0]);
+        return 1;
+    }
+
+    if (serial_open(&g_port, argv[1], B38400, PARITY_EVEN, 1) != 0) {
+        return 1;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    serial_transport_init(&transport, &g_port, SCOMX_DATALOG_BUFFER_SIZE);
+    scomx_datalog_init(&dl, &transport, SCOMX_DEST_232(0), g_rxbuf, sizeof(g_rxbuf));
+
+    scom_error_t error = scomx_datalog_list(&dl, g_file_ids, MAX_FILES, &count);
+    if (error != SCOM_ERROR_NO_ERROR) {
+        printf("Reading the file list failed: %s\n", scomx_err2str(error));
+        serial_close(&g_port);
+        return 1;
+    }
+    printf("%zu datalog files\n", count);
+
+    int64_t start = serial_now_ms();
+    for (size_t i = 0; i < count && !g_interrupted; i++) {
+        failed |= download(&dl, argv[2], g_file_ids[i]) != 0;
+    }
+    double elapsed = (serial_now_ms() - start) / 1000.0;
+
+    // 11 bits per byte with 8E1
+    double line_rate = g_port.baud / 11.0;
+    double throughput = elapsed > 0 ? dl.bytes_received / elapsed : 0;
+    printf("%llu bytes in %lu blocks (%lu repeated) in %.1f s: %.0f bytes/s, %.0f%% of the line rate\n", (unsigned long long)dl.bytes_received,
+           dl.blocks_received, dl.blocks_repeated, elapsed, throughput, line_rate > 0 ? throughput * 100 / line_rate : 0);
+
+    serial_close(&g_port);
+
+    return failed || g_interrupted ? 1 : 0;
+}
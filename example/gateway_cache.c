@@ -0,0 +1,148 @@
+#include "gateway_cache.h"
+
+#include <string.h>
+
+static gateway_waiter_t *alloc_waiter(gateway_cache_t *gc, gateway_callback_t callback, void *user)
+{
+    gateway_waiter_t *w = gc->free_waiters;
+
+    if (w) {
+        gc->free_waiters = w->next;
+        w->callback = callback;
+        w->user = user;
+        w->next = NULL;
+    }
+
+    return w;
+}
+
+static void free_waiter(gateway_cache_t *gc, gateway_waiter_t *w)
+{
+    w->next = gc->free_waiters;
+    gc->free_waiters = w;
+}
+
+// the pending timeout of the entry runs from when its read left the interactive lane, not while the
+// read waits behind others or for a retry
+static void on_sent(gateway_port_t *port, void *user)
+{
+    gateway_waiter_t *w = (gateway_waiter_t *)user;
+
+    (void)port;
+    if (w->entry->waiters == w) {
+        scomx_cache_sent(&w->gc->cache, w->entry, serial_now_ms());
+    }
+}
+
+// gateway callback of the single read done for the waiters chained to its waiter w
+static void on_read(gateway_port_t *port, const scomx_dec_result_t *res, void *user)
+{
+    gateway_waiter_t *w = (gateway_waiter_t *)user;
+    gateway_cache_t *gc = w->gc;
+    scomx_cache_entry_t *entry = w->entry;
+    scomx_dec_result_t result = *res;
+
+    // a read outlived by the pending timeout was issued again, and the entry now belongs to the newer
+    // read: the late one only answers its own waiters
+    if (entry->waiters == w) {
+        // detached first, as the callbacks may read again
+        entry->waiters = NULL;
+
+        scomx_cache_store(&gc->cache, entry, res, serial_now_ms());
+        if (res->error == SCOM_ERROR_NO_ERROR) {
+            result = scomx_cache_result(entry);
+        }
+    }
+
+    while (w) {
+        gateway_waiter_t *next = w->next;
+        gateway_callback_t callback = w->callback;
+        void *cb_user = w->user;
+
+        free_waiter(gc, w);
+        if (callback) {
+            callback(port, &result, cb_user);
+        }
+        w = next;
+    }
+}
+
+void gateway_cache_init(gateway_cache_t *gc, uint32_t default_ttl_ms)
+{
+    memset(gc, 0, sizeof(*gc));
+
+    scomx_cache_init(&gc->cache, gc->entries, GATEWAY_CACHE_SIZE, default_ttl_ms);
+
+    for (unsigned i = 0; i < GATEWAY_CACHE_WAITERS; i++) {
+        gc->waiters[i].gc = gc;
+        free_waiter(gc, &gc->waiters[i]);
+    }
+}
+
+int gateway_read_cached(gateway_cache_t *gc, gateway_port_t *port, uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id,
+                        gateway_callback_t callback, void *user)
+{
+    scomx_cache_lookup_t lookup = scomx_cache_lookup(&gc->cache, dst_addr, object_type, object_id, property_id, serial_now_ms());
+    scomx_cache_entry_t *entry = lookup.entry;
+
+    if (lookup.status == SCOMX_CACHE_HIT) {
+        if (callback) {
+            callback(port, &lookup.result, user);
+        }
+        return 0;
+    }
+
+    if (lookup.status == SCOMX_CACHE_WAIT) {
+        gateway_waiter_t *w = alloc_waiter(gc, callback, user);
+        gateway_waiter_t *head = (gateway_waiter_t *)entry->waiters;
+
+        if (!w || !head) {
+            if (w) {
+                free_waiter(gc, w);
+            }
+            return -1;
+        }
+
+        // the head is the user of the read in flight, so it stays first
+        w->next = head->next;
+        head->next = w;
+        return 0;
+    }
+
+    scomx_enc_result_t enc = scomx_ctx_encode_read_property(&port->ctx, dst_addr, object_type, object_id, property_id);
+    if (enc.error != SCOM_ERROR_NO_ERROR) {
+        scomx_dec_result_t failed;
+        memset(&failed, 0, sizeof(failed));
+        failed.error = enc.error;
+        scomx_cache_store(&gc->cache, entry, &failed, serial_now_ms());
+        return -1;
+    }
+
+    // the table is full, read without caching
+    if (!entry) {
+        gc->reads++;
+        return gateway_submit_lane(port, GATEWAY_LANE_INTERACTIVE, enc.data, enc.length, callback, user);
+    }
+
+    gateway_waiter_t *w = alloc_waiter(gc, callback, user);
+    if (w) {
+        w->entry = entry;
+    }
+
+    if (!w || gateway_submit_tracked(port, GATEWAY_LANE_INTERACTIVE, enc.data, enc.length, on_read, on_sent, w) != 0) {
+        scomx_dec_result_t failed;
+        memset(&failed, 0, sizeof(failed));
+        failed.error = SCOM_ERROR_STACK_BUFFER_TOO_SMALL;
+        scomx_cache_store(&gc->cache, entry, &failed, serial_now_ms());
+        if (w) {
+            free_waiter(gc, w);
+        }
+        return -1;
+    }
+
+    entry->waiters = w;
+    scomx_cache_queued(&gc->cache, entry);
+    gc->reads++;
+
+    return 0;
+}
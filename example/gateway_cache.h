@@ -0,0 +1,50 @@
+#ifndef GATEWAY_CACHE_H
+#define GATEWAY_CACHE_H
+
+#include "gateway_loop.h"
+
+// Read-through value cache in front of the gateway ports.
+//
+// Several consumers can ask for the same values; fresh values are returned from the cache right away
+// and simultaneous requests of a value which is not cached wait for a single read on the wire. The
+// callback of every consumer is called with the decoded response or the read error, from within
+// gateway_read_cached on a hit and from the event loop otherwise.
+//
+// Reads on the wire are consumer requests, sent in the interactive lane ahead of background polling.
+// The pending timeout of the cache runs from when a read is sent; a read outliving it is issued again,
+// and the late response then only goes to the consumers which waited for it.
+
+#define GATEWAY_CACHE_SIZE 256
+#define GATEWAY_CACHE_WAITERS 128
+
+struct gateway_cache;
+
+typedef struct gateway_waiter {
+    gateway_callback_t callback;
+    void *user;
+    struct gateway_waiter *next;
+
+    struct gateway_cache *gc;
+    // entry whose read the waiter waits for
+    scomx_cache_entry_t *entry;
+} gateway_waiter_t;
+
+typedef struct gateway_cache {
+    scomx_cache_t cache;
+    scomx_cache_entry_t entries[GATEWAY_CACHE_SIZE];
+
+    gateway_waiter_t waiters[GATEWAY_CACHE_WAITERS];
+    gateway_waiter_t *free_waiters;
+
+    // requests submitted to the ports
+    unsigned long reads;
+} gateway_cache_t;
+
+// initialize the cache with the TTL of values without their own (see scomx_cache_set_ttl on cache)
+void gateway_cache_init(gateway_cache_t *gc, uint32_t default_ttl_ms);
+
+// get a property value, reading it on the port when it isn't cached; returns -1 when the request can't be queued
+int gateway_read_cached(gateway_cache_t *gc, gateway_port_t *port, uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id,
+                        gateway_callback_t callback, void *user);
+
+#endif
@@ -0,0 +1,554 @@
+#ifndef GATEWAY_CORO_HPP
+#define GATEWAY_CORO_HPP
+
+// Coroutine API over the gateway loop (C++20, header only).
+//
+// A scheduler nests the epoll instance of a gateway_loop_t in its own, next to timers and any other
+// file descriptors the application waits for, so polling the devices interleaves with other I/O on a
+// single thread. Reads are awaited instead of completing through callbacks:
+//
+//   gateway::task poll(gateway::scheduler &sched, gateway::client &xtender, std::stop_token stop)
+//   {
+//       while (!stop.stop_requested()) {
+//           gateway::request_result r = co_await xtender.read_user_info(SCOMX_DEST_XTM(0), SCOMX_INFO_XTENDER_BATT_VOLTAGE, stop);
+//           ...
+//           co_await sched.sleep(1000);
+//       }
+//   }
+//
+// Every port sends one request at a time, the others wait in their lane of the gateway queue and,
+// once it is full, in the client, so any number of requests can be awaited at once. A request
+// completes with the response, SCOM_ERROR_RESPONSE_TIMEOUT when its timeout expires first, or
+// cancelled when its stop token is stopped.
+//
+// Not thread safe, like the gateway loop: the scheduler, its clients and the stop sources used with
+// them belong to one thread.
+
+#include <coroutine>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <map>
+#include <optional>
+#include <stop_token>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+extern "C" {
+#include "gateway_loop.h"
+}
+
+namespace gateway {
+
+// Coroutine started right away and destroyed when it returns, for loops driven by the scheduler
+struct task {
+    struct promise_type {
+        task get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+class scheduler;
+class client;
+
+namespace detail {
+
+// deadline in the scheduler, expired by it unless disarmed first
+struct timer {
+    std::multimap<int64_t, timer *>::iterator pos;
+    bool armed = false;
+
+    virtual void expire() = 0;
+
+protected:
+    ~timer() = default;
+};
+
+} // namespace detail
+
+class scheduler {
+public:
+    explicit scheduler(gateway_loop_t &loop) : loop_(loop), epoll_fd_(epoll_create1(EPOLL_CLOEXEC))
+    {
+        struct epoll_event ev = {};
+
+        // data.ptr stays NULL for the gateway loop
+        ev.events = EPOLLIN;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, loop_.epoll_fd, &ev);
+    }
+
+    ~scheduler() { close(epoll_fd_); }
+
+    scheduler(const scheduler &) = delete;
+    scheduler &operator=(const scheduler &) = delete;
+
+    int64_t now_ms() const { return serial_now_ms(); }
+
+    // Suspends the coroutine for ms milliseconds
+    auto sleep(unsigned ms)
+    {
+        struct awaiter : detail::timer {
+            scheduler &sched;
+            unsigned ms;
+            std::coroutine_handle<> handle;
+
+            awaiter(scheduler &s, unsigned m) : sched(s), ms(m) {}
+
+            bool await_ready() const { return false; }
+            void await_suspend(std::coroutine_handle<> h)
+            {
+                handle = h;
+                sched.arm(this, sched.now_ms() + ms);
+            }
+            void await_resume() {}
+            void expire() override { sched.post(handle); }
+        };
+        return awaiter(*this, ms);
+    }
+
+    // Suspends the coroutine until fd is readable; the result is 1 when it is, 0 when timeout_ms (unless
+    // negative) elapsed first and -1 when the fd can't be waited for (e.g. a regular file)
+    auto readable(int fd, int timeout_ms = -1)
+    {
+        struct awaiter : detail::timer {
+            scheduler &sched;
+            int fd;
+            int timeout_ms;
+            int ready = 0;
+            std::coroutine_handle<> handle;
+
+            awaiter(scheduler &s, int f, int t) : sched(s), fd(f), timeout_ms(t) {}
+
+            bool await_ready() const { return false; }
+            bool await_suspend(std::coroutine_handle<> h)
+            {
+                struct epoll_event ev = {};
+
+                handle = h;
+                ev.events = EPOLLIN | EPOLLONESHOT;
+                ev.data.ptr = this;
+                if (epoll_ctl(sched.epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+                    ready = -1;
+                    return false;
+                }
+                if (timeout_ms >= 0) {
+                    sched.arm(this, sched.now_ms() + timeout_ms);
+                }
+                return true;
+            }
+            int await_resume() const { return ready; }
+
+            void on_ready()
+            {
+                ready = 1;
+                sched.disarm(this);
+                epoll_ctl(sched.epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+                sched.post(handle);
+            }
+            void expire() override
+            {
+                epoll_ctl(sched.epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+                sched.post(handle);
+            }
+        };
+        return awaiter(*this, fd, timeout_ms);
+    }
+
+    // Waits up to max_wait_ms (forever when negative) for I/O and timers, then resumes the coroutines
+    // whose reads, sleeps or file descriptors are done
+    void run_once(int max_wait_ms);
+
+    // Resumes the coroutine from run_once instead of the current call stack
+    void post(std::coroutine_handle<> handle) { ready_.push_back(handle); }
+
+    void arm(detail::timer *t, int64_t due_ms)
+    {
+        t->pos = timers_.emplace(due_ms, t);
+        t->armed = true;
+    }
+
+    void disarm(detail::timer *t)
+    {
+        if (t->armed) {
+            timers_.erase(t->pos);
+            t->armed = false;
+        }
+    }
+
+private:
+    friend class client;
+
+    gateway_loop_t &loop_;
+    int epoll_fd_;
+    std::multimap<int64_t, detail::timer *> timers_;
+    std::vector<std::coroutine_handle<>> ready_;
+    std::vector<client *> clients_;
+
+    void resume_ready()
+    {
+        // resumed coroutines may post others
+        while (!ready_.empty()) {
+            std::vector<std::coroutine_handle<>> ready;
+            ready.swap(ready_);
+            for (std::coroutine_handle<> h : ready) {
+                h.resume();
+            }
+        }
+    }
+};
+
+// completion of an awaited read or write
+struct request_result {
+    // decoded value, or the written value, or the error of the request; SCOM_ERROR_RESPONSE_TIMEOUT when cancelled
+    scomx_typed_value_t value;
+    // stopped, or a write replaced by a newer write of the same property before being sent
+    bool cancelled;
+
+    explicit operator bool() const { return !cancelled && value.error == SCOM_ERROR_NO_ERROR; }
+};
+
+class request_op : detail::timer {
+public:
+    request_op(client &c, gateway_lane_t lane, uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id,
+               std::stop_token stop, int timeout_ms)
+        : client_(c), lane_(lane), dst_addr_(dst_addr), object_type_(object_type), object_id_(object_id), property_id_(property_id), stop_(std::move(stop)),
+          timeout_ms_(timeout_ms)
+    {
+    }
+
+    // write of the data, which encodes value
+    request_op(client &c, gateway_lane_t lane, uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id,
+               const char *data, size_t length, float value, std::stop_token stop, int timeout_ms)
+        : request_op(c, lane, dst_addr, object_type, object_id, property_id, std::move(stop), timeout_ms)
+    {
+        write_length_ = length < sizeof(write_data_) ? length : sizeof(write_data_);
+        memcpy(write_data_, data, write_length_);
+        write_value_ = value;
+    }
+
+    request_op(const request_op &) = delete;
+    request_op &operator=(const request_op &) = delete;
+
+    bool await_ready() const { return stop_.stop_requested(); }
+    void await_suspend(std::coroutine_handle<> handle);
+    request_result await_resume()
+    {
+        if (state_ == state::created) {
+            // stopped before being sent
+            result_ = {{}, true};
+            result_.value.error = SCOM_ERROR_RESPONSE_TIMEOUT;
+        }
+        return result_;
+    }
+
+private:
+    friend class client;
+
+    enum class state { created, waiting, submitted, done };
+
+    struct stop_fn {
+        request_op *op;
+        void operator()() const { op->abort(true); }
+    };
+
+    client &client_;
+    gateway_lane_t lane_;
+    uint32_t dst_addr_;
+    scom_object_type_t object_type_;
+    uint32_t object_id_;
+    uint16_t property_id_;
+    std::stop_token stop_;
+    int timeout_ms_;
+
+    // value to write, a read when write_length_ is 0
+    char write_data_[SCOMX_TYPED_VALUE_SIZE] = {};
+    size_t write_length_ = 0;
+    float write_value_ = 0;
+
+    state state_ = state::created;
+    std::coroutine_handle<> handle_;
+    std::optional<std::stop_callback<stop_fn>> on_stop_;
+    request_result result_ = {};
+
+    // neighbours in the list of requests waiting for room in their lane of the gateway queue
+    request_op *prev_ = nullptr;
+    request_op *next_ = nullptr;
+
+    // hands the request to the gateway loop, or completes it with the error that prevents it; false when
+    // its lane is full and it has to wait
+    bool submit();
+    void finish();
+    void fail(scom_error_t error);
+    void abort(bool cancelled);
+    void expire() override { abort(false); }
+
+    static void on_response(gateway_port_t *port, const scomx_dec_result_t *res, void *user);
+};
+
+// Reads and writes properties of the devices behind a gateway port registered with the scheduler's
+// loop. Reads are sent in the polling lane of the port and writes in the control lane, ahead of them.
+class client {
+public:
+    client(scheduler &sched, gateway_port_t &port) : sched_(sched), port_(port) { sched_.clients_.push_back(this); }
+
+    ~client()
+    {
+        for (auto it = sched_.clients_.begin(); it != sched_.clients_.end(); ++it) {
+            if (*it == this) {
+                sched_.clients_.erase(it);
+                break;
+            }
+        }
+    }
+
+    client(const client &) = delete;
+    client &operator=(const client &) = delete;
+
+    // Reads the "value" property of a user info object; a timeout_ms of 0 leaves only the request deadline
+    // of the gateway loop, which starts when the request is sent
+    request_op read_user_info(uint32_t dst_addr, scomx_user_info_object_t object_id, std::stop_token stop = {}, int timeout_ms = 0)
+    {
+        return read_property(dst_addr, SCOM_USER_INFO_OBJECT_TYPE, object_id, SCOMX_PROP_USER_INFO_VALUE, std::move(stop), timeout_ms);
+    }
+
+    // Reads the "value_qsp" property of a parameter object
+    request_op read_parameter(uint32_t dst_addr, scomx_parameter_object_t object_id, std::stop_token stop = {}, int timeout_ms = 0)
+    {
+        return read_property(dst_addr, SCOM_PARAMETER_OBJECT_TYPE, object_id, SCOMX_PROP_PARAMETER_VALUE_QSP, std::move(stop), timeout_ms);
+    }
+
+    request_op read_property(uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id, std::stop_token stop = {},
+                             int timeout_ms = 0, gateway_lane_t lane = GATEWAY_LANE_POLLING)
+    {
+        return request_op(*this, lane, dst_addr, object_type, object_id, property_id, std::move(stop), timeout_ms);
+    }
+
+    // Writes the "unsaved_value_qsp" property of a parameter object (in RAM only, meant for values changed
+    // often by control logic), encoded in the format of scomlib_extra_objects.def or as float when not listed.
+    // A newer write of the same parameter replaces this one while it waits in the gateway queue; the replaced
+    // write completes as cancelled.
+    request_op write_parameter(uint32_t dst_addr, scomx_parameter_object_t object_id, float value, std::stop_token stop = {}, int timeout_ms = 0)
+    {
+        const scomx_object_meta_t *meta = scomx_object_meta(SCOM_PARAMETER_OBJECT_TYPE, object_id);
+        char data[SCOMX_TYPED_VALUE_SIZE];
+        size_t length = 4;
+
+        if (meta) {
+            length = meta->encode(meta, value, data);
+        } else {
+            scom_write_le_float(data, value);
+        }
+
+        return request_op(*this, GATEWAY_LANE_CONTROL, dst_addr, SCOM_PARAMETER_OBJECT_TYPE, object_id, SCOMX_PROP_PARAMETER_UNSAVED_VALUE_QSP, data, length,
+                          value, std::move(stop), timeout_ms);
+    }
+
+    gateway_port_t &port() { return port_; }
+
+    // requests waiting for room in the gateway queue
+    size_t waiting() const { return waiting_count_; }
+
+private:
+    friend class scheduler;
+    friend class request_op;
+
+    struct waiting_list {
+        request_op *head = nullptr;
+        request_op *tail = nullptr;
+    };
+
+    scheduler &sched_;
+    gateway_port_t &port_;
+    waiting_list waiting_[GATEWAY_LANE_COUNT];
+    size_t waiting_count_ = 0;
+
+    void push_waiting(request_op *op)
+    {
+        waiting_list &l = waiting_[op->lane_];
+
+        op->prev_ = l.tail;
+        op->next_ = nullptr;
+        (l.tail ? l.tail->next_ : l.head) = op;
+        l.tail = op;
+        waiting_count_++;
+    }
+
+    void remove_waiting(request_op *op)
+    {
+        waiting_list &l = waiting_[op->lane_];
+
+        (op->prev_ ? op->prev_->next_ : l.head) = op->next_;
+        (op->next_ ? op->next_->prev_ : l.tail) = op->prev_;
+        op->prev_ = op->next_ = nullptr;
+        waiting_count_--;
+    }
+
+    bool lane_full(gateway_lane_t lane) const { return port_.lanes[lane].count >= port_.lanes[lane].depth; }
+
+    // moves waiting requests into their lane of the gateway queue while it has room, oldest first
+    void pump()
+    {
+        for (int lane = 0; lane < GATEWAY_LANE_COUNT; lane++) {
+            waiting_list &l = waiting_[lane];
+
+            while (l.head && !lane_full(static_cast<gateway_lane_t>(lane))) {
+                request_op *op = l.head;
+                remove_waiting(op);
+                if (!op->submit()) {
+                    push_waiting(op);
+                    break;
+                }
+            }
+        }
+    }
+};
+
+inline bool request_op::submit()
+{
+    gateway_port_t &port = client_.port_;
+    scomx_enc_result_t enc = write_length_ > 0
+                                 ? scomx_ctx_encode_write_property(&port.ctx, dst_addr_, object_type_, object_id_, property_id_, write_data_, write_length_)
+                                 : scomx_ctx_encode_read_property(&port.ctx, dst_addr_, object_type_, object_id_, property_id_);
+
+    if (enc.error != SCOM_ERROR_NO_ERROR) {
+        fail(enc.error);
+        return true;
+    }
+    if (gateway_submit_lane(&port, lane_, enc.data, enc.length, on_response, this) != 0) {
+        if (client_.lane_full(lane_)) {
+            return false;
+        }
+        // too long for the gateway queue, waiting wouldn't help
+        fail(SCOM_ERROR_STACK_BUFFER_TOO_SMALL);
+        return true;
+    }
+    state_ = state::submitted;
+    return true;
+}
+
+inline void request_op::await_suspend(std::coroutine_handle<> handle)
+{
+    handle_ = handle;
+
+    // earlier requests of the lane keep their turn
+    if (client_.waiting_[lane_].head || !submit()) {
+        state_ = state::waiting;
+        client_.push_waiting(this);
+    }
+    if (state_ == state::done) {
+        return;
+    }
+    if (timeout_ms_ > 0) {
+        client_.sched_.arm(this, client_.sched_.now_ms() + timeout_ms_);
+    }
+    if (stop_.stop_possible()) {
+        // invoked right away when already stopped
+        on_stop_.emplace(stop_, stop_fn{this});
+    }
+}
+
+inline void request_op::finish()
+{
+    state_ = state::done;
+    client_.sched_.disarm(this);
+    on_stop_.reset();
+    client_.sched_.post(handle_);
+}
+
+inline void request_op::fail(scom_error_t error)
+{
+    result_ = {{}, false};
+    result_.value.error = error;
+    finish();
+}
+
+inline void request_op::abort(bool cancelled)
+{
+    if (state_ == state::waiting) {
+        client_.remove_waiting(this);
+    } else if (state_ == state::submitted) {
+        // a response already on its way is dropped by the gateway loop
+        gateway_cancel(&client_.port_, this);
+    } else {
+        return;
+    }
+
+    result_ = {{}, cancelled};
+    result_.value.error = SCOM_ERROR_RESPONSE_TIMEOUT;
+    finish();
+}
+
+inline void request_op::on_response(gateway_port_t *port, const scomx_dec_result_t *res, void *user)
+{
+    request_op *op = static_cast<request_op *>(user);
+
+    (void)port;
+    if (!res) {
+        // replaced by a newer write
+        op->result_ = {{}, true};
+        op->result_.value.error = SCOM_ERROR_RESPONSE_TIMEOUT;
+    } else if (op->write_length_ > 0) {
+        op->result_ = {{}, false};
+        op->result_.value.error = res->error;
+        op->result_.value.value = op->write_value_;
+        op->result_.value.integer = static_cast<int32_t>(op->write_value_);
+    } else {
+        op->result_ = {scomx_decode_typed(res), false};
+    }
+    op->finish();
+}
+
+inline void scheduler::run_once(int max_wait_ms)
+{
+    struct epoll_event events[16];
+    int64_t now = now_ms();
+    int wait = max_wait_ms;
+
+    auto limit_wait = [&wait](int64_t ms) {
+        if (ms >= 0 && (wait < 0 || ms < wait)) {
+            wait = (int)ms;
+        }
+    };
+
+    if (!ready_.empty()) {
+        wait = 0;
+    }
+    if (!timers_.empty()) {
+        limit_wait(timers_.begin()->first > now ? timers_.begin()->first - now : 0);
+    }
+    limit_wait(gateway_loop_wait_ms(&loop_, now));
+
+    int n = epoll_wait(epoll_fd_, events, sizeof(events) / sizeof(events[0]), wait);
+
+    for (int i = 0; i < n; i++) {
+        if (events[i].data.ptr) {
+            // the awaiter type of readable()
+            using readable_awaiter = decltype(readable(0));
+            static_cast<readable_awaiter *>(events[i].data.ptr)->on_ready();
+        }
+    }
+
+    // starts requests, processes responses and request deadlines; completed reads are posted
+    gateway_loop_run_once(&loop_, 0);
+    for (client *c : clients_) {
+        c->pump();
+    }
+
+    now = now_ms();
+    while (!timers_.empty() && timers_.begin()->first <= now) {
+        detail::timer *t = timers_.begin()->second;
+        disarm(t);
+        t->expire();
+    }
+
+    resume_ready();
+}
+
+} // namespace gateway
+
+#endif
@@ -0,0 +1,548 @@
+#include "gateway_loop.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <termios.h>
+#include <unistd.h>
+
+// largest expected response: frame header, service and property headers, 4 byte value and data checksum
+#define MAX_RESPONSE_SIZE (SCOM_FRAME_HEADER_SIZE + 2 + 8 + 4 + 2)
+
+// offsets of the request fields in an encoded read or write property frame
+#define FRAME_DST_ADDR_OFFSET 6
+#define FRAME_PROPERTY_HEADER_OFFSET (SCOM_FRAME_HEADER_SIZE + 2)
+
+// captured records are written out at least this often, or when they fill half of the capture buffer
+#define CAPTURE_FLUSH_MS 1000
+
+static int set_events(gateway_loop_t *loop, gateway_port_t *port, uint32_t events)
+{
+    struct epoll_event ev;
+
+    if (port->failed) {
+        return -1;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.ptr = port;
+
+    return epoll_ctl(loop->epoll_fd, EPOLL_CTL_MOD, port->serial.fd, &ev);
+}
+
+static const unsigned k_lane_depths[GATEWAY_LANE_COUNT] = {GATEWAY_CONTROL_DEPTH, GATEWAY_INTERACTIVE_DEPTH, GATEWAY_POLLING_DEPTH};
+
+// the i-th request waiting in the lane, the one in flight being the first of the current lane
+static gateway_request_t *lane_request(gateway_port_t *port, gateway_lane_t lane, unsigned i)
+{
+    gateway_lane_queue_t *q = &port->lanes[lane];
+    return &port->queue[q->offset + (q->head + i) % q->depth];
+}
+
+static void pop_request(gateway_port_t *port, gateway_lane_t lane)
+{
+    gateway_lane_queue_t *q = &port->lanes[lane];
+
+    q->head = (q->head + 1) % q->depth;
+    q->count--;
+    port->queue_count--;
+}
+
+static gateway_request_t *current_request(gateway_port_t *port) { return lane_request(port, port->current_lane, 0); }
+
+// the time the next request may be sent, skipping cancelled ones; -1 when there is none
+static int64_t next_start_ms(const gateway_port_t *port)
+{
+    for (int lane = 0; lane < GATEWAY_LANE_COUNT; lane++) {
+        const gateway_lane_queue_t *q = &port->lanes[lane];
+
+        for (unsigned i = 0; i < q->count; i++) {
+            const gateway_request_t *req = &port->queue[q->offset + (q->head + i) % q->depth];
+
+            if (!req->cancelled) {
+                return req->not_before_ms;
+            }
+        }
+    }
+    return -1;
+}
+
+// completes the in-flight request, unless the retry policy sends it again, and makes the port ready for the next one
+static void finish_request(gateway_loop_t *loop, gateway_port_t *port, const scomx_dec_result_t *res)
+{
+    gateway_request_t *current = current_request(port);
+
+    port->state = GATEWAY_PORT_IDLE;
+    scomx_parser_reset(&port->parser);
+    set_events(loop, port, EPOLLIN);
+
+    if (port->retry && !current->cancelled) {
+        int64_t now = serial_now_ms();
+        scomx_retry_decision_t decision = scomx_retry_complete(port->retry, &current->retry, res->error, now);
+
+        if (decision.action == SCOMX_RETRY_AGAIN) {
+            // stays at the head of its lane
+            current->not_before_ms = decision.retry_at_ms;
+            port->retries++;
+            return;
+        }
+    }
+
+    gateway_request_t req = *current;
+
+    pop_request(port, port->current_lane);
+    port->completed++;
+    loop->completed++;
+
+    if (req.callback && !req.cancelled) {
+        req.callback(port, res, req.user);
+    }
+}
+
+static void fail_request(gateway_loop_t *loop, gateway_port_t *port, scom_error_t error)
+{
+    scomx_dec_result_t res;
+
+    memset(&res, 0, sizeof(res));
+    res.error = error;
+
+    finish_request(loop, port, &res);
+}
+
+static void capture_bytes(gateway_loop_t *loop, const gateway_port_t *port, scomx_capture_direction_t direction, const char *data, size_t length)
+{
+    if (loop->capture) {
+        scomx_capture_record(loop->capture, serial_now_us(), port->id, direction, data, length);
+    }
+}
+
+static void continue_write(gateway_loop_t *loop, gateway_port_t *port)
+{
+    gateway_request_t *req = current_request(port);
+
+    while (port->written < req->length) {
+        ssize_t ret = write(port->serial.fd, req->frame + port->written, req->length - port->written);
+
+        if (ret > 0) {
+            capture_bytes(loop, port, SCOMX_CAPTURE_TX, req->frame + port->written, ret);
+            port->written += ret;
+        } else if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // wait for the port to drain
+            set_events(loop, port, EPOLLIN | EPOLLOUT);
+            return;
+        } else if (ret < 0 && errno == EINTR) {
+            continue;
+        } else {
+            fail_request(loop, port, SCOM_ERROR_STACK_PORT_WRITE_FAILED);
+            return;
+        }
+    }
+
+    port->state = GATEWAY_PORT_AWAITING_RESPONSE;
+    set_events(loop, port, EPOLLIN);
+}
+
+static void start_request(gateway_loop_t *loop, gateway_port_t *port)
+{
+    gateway_lane_t lane;
+
+    // the highest priority lane goes first; cancelled requests are dropped without being sent
+    for (lane = GATEWAY_LANE_CONTROL; lane < GATEWAY_LANE_COUNT; lane++) {
+        while (port->lanes[lane].count > 0 && lane_request(port, lane, 0)->cancelled) {
+            pop_request(port, lane);
+        }
+        if (port->lanes[lane].count > 0) {
+            break;
+        }
+    }
+    if (lane == GATEWAY_LANE_COUNT || lane_request(port, lane, 0)->not_before_ms > serial_now_ms()) {
+        return;
+    }
+
+    port->current_lane = lane;
+    gateway_request_t *req = current_request(port);
+
+    if (port->failed) {
+        fail_request(loop, port, SCOM_ERROR_STACK_PORT_NOT_FOUND);
+        return;
+    }
+
+    port->state = GATEWAY_PORT_WRITING;
+    port->written = 0;
+    port->deadline_ms = serial_now_ms() + serial_transfer_ms(&port->serial, req->length) + loop->latency_ms + serial_transfer_ms(&port->serial, MAX_RESPONSE_SIZE);
+
+    // responses to earlier, already timed out requests are dropped
+    tcflush(port->serial.fd, TCIFLUSH);
+    scomx_parser_reset(&port->parser);
+
+    if (req->sent) {
+        req->sent(port, req->user);
+    }
+
+    continue_write(loop, port);
+}
+
+// a frame is the response to the request when it comes from the addressed device and, unless it
+// carries an error, describes the requested property
+static int matches_request(const gateway_request_t *req, const scomx_dec_result_t *res)
+{
+    if (res->src_addr != req->dst_addr) {
+        return 0;
+    }
+    if (res->error != SCOM_ERROR_NO_ERROR) {
+        return 1;
+    }
+    return res->object_type == req->object_type && res->object_id == req->object_id && res->property_id == req->property_id;
+}
+
+static void read_available(gateway_loop_t *loop, gateway_port_t *port)
+{
+    char buf[256];
+
+    for (;;) {
+        ssize_t ret = read(port->serial.fd, buf, sizeof(buf));
+
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        } else if (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            // the device is gone, stop watching it so that a hang-up doesn't spin the loop
+            port->failed = 1;
+            epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, port->serial.fd, NULL);
+            if (port->state != GATEWAY_PORT_IDLE) {
+                fail_request(loop, port, SCOM_ERROR_STACK_PORT_READ_FAILED);
+            }
+            return;
+        } else if (ret <= 0) {
+            return;
+        }
+
+        capture_bytes(loop, port, SCOMX_CAPTURE_RX, buf, ret);
+
+        if (port->state != GATEWAY_PORT_AWAITING_RESPONSE) {
+            // nothing was asked for
+            continue;
+        }
+
+        size_t offset = 0;
+        while (port->state == GATEWAY_PORT_AWAITING_RESPONSE) {
+            scomx_parse_result_t parsed = scomx_parser_push(&port->parser, buf + offset, ret - offset);
+            offset += parsed.consumed;
+
+            if (!parsed.frame_ready) {
+                break;
+            }
+
+            scomx_flags_watch_update(&port->flags, &parsed.result);
+
+            if (matches_request(current_request(port), &parsed.result)) {
+                finish_request(loop, port, &parsed.result);
+            } else {
+                port->stale_frames++;
+            }
+        }
+    }
+}
+
+int gateway_loop_init(gateway_loop_t *loop)
+{
+    memset(loop, 0, sizeof(*loop));
+
+    loop->latency_ms = GATEWAY_DEFAULT_LATENCY_MS;
+    loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+    return loop->epoll_fd < 0 ? -1 : 0;
+}
+
+void gateway_loop_close(gateway_loop_t *loop)
+{
+    if (loop->epoll_fd >= 0) {
+        close(loop->epoll_fd);
+        loop->epoll_fd = -1;
+    }
+}
+
+int gateway_loop_add_port(gateway_loop_t *loop, gateway_port_t *port)
+{
+    struct epoll_event ev;
+    serial_port_t serial = port->serial;
+
+    if (loop->port_count >= GATEWAY_MAX_PORTS) {
+        return -1;
+    }
+
+    memset(port, 0, sizeof(*port));
+    port->serial = serial;
+    port->id = (uint8_t)loop->port_count;
+
+    unsigned offset = 0;
+    for (int lane = 0; lane < GATEWAY_LANE_COUNT; lane++) {
+        port->lanes[lane].offset = offset;
+        port->lanes[lane].depth = k_lane_depths[lane];
+        offset += k_lane_depths[lane];
+    }
+    scomx_ctx_init(&port->ctx, port->txbuf, sizeof(port->txbuf));
+    scomx_parser_init(&port->parser, port->rxbuf, sizeof(port->rxbuf));
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = port;
+
+    if (epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, port->serial.fd, &ev) != 0) {
+        return -1;
+    }
+
+    loop->ports[loop->port_count++] = port;
+
+    return 0;
+}
+
+// a write of the same property waiting in the queue, not yet sent
+static gateway_request_t *find_unsent_write(gateway_port_t *port, const gateway_request_t *write, gateway_lane_t *found_lane)
+{
+    for (int lane = 0; lane < GATEWAY_LANE_COUNT; lane++) {
+        for (unsigned i = 0; i < port->lanes[lane].count; i++) {
+            gateway_request_t *req = lane_request(port, (gateway_lane_t)lane, i);
+
+            if (i == 0 && port->state != GATEWAY_PORT_IDLE && port->current_lane == (gateway_lane_t)lane) {
+                continue;
+            }
+            if (!req->cancelled && req->service_id == SCOM_WRITE_PROPERTY_SERVICE && req->dst_addr == write->dst_addr &&
+                req->object_type == write->object_type && req->object_id == write->object_id && req->property_id == write->property_id) {
+                *found_lane = (gateway_lane_t)lane;
+                return req;
+            }
+        }
+    }
+    return NULL;
+}
+
+int gateway_submit(gateway_port_t *port, const char *frame, size_t length, gateway_callback_t callback, void *user)
+{
+    return gateway_submit_lane(port, GATEWAY_LANE_POLLING, frame, length, callback, user);
+}
+
+int gateway_submit_lane(gateway_port_t *port, gateway_lane_t lane, const char *frame, size_t length, gateway_callback_t callback, void *user)
+{
+    return gateway_submit_tracked(port, lane, frame, length, callback, NULL, user);
+}
+
+int gateway_submit_tracked(gateway_port_t *port, gateway_lane_t lane, const char *frame, size_t length, gateway_callback_t callback, gateway_sent_t sent,
+                           void *user)
+{
+    gateway_request_t req;
+
+    if (lane >= GATEWAY_LANE_COUNT || length > GATEWAY_MAX_FRAME_SIZE || length < FRAME_PROPERTY_HEADER_OFFSET + 8) {
+        return -1;
+    }
+
+    memcpy(req.frame, frame, length);
+    req.length = length;
+    req.service_id = (uint8_t)frame[FRAME_PROPERTY_HEADER_OFFSET - 1];
+    req.dst_addr = scom_read_le32(frame + FRAME_DST_ADDR_OFFSET);
+    req.object_type = scom_read_le16(frame + FRAME_PROPERTY_HEADER_OFFSET);
+    req.object_id = scom_read_le32(frame + FRAME_PROPERTY_HEADER_OFFSET + 2);
+    req.property_id = scom_read_le16(frame + FRAME_PROPERTY_HEADER_OFFSET + 6);
+    req.callback = callback;
+    req.sent = sent;
+    req.user = user;
+    req.cancelled = 0;
+    req.not_before_ms = 0;
+    if (port->retry) {
+        // waits while the destination backs off
+        req.not_before_ms = scomx_retry_begin(port->retry, &req.retry, req.dst_addr, serial_now_ms());
+    }
+
+    gateway_lane_queue_t *q = &port->lanes[lane];
+    gateway_request_t *older = NULL;
+    gateway_lane_t older_lane = lane;
+
+    if (req.service_id == SCOM_WRITE_PROPERTY_SERVICE) {
+        older = find_unsent_write(port, &req, &older_lane);
+    }
+    if ((!older || older_lane != lane) && q->count >= q->depth) {
+        return -1;
+    }
+
+    gateway_request_t superseded;
+    if (older) {
+        superseded = *older;
+        port->superseded++;
+    }
+
+    if (older && older_lane == lane) {
+        // takes the place of the older write
+        *older = req;
+    } else {
+        if (older) {
+            older->cancelled = 1;
+        }
+        *lane_request(port, lane, q->count) = req;
+        q->count++;
+        port->queue_count++;
+    }
+
+    // last, as the callback may submit other requests
+    if (older && superseded.callback) {
+        superseded.callback(port, NULL, superseded.user);
+    }
+
+    return 0;
+}
+
+int gateway_cancel(gateway_port_t *port, void *user)
+{
+    int cancelled = 0;
+
+    for (int lane = 0; lane < GATEWAY_LANE_COUNT; lane++) {
+        for (unsigned i = 0; i < port->lanes[lane].count; i++) {
+            gateway_request_t *req = lane_request(port, (gateway_lane_t)lane, i);
+
+            if (req->user == user && !req->cancelled) {
+                req->cancelled = 1;
+                cancelled++;
+            }
+        }
+    }
+
+    return cancelled;
+}
+
+int gateway_loop_flush_capture(gateway_loop_t *loop)
+{
+    scomx_capture_t *capture = loop->capture;
+    size_t written = 0;
+
+    if (!capture) {
+        return 0;
+    }
+    loop->capture_flushed_ms = serial_now_ms();
+
+    while (written < capture->length) {
+        ssize_t ret = write(loop->capture_fd, capture->buffer + written, capture->length - written);
+
+        if (ret > 0) {
+            written += ret;
+        } else if (ret < 0 && errno == EINTR) {
+            continue;
+        } else if (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            // the ports keep going without capture
+            loop->capture_errors++;
+            loop->capture = NULL;
+            return -1;
+        } else {
+            // the rest is written out next time
+            break;
+        }
+    }
+    scomx_capture_consume(capture, written);
+
+    return 0;
+}
+
+int gateway_loop_busy(const gateway_loop_t *loop)
+{
+    for (unsigned i = 0; i < loop->port_count; i++) {
+        if (loop->ports[i]->queue_count > 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int gateway_loop_wait_ms(const gateway_loop_t *loop, int64_t now_ms)
+{
+    int wait = -1;
+
+    for (unsigned i = 0; i < loop->port_count; i++) {
+        const gateway_port_t *port = loop->ports[i];
+        int64_t until = -1;
+
+        if (port->state == GATEWAY_PORT_IDLE && port->queue_count > 0) {
+            until = next_start_ms(port);
+        } else if (port->state != GATEWAY_PORT_IDLE) {
+            until = port->deadline_ms;
+        }
+        if (until >= 0) {
+            int64_t remaining = until - now_ms;
+            if (remaining < 0) {
+                remaining = 0;
+            }
+            if (wait < 0 || remaining < wait) {
+                wait = (int)remaining;
+            }
+        }
+    }
+
+    return wait;
+}
+
+int gateway_loop_run_once(gateway_loop_t *loop, int max_wait_ms)
+{
+    struct epoll_event events[GATEWAY_MAX_PORTS];
+    unsigned long completed_before = loop->completed;
+    int64_t now = serial_now_ms();
+    int timeout = max_wait_ms;
+
+    for (unsigned i = 0; i < loop->port_count; i++) {
+        gateway_port_t *port = loop->ports[i];
+
+        if (port->state == GATEWAY_PORT_IDLE && port->queue_count > 0) {
+            start_request(loop, port);
+        }
+
+        // wake up in time for the nearest deadline or retry
+        int64_t until = -1;
+        if (port->state != GATEWAY_PORT_IDLE) {
+            until = port->deadline_ms;
+        } else if (port->queue_count > 0) {
+            until = next_start_ms(port);
+        }
+        if (until >= 0) {
+            int64_t remaining = until - now;
+            if (remaining < 0) {
+                remaining = 0;
+            }
+            if (timeout < 0 || remaining < timeout) {
+                timeout = (int)remaining;
+            }
+        }
+    }
+
+    int n = epoll_wait(loop->epoll_fd, events, GATEWAY_MAX_PORTS, timeout);
+    if (n < 0 && errno != EINTR) {
+        return -1;
+    }
+
+    for (int i = 0; i < n; i++) {
+        gateway_port_t *port = (gateway_port_t *)events[i].data.ptr;
+
+        if ((events[i].events & EPOLLOUT) && port->state == GATEWAY_PORT_WRITING) {
+            continue_write(loop, port);
+        }
+        if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+            read_available(loop, port);
+        }
+    }
+
+    now = serial_now_ms();
+    for (unsigned i = 0; i < loop->port_count; i++) {
+        gateway_port_t *port = loop->ports[i];
+
+        if (port->state != GATEWAY_PORT_IDLE && now >= port->deadline_ms) {
+            port->timeouts++;
+            fail_request(loop, port, SCOM_ERROR_RESPONSE_TIMEOUT);
+        }
+
+        // keep the ports busy without waiting for the next call
+        if (port->state == GATEWAY_PORT_IDLE && port->queue_count > 0) {
+            start_request(loop, port);
+        }
+    }
+
+    if (loop->capture && (loop->capture->length >= loop->capture->size / 2 || now - loop->capture_flushed_ms >= CAPTURE_FLUSH_MS)) {
+        gateway_loop_flush_capture(loop);
+    }
+
+    return (int)(loop->completed - completed_before);
+}
@@ -0,0 +1,195 @@
+#ifndef GATEWAY_LOOP_H
+#define GATEWAY_LOOP_H
+
+#include "../scomlib_extra/scomlib_extra.h"
+#include "serial.h"
+
+// Event loop multiplexing several Xcom-232i ports on a single epoll instance.
+//
+// Every port has its own request queue and at most one request in flight, so a slow or dead
+// device only delays the requests queued on its own port. The queue is split in priority lanes of
+// bounded depth: an idle port sends the oldest request of the highest priority lane, so a control
+// write waits at most for the request already on the wire rather than for all queued telemetry. A
+// write replaces a write of the same property still waiting in the queue (last write wins).
+//
+// Requests are encoded frames (for example produced with scomx_ctx_* on the port context) and
+// complete through a callback with the decoded response, SCOM_ERROR_RESPONSE_TIMEOUT when no
+// response arrived before the request deadline or SCOM_ERROR_STACK_PORT_WRITE_FAILED when the port
+// failed. The callback of a replaced write is called with a NULL response from gateway_submit_lane.
+//
+// With a retry policy set on the port, requests failing with SCOM_ERROR_GATEWAY_BUSY or
+// SCOM_ERROR_RESPONSE_TIMEOUT stay at the head of their lane and are sent again after the policy's
+// delay. During the delay the port still serves the higher priority lanes, but sends nothing from the
+// lane of the retry nor from the lanes below it: a polling retry lets control writes and interactive
+// reads through, a control retry holds up every lane. The callback only gets the final result.
+//
+// With a capture set on the loop, the bytes written to and read from every port are recorded in
+// its buffer, which gateway_loop_run_once writes out to capture_fd now and then. The descriptor
+// should be non-blocking when it isn't a regular file: records which don't fit in the buffer while
+// it can't be written are dropped rather than delaying the ports.
+//
+// The epoll instance can be nested in another event loop: wait for epoll_fd to become readable or for
+// gateway_loop_wait_ms to elapse, then call gateway_loop_run_once with no wait.
+//
+// Not thread safe: use one loop per thread, each with its own set of ports.
+
+#define GATEWAY_MAX_PORTS 32
+
+typedef enum {
+    GATEWAY_LANE_CONTROL = 0,     // writes of control logic
+    GATEWAY_LANE_INTERACTIVE = 1, // reads somebody is waiting for
+    GATEWAY_LANE_POLLING = 2,     // background telemetry
+    GATEWAY_LANE_COUNT
+} gateway_lane_t;
+
+// maximum number of requests queued in each lane, including the one in flight
+#define GATEWAY_CONTROL_DEPTH 8
+#define GATEWAY_INTERACTIVE_DEPTH 16
+#define GATEWAY_POLLING_DEPTH 40
+#define GATEWAY_QUEUE_SIZE (GATEWAY_CONTROL_DEPTH + GATEWAY_INTERACTIVE_DEPTH + GATEWAY_POLLING_DEPTH)
+#define GATEWAY_MAX_FRAME_SIZE 256
+
+// time the gateway may take to start responding after receiving a request
+#define GATEWAY_DEFAULT_LATENCY_MS 500
+
+struct gateway_port;
+
+typedef void (*gateway_callback_t)(struct gateway_port *port, const scomx_dec_result_t *res, void *user);
+// called when the request starts being written to the port; must not submit or cancel requests
+typedef void (*gateway_sent_t)(struct gateway_port *port, void *user);
+
+typedef struct {
+    char frame[GATEWAY_MAX_FRAME_SIZE];
+    size_t length;
+
+    // identification of the requested property, used to match the response and find superseded writes
+    uint8_t service_id;
+    uint32_t dst_addr;
+    uint16_t object_type;
+    uint32_t object_id;
+    uint16_t property_id;
+
+    gateway_callback_t callback;
+    gateway_sent_t sent;
+    void *user;
+
+    // set by gateway_cancel: the request isn't sent when still queued and completes without callback
+    int cancelled;
+
+    // the request is not sent before this time, set by the retry policy of the port
+    int64_t not_before_ms;
+    scomx_retry_state_t retry;
+} gateway_request_t;
+
+// ring of requests in its part of the port queue
+typedef struct {
+    unsigned offset;
+    unsigned depth;
+    unsigned head;
+    unsigned count;
+} gateway_lane_queue_t;
+
+typedef enum {
+    GATEWAY_PORT_IDLE = 0,
+    GATEWAY_PORT_WRITING,
+    GATEWAY_PORT_AWAITING_RESPONSE,
+} gateway_port_state_t;
+
+typedef struct gateway_port {
+    serial_port_t serial;
+
+    // context available to encode requests for this port
+    scomx_ctx_t ctx;
+    char txbuf[GATEWAY_MAX_FRAME_SIZE];
+
+    gateway_request_t queue[GATEWAY_QUEUE_SIZE];
+    gateway_lane_queue_t lanes[GATEWAY_LANE_COUNT];
+    // requests queued in all lanes, including the one in flight
+    unsigned queue_count;
+    // lane at the head of which the request in flight is
+    gateway_lane_t current_lane;
+
+    gateway_port_state_t state;
+    size_t written;
+    int64_t deadline_ms;
+
+    scomx_parser_t parser;
+    char rxbuf[GATEWAY_MAX_FRAME_SIZE];
+
+    // checks the frame flags of every response received on the port, including stale ones; set up
+    // with scomx_flags_watch_init after gateway_loop_add_port to react to pending messages or RCC resets
+    scomx_flags_watch_t flags;
+
+    // retries busy and timed out requests when set after gateway_loop_add_port; a policy can be
+    // shared by the ports of a loop, its counters are then kept per destination address only
+    scomx_retry_t *retry;
+
+    // index of the port in the loop, identifying it in captures
+    uint8_t id;
+
+    // set when the port failed and was removed from the loop
+    int failed;
+
+    unsigned long completed;
+    unsigned long timeouts;
+    unsigned long stale_frames;
+    unsigned long superseded;
+    unsigned long retries;
+} gateway_port_t;
+
+typedef struct {
+    int epoll_fd;
+    gateway_port_t *ports[GATEWAY_MAX_PORTS];
+    unsigned port_count;
+
+    // added to the wire time of request and response when computing request deadlines
+    unsigned latency_ms;
+
+    // requests completed on all ports
+    unsigned long completed;
+
+    // records the traffic of all ports when set after gateway_loop_init, see above
+    scomx_capture_t *capture;
+    int capture_fd;
+    int64_t capture_flushed_ms;
+    // failed writes of the capture; the capture is set to NULL after a write error
+    unsigned long capture_errors;
+} gateway_loop_t;
+
+// create the epoll instance
+int gateway_loop_init(gateway_loop_t *loop);
+
+// release the epoll instance; the ports are not closed
+void gateway_loop_close(gateway_loop_t *loop);
+
+// initialize the port state and register its serial port (already opened by serial_open) with the loop
+int gateway_loop_add_port(gateway_loop_t *loop, gateway_port_t *port);
+
+// queue an encoded request on the port in the polling lane; returns -1 when the lane is full or the frame too long
+int gateway_submit(gateway_port_t *port, const char *frame, size_t length, gateway_callback_t callback, void *user);
+
+// queue an encoded request in the given lane; returns -1 when the lane is full or the frame too long
+int gateway_submit_lane(gateway_port_t *port, gateway_lane_t lane, const char *frame, size_t length, gateway_callback_t callback, void *user);
+
+// same as gateway_submit_lane, also calling sent every time the request is written to the port (again
+// for each retry), e.g. to time the request from when it left the queue
+int gateway_submit_tracked(gateway_port_t *port, gateway_lane_t lane, const char *frame, size_t length, gateway_callback_t callback, gateway_sent_t sent,
+                           void *user);
+
+// cancel the queued or in-flight requests submitted with user; returns the number of requests cancelled
+int gateway_cancel(gateway_port_t *port, void *user);
+
+// wait up to max_wait_ms for I/O or request deadlines and process them; returns the number of requests completed
+int gateway_loop_run_once(gateway_loop_t *loop, int max_wait_ms);
+
+// returns 1 when some port still has queued or in-flight requests
+int gateway_loop_busy(const gateway_loop_t *loop);
+
+// write out the captured records, e.g. before closing the capture file; returns -1 when the write failed
+int gateway_loop_flush_capture(gateway_loop_t *loop);
+
+// returns the time until gateway_loop_run_once has work to do without I/O (a request to start or retry, or a
+// deadline), or -1 when no request is pending
+int gateway_loop_wait_ms(const gateway_loop_t *loop, int64_t now_ms);
+
+#endif
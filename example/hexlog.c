@@ -0,0 +1,177 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../scomlib_extra/scomlib_extra.h"
+#include "serial.h"
+
+// Converts between hex text frame logs, one frame per line, and typed records or binary captures:
+// decoding prints one CSV line per frame of a log, encoding prints the frames of a capture written
+// by scompoll -c or scomtest as a hex log.
+
+#define MAX_FRAME_SIZE 2048
+#define PORT_IDS 256
+
+// maps the whole file read-only, the logs can be much larger than the memory
+static const char *map_file(const char *path, size_t *length)
+{
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return NULL;
+    }
+
+    *length = (size_t)st.st_size;
+    if (*length == 0) {
+        close(fd);
+        return "";
+    }
+
+    void *data = mmap(NULL, *length, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror(path);
+        return NULL;
+    }
+    madvise(data, *length, MADV_SEQUENTIAL);
+
+    return (const char *)data;
+}
+
+static void unmap_file(const char *data, size_t length)
+{
+    if (length > 0) {
+        munmap((void *)data, length);
+    }
+}
+
+static void print_record(const scomx_hexlog_record_t *rec)
+{
+    const scomx_dec_result_t *res = &rec->result;
+
+    printf("%lu,%s,%u,%u,%u,%u,%u,", rec->line, rec->is_response ? "rx" : "tx", res->src_addr, res->dst_addr, res->object_type, res->object_id,
+           res->property_id);
+
+    if (res->error != SCOM_ERROR_NO_ERROR) {
+        printf(",,%s\n", scomx_err2str(res->error));
+    } else if (!rec->is_response || rec->value.error != SCOM_ERROR_NO_ERROR) {
+        printf(",,%s\n", rec->is_response ? scomx_err2str(rec->value.error) : "");
+    } else {
+        const scomx_object_meta_t *meta = scomx_object_meta((scom_object_type_t)res->object_type, res->object_id);
+        printf("%g,%s,\n", rec->value.value, rec->value.label ? rec->value.label : meta ? meta->unit : "");
+    }
+}
+
+static int decode_log(const char *path, int quiet)
+{
+    static char frame[MAX_FRAME_SIZE];
+    size_t length = 0;
+    const char *text = map_file(path, &length);
+
+    if (!text) {
+        return 1;
+    }
+
+    scomx_hexlog_t log;
+    scomx_hexlog_record_t rec;
+    unsigned long errors = 0;
+
+    if (!quiet) {
+        printf("line,direction,src,dst,object_type,object_id,property_id,value,unit,error\n");
+    }
+
+    int64_t start = serial_now_us();
+    scomx_hexlog_init(&log, text, length, frame, sizeof(frame));
+    while (scomx_hexlog_next(&log, &rec)) {
+        if (rec.value.error != SCOM_ERROR_NO_ERROR) {
+            errors++;
+        }
+        if (!quiet) {
+            print_record(&rec);
+        }
+    }
+    double elapsed = (serial_now_us() - start) / 1e6;
+
+    // on stderr, so that the records can be redirected
+    fprintf(stderr, "%lu frames (%lu with an error), %lu invalid lines, hex kernel %s\n", log.records, errors, log.invalid_lines, scomx_hex_kernel_name());
+    if (elapsed > 0) {
+        fprintf(stderr, "%.3f s, %.1f MB/s, %.0f frames/s\n", elapsed, length / elapsed / 1e6, log.records / elapsed);
+    }
+
+    unmap_file(text, length);
+
+    return 0;
+}
+
+// the frames of a capture as a hex log, reassembled from the captured reads and writes
+static int encode_capture(const char *path)
+{
+    static scomx_parser_t parsers[PORT_IDS][2];
+    static char buffers[PORT_IDS][2][MAX_FRAME_SIZE];
+    static char line[2 * MAX_FRAME_SIZE + 1];
+    size_t length = 0;
+    const char *data = map_file(path, &length);
+
+    if (!data) {
+        return 1;
+    }
+
+    for (unsigned port = 0; port < PORT_IDS; port++) {
+        for (unsigned dir = 0; dir < 2; dir++) {
+            scomx_parser_init(&parsers[port][dir], buffers[port][dir], MAX_FRAME_SIZE);
+        }
+        parsers[port][SCOMX_CAPTURE_TX].decode_requests = 1;
+    }
+
+    scomx_capture_record_t rec;
+    long n = 0, offset = scomx_capture_check_header(data, length);
+
+    while (offset > 0 && (n = scomx_capture_next(data + offset, length - offset, &rec)) > 0) {
+        scomx_parser_t *parser = &parsers[rec.port][rec.direction];
+        size_t pushed = 0;
+
+        offset += n;
+        for (;;) {
+            scomx_parse_result_t parsed = scomx_parser_push(parser, rec.data + pushed, rec.length - pushed);
+            pushed += parsed.consumed;
+            if (!parsed.frame_ready) {
+                break;
+            }
+
+            scomx_hex_encode(line, parsed.frame, parsed.frame_length);
+            line[2 * parsed.frame_length] = '\n';
+            fwrite(line, 1, 2 * parsed.frame_length + 1, stdout);
+        }
+    }
+
+    unmap_file(data, length);
+
+    if (offset < 0 || n < 0) {
+        fprintf(stderr, "%s: not a capture or corrupted\n", path);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, const char *argv[])
+{
+    if (argc == 3 && strcmp(argv[1], "-e") == 0) {
+        return encode_capture(argv[2]);
+    } else if (argc == 3 && strcmp(argv[1], "-q") == 0) {
+        return decode_log(argv[2], 1);
+    } else if (argc == 2 && argv[1][0] != '-') {
+        return decode_log(argv[1], 0);
+    }
+
+    printf("Usage: %s [-q] <hex log file>   print the frames of the log as CSV, or only count them with -q\n", argv[0]);
+    printf("       %s -e <capture file>     print the frames of a capture as a hex log\n", argv[0]);
+    return 1;
+}
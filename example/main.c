@@ -1,8 +1,10 @@
 #include <stdio.h>
 #include <termios.h> // for baud rate constant
+#include <unistd.h>
 
 #include "../scomlib_extra/scomlib_extra.h"
 #include "serial.h"
+#include "serial_transport.h"
 
 static void hex_dump(const void *inmem, size_t len)
 {
@@ -44,79 +46,181 @@ static void hex_dump(const void *inmem, size_t len)
     }
 }
 
-int test()
+// time the gateway may take to start responding after receiving the request
+#define RESPONSE_LATENCY_MS 500
+
+// largest expected response: frame header, service and property headers, 4 byte value and data checksum
+#define MAX_RESPONSE_SIZE (SCOM_FRAME_HEADER_SIZE + 2 + 8 + 4 + 2)
+
+static serial_port_t g_port;
+static scomx_ctx_t g_ctx;
+static char g_txbuf[256];
+static scomx_parser_t g_parser;
+static char g_rxbuf[256];
+// frames of the single read, for scomreplay, when a capture file is given
+static scomx_capture_t g_capture;
+static char g_capture_buffer[4096];
+
+// reads one value, printing the frames; returns the error of the read
+static scom_error_t test()
 {
     scomx_enc_result_t encresult;
-    scomx_header_dec_result_t dechdr;
-    scomx_dec_result_t decres;
-    size_t bytecounter;
+    serial_io_result_t io;
     char readbuf[128];
+    unsigned received = 0;
     float outval = 0.0;
 
-    encresult = scomx_encode_read_user_info_value(SCOMX_DEST_XTM(0), SCOMX_INFO_XTENDER_OUT_AC_POWER);
+    encresult = scomx_ctx_encode_read_user_info_value(&g_ctx, SCOMX_DEST_XTM(0), SCOMX_INFO_XTENDER_OUT_AC_POWER);
+
+    // the whole request must complete by this time, independently of how the response bytes trickle in
+    int64_t deadline = serial_now_ms() + serial_transfer_ms(&g_port, encresult.length) + RESPONSE_LATENCY_MS + serial_transfer_ms(&g_port, MAX_RESPONSE_SIZE);
 
     printf("WRITING FRAME:\n");
     hex_dump(encresult.data, encresult.length);
-    bytecounter = serial_write(encresult.data, encresult.length);
-    if (bytecounter != encresult.length) {
-        printf("Wrote only %u bytes from %u\n", bytecounter, encresult.length);
-        return 10;
+    io = serial_write_until(&g_port, encresult.data, encresult.length, deadline);
+    scomx_capture_record(&g_capture, serial_now_us(), 0, SCOMX_CAPTURE_TX, encresult.data, io.length);
+    if (io.status != SERIAL_OK) {
+        printf("Wrote only %u bytes from %zu\n", io.length, encresult.length);
+        return SCOM_ERROR_STACK_PORT_WRITE_FAILED;
     }
 
-    printf("READING HEAD:\n");
-    bytecounter = serial_read(readbuf, SCOM_FRAME_HEADER_SIZE);
-    if (bytecounter != SCOM_FRAME_HEADER_SIZE) {
-        printf("Read only %u bytes from %u (header)\n", bytecounter, SCOM_FRAME_HEADER_SIZE);
-        return 1;
-    }
-    hex_dump(readbuf, SCOM_FRAME_HEADER_SIZE);
+    // drop anything left over from a previous request
+    scomx_parser_reset(&g_parser);
+
+    printf("READING RESPONSE:\n");
+    for (;;) {
+        io = serial_read_some(&g_port, readbuf, sizeof(readbuf), deadline);
+        if (io.status == SERIAL_TIMEOUT && received == 0) {
+            printf("Timeout, no response\n");
+            return SCOM_ERROR_RESPONSE_TIMEOUT;
+        } else if (io.status == SERIAL_TIMEOUT) {
+            printf("Timeout, incomplete response (%u bytes received)\n", received);
+            return SCOM_ERROR_RESPONSE_TIMEOUT;
+        } else if (io.status == SERIAL_ERROR) {
+            printf("Read error\n");
+            return SCOM_ERROR_STACK_PORT_READ_FAILED;
+        }
 
-    dechdr = scomx_decode_frame_header(readbuf, SCOM_FRAME_HEADER_SIZE);
-    if (dechdr.error != SCOM_ERROR_NO_ERROR) {
-        printf("Error decoding frame header: %s\n", scomx_err2str(dechdr.error));
-        return 2;
-    }
+        received += io.length;
+        scomx_capture_record(&g_capture, serial_now_us(), 0, SCOMX_CAPTURE_RX, readbuf, io.length);
 
-    printf("READING BODY:\n");
-    bytecounter = serial_read(readbuf, dechdr.length_to_read);
-    if (bytecounter != dechdr.length_to_read) {
-        printf("Read only %u bytes from %u (body)\n", bytecounter, dechdr.length_to_read);
-        return 3;
-    }
-    hex_dump(readbuf, dechdr.length_to_read);
+        scomx_parse_result_t parsed = scomx_parser_push(&g_parser, readbuf, io.length);
+        if (!parsed.frame_ready) {
+            continue;
+        }
+
+        hex_dump(parsed.frame, parsed.frame_length);
+
+        if (parsed.result.error != SCOM_ERROR_NO_ERROR) {
+            printf("Error decoding frame: %s\n", scomx_err2str(parsed.result.error));
+            return parsed.result.error;
+        }
+
+        outval = scomx_result_float(parsed.result);
 
-    decres = scomx_decode_frame(readbuf, dechdr.length_to_read);
-    if (decres.error != SCOM_ERROR_NO_ERROR) {
-        printf("Error decoding frame body: %s\n", scomx_err2str(decres.error));
-        return 4;
+        printf("SRC ADDR: %u, SVC ID %u, OBJ TYPE %u, OBJ ID %u, PROP ID %u, VALUE %.3f\n", parsed.result.src_addr, parsed.result.service_id, parsed.result.object_type,
+               parsed.result.object_id, parsed.result.property_id, outval);
+
+        return SCOM_ERROR_NO_ERROR;
     }
+}
 
-    outval = scomx_result_float(decres);
+// reads a dashboard's worth of values in a single batch
+static int read_dashboard()
+{
+    static const scomx_user_info_object_t objects[] = {
+        SCOMX_INFO_XTENDER_BATT_VOLTAGE, SCOMX_INFO_XTENDER_BATT_CHARGE_CURR, SCOMX_INFO_XTENDER_IN_AC_VOLT, SCOMX_INFO_XTENDER_IN_AC_CURR,
+        SCOMX_INFO_XTENDER_OUT_AC_VOLT,  SCOMX_INFO_XTENDER_OUT_AC_CURR,      SCOMX_INFO_XTENDER_OUT_AC_POWER, SCOMX_INFO_XTENDER_OUT_ACTIVE_POWER,
+        SCOMX_INFO_XTENDER_OPERATING_STATE,
+    };
+    scomx_read_item_t items[SCOM_NBR_ELEMENTS(objects)];
+    scomx_transport_t transport;
+
+    serial_transport_init(&transport, &g_port, MAX_RESPONSE_SIZE);
+
+    for (unsigned i = 0; i < SCOM_NBR_ELEMENTS(objects); i++) {
+        items[i].dst_addr = SCOMX_DEST_XTM(0);
+        items[i].object_type = SCOM_USER_INFO_OBJECT_TYPE;
+        items[i].object_id = objects[i];
+        items[i].property_id = SCOMX_PROP_USER_INFO_VALUE;
+    }
 
-    printf("SRC ADDR: %u, SVC ID %u, OBJ TYPE %u, OBJ ID %u, PROP ID %u, VALUE %.3f\n", decres.src_addr, decres.service_id, decres.object_type, decres.object_id,
-           decres.property_id, outval);
+    int64_t start = serial_now_ms();
+    size_t ok = scomx_read_many(&transport, items, SCOM_NBR_ELEMENTS(items));
+    int64_t elapsed = serial_now_ms() - start;
+
+    for (unsigned i = 0; i < SCOM_NBR_ELEMENTS(items); i++) {
+        // decoded by the format of the object, with its unit or label
+        const scomx_object_meta_t *meta = scomx_object_meta(SCOM_USER_INFO_OBJECT_TYPE, items[i].object_id);
+        scomx_typed_value_t v = scomx_decode_typed(&items[i].result);
+
+        if (v.error != SCOM_ERROR_NO_ERROR) {
+            printf("OBJ ID %u: %s\n", items[i].object_id, scomx_err2str(v.error));
+        } else if (v.label) {
+            printf("OBJ ID %u: %s\n", items[i].object_id, v.label);
+        } else {
+            printf("OBJ ID %u: %.3f %s\n", items[i].object_id, v.value, meta ? meta->unit : "");
+        }
+    }
+    printf("%zu of %zu values read in %lld ms\n", ok, SCOM_NBR_ELEMENTS(items), (long long)elapsed);
 
-    return 0;
+    return ok == SCOM_NBR_ELEMENTS(items) ? 0 : 1;
 }
 
 int main(int argc, const char *argv[])
 {
     const char *port = "/dev/ttyUSB0";
+    const char *capture_path = argc > 2 ? argv[2] : NULL;
 
     if (argc > 1) {
         port = argv[1];
     }
 
     printf("Studer serial comm test on port %s\n", port);
-    if (serial_init(port, B38400, PARITY_EVEN, 1) != 0) {
+    if (serial_open(&g_port, port, B38400, PARITY_EVEN, 1) != 0) {
         return 1;
     }
 
-    for (unsigned i = 0; i < 3; i++) {
-        printf("=> attempt %u:\n", i);
-        int r = test();
-        if (r != 0) {
-            printf("=== RET CODE %d\n", r);
+    scomx_ctx_init(&g_ctx, g_txbuf, sizeof(g_txbuf));
+    scomx_parser_init(&g_parser, g_rxbuf, sizeof(g_rxbuf));
+    scomx_capture_init(&g_capture, g_capture_buffer, sizeof(g_capture_buffer));
+
+    // a busy or silent gateway is asked again after a growing delay, not right away
+    scomx_retry_t retry;
+    scomx_retry_dest_t dests[1];
+    scomx_retry_state_t state;
+
+    scomx_retry_init(&retry, dests, SCOM_NBR_ELEMENTS(dests), (uint32_t)serial_now_ms());
+    int64_t send_at = scomx_retry_begin(&retry, &state, SCOMX_DEST_XTM(0), serial_now_ms());
+    for (;;) {
+        int64_t now = serial_now_ms();
+        if (send_at > now) {
+            usleep((useconds_t)(send_at - now) * 1000);
+        }
+
+        printf("=> attempt %u:\n", state.attempts);
+        scom_error_t error = test();
+        scomx_retry_decision_t decision = scomx_retry_complete(&retry, &state, error, serial_now_ms());
+        if (decision.action != SCOMX_RETRY_AGAIN) {
+            if (error != SCOM_ERROR_NO_ERROR) {
+                printf("=== FAILED after %u attempts: %s\n", state.attempts, scomx_err2str(error));
+            }
+            break;
+        }
+        printf("=== %s, retrying in %lld ms\n", scomx_err2str(error), (long long)(decision.retry_at_ms - serial_now_ms()));
+        send_at = decision.retry_at_ms;
+    }
+
+    if (capture_path) {
+        FILE *f = fopen(capture_path, "wb");
+        size_t written = f ? fwrite(g_capture.buffer, 1, g_capture.length, f) : 0;
+        if (!f || fclose(f) != 0 || written != g_capture.length) {
+            perror(capture_path);
         }
     }
+
+    printf("=> batch read:\n");
+    read_dashboard();
+
+    serial_close(&g_port);
 }
@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h> // for baud rate constant
+
+#include "gateway_loop.h"
+
+// values polled round-robin on every port
+static const scomx_user_info_object_t k_objects[] = {
+    SCOMX_INFO_XTENDER_BATT_VOLTAGE, SCOMX_INFO_XTENDER_OUT_AC_POWER, SCOMX_INFO_XTENDER_OUT_ACTIVE_POWER,
+    SCOMX_INFO_XTENDER_IN_AC_VOLT,   SCOMX_INFO_XTENDER_IN_AC_CURR,   SCOMX_INFO_XTENDER_OPERATING_STATE,
+};
+
+typedef struct {
+    unsigned next_object;
+    unsigned long ok;
+    unsigned long failed;
+} poll_state_t;
+
+static gateway_port_t g_ports[GATEWAY_MAX_PORTS];
+static poll_state_t g_states[GATEWAY_MAX_PORTS];
+
+// busy and timed out reads are retried; every port has its own policy, as the same device addresses
+// are found behind each gateway
+static scomx_retry_t g_retry[GATEWAY_MAX_PORTS];
+static scomx_retry_dest_t g_retry_dests[GATEWAY_MAX_PORTS][4];
+
+// errors reported separately in the retry counters
+static const scom_error_t k_reported_errors[] = {SCOM_ERROR_GATEWAY_BUSY, SCOM_ERROR_RESPONSE_TIMEOUT};
+
+static void submit_next(gateway_port_t *port, poll_state_t *state);
+
+static void on_response(gateway_port_t *port, const scomx_dec_result_t *res, void *user)
+{
+    poll_state_t *state = (poll_state_t *)user;
+
+    if (res->error == SCOM_ERROR_NO_ERROR) {
+        state->ok++;
+    } else {
+        state->failed++;
+    }
+
+    submit_next(port, state);
+}
+
+static void submit_next(gateway_port_t *port, poll_state_t *state)
+{
+    scomx_user_info_object_t object = k_objects[state->next_object++ % SCOM_NBR_ELEMENTS(k_objects)];
+    scomx_enc_result_t enc = scomx_ctx_encode_read_user_info_value(&port->ctx, SCOMX_DEST_XTM(0), object);
+
+    if (enc.error == SCOM_ERROR_NO_ERROR) {
+        gateway_submit(port, enc.data, enc.length, on_response, state);
+    }
+}
+
+static void print_retry_counters(const char *name, const scomx_retry_t *retry)
+{
+    for (size_t i = 0; i < retry->capacity && retry->dests[i].used; i++) {
+        const scomx_retry_dest_t *dest = &retry->dests[i];
+        unsigned long reported = 0;
+
+        printf("%s dst %u: %lu attempts, %lu ok, %lu retries, %lu failed", name, dest->dst_addr, dest->attempts, dest->successes, dest->retries, dest->failures);
+        for (unsigned e = 0; e < SCOM_NBR_ELEMENTS(k_reported_errors); e++) {
+            unsigned long count = scomx_retry_error_count(dest, k_reported_errors[e]);
+            printf(", %s %lu", scomx_err2str(k_reported_errors[e]), count);
+            reported += count;
+        }
+        // the errors of the slots, plus those which didn't fit
+        unsigned long errors = dest->other_errors;
+        for (unsigned e = 0; e < SCOMX_RETRY_ERROR_SLOTS; e++) {
+            errors += dest->errors[e].count;
+        }
+        printf(", other errors %lu\n", errors - reported);
+    }
+}
+
+int main(int argc, const char *argv[])
+{
+    gateway_loop_t loop;
+    int check = 0;
+
+    if (argc > 1 && strcmp(argv[1], "-c") == 0) {
+        check = 1;
+        argv++;
+        argc--;
+    }
+    if (argc < 3) {
+        printf("Usage: %s [-c] <seconds> <port> [port...]\n", argv[0]);
+        printf("  -c  exit with an error when a port timed out, received a frame not matching its request or read nothing\n");
+        return 1;
+    }
+
+    int seconds = atoi(argv[1]);
+    unsigned port_count = argc - 2;
+    if (port_count > GATEWAY_MAX_PORTS) {
+        port_count = GATEWAY_MAX_PORTS;
+    }
+
+    if (gateway_loop_init(&loop) != 0) {
+        perror("epoll");
+        return 1;
+    }
+
+    for (unsigned i = 0; i < port_count; i++) {
+        if (serial_open(&g_ports[i].serial, argv[i + 2], B38400, PARITY_EVEN, 1) != 0 || gateway_loop_add_port(&loop, &g_ports[i]) != 0) {
+            return 1;
+        }
+        scomx_retry_init(&g_retry[i], g_retry_dests[i], SCOM_NBR_ELEMENTS(g_retry_dests[i]), (uint32_t)serial_now_ms() + i);
+        g_ports[i].retry = &g_retry[i];
+        submit_next(&g_ports[i], &g_states[i]);
+    }
+
+    int64_t start = serial_now_ms();
+    int64_t end = start + seconds * 1000;
+    while (serial_now_ms() < end) {
+        gateway_loop_run_once(&loop, (int)(end - serial_now_ms()));
+    }
+    double elapsed = (serial_now_ms() - start) / 1000.0;
+
+    unsigned long total = 0;
+    int failed = 0;
+    for (unsigned i = 0; i < port_count; i++) {
+        printf("%s: %lu ok, %lu failed (%lu timeouts, %lu retries, %lu stale frames), %.1f reads/sec\n", argv[i + 2], g_states[i].ok, g_states[i].failed,
+               g_ports[i].timeouts, g_ports[i].retries, g_ports[i].stale_frames, g_states[i].ok / elapsed);
+        total += g_states[i].ok;
+        if (g_states[i].ok == 0 || g_states[i].failed > 0 || g_ports[i].timeouts > 0 || g_ports[i].stale_frames > 0) {
+            failed = 1;
+        }
+        serial_close(&g_ports[i].serial);
+    }
+    printf("total: %.1f reads/sec\n", total / elapsed);
+
+    for (unsigned p = 0; p < port_count; p++) {
+        print_retry_counters(argv[p + 2], &g_retry[p]);
+    }
+
+    gateway_loop_close(&loop);
+
+    if (check && failed) {
+        printf("check failed\n");
+        return 1;
+    }
+    return 0;
+}
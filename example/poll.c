@@ -0,0 +1,335 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h> // for baud rate constant
+#include <unistd.h>
+
+#include "gateway_loop.h"
+#include "snapshot_file.h"
+
+typedef struct {
+    scomx_user_info_object_t object;
+    uint32_t period_ms;
+    uint8_t priority;
+} poll_object_t;
+
+// control values refresh several times a second, counters take whatever link time is left
+static const poll_object_t k_objects[] = {
+    {SCOMX_INFO_XTENDER_OUT_ACTIVE_POWER, 250, 0},  {SCOMX_INFO_XTENDER_BATT_VOLTAGE, 250, 0},   {SCOMX_INFO_XTENDER_BATT_CHARGE_CURR, 250, 0},
+    {SCOMX_INFO_XTENDER_IN_AC_VOLT, 1000, 1},       {SCOMX_INFO_XTENDER_IN_AC_CURR, 1000, 1},    {SCOMX_INFO_XTENDER_OUT_AC_VOLT, 1000, 1},
+    {SCOMX_INFO_XTENDER_OUT_AC_CURR, 1000, 1},      {SCOMX_INFO_XTENDER_OPERATING_STATE, 2000, 1}, {SCOMX_INFO_XTENDER_SYSTEM_STATE, 2000, 1},
+    {SCOMX_INFO_XTENDER_STATE_TRANSF_RLY, 2000, 1}, {SCOMX_INFO_XTENDER_BATT_TEMP, 10000, 2},
+    {SCOMX_INFO_XTENDER_DISCH_CURR_DAY, 60000, 3},  {SCOMX_INFO_XTENDER_INENERG_CURR_DAY, 60000, 3}, {SCOMX_INFO_XTENDER_OENERG_CURR_DAY, 60000, 3},
+    {SCOMX_INFO_XTENDER_NUM_OVERLOADS, 60000, 3},   {SCOMX_INFO_XTENDER_NUM_OVERTEMPS, 60000, 3},
+};
+
+// samples kept for each subscription, in the same order; only the samples passing the change filter are kept
+#define HISTORY_SIZE 64
+
+// captured traffic waiting to be written out
+#define CAPTURE_BUFFER_SIZE 65536
+
+// the battery temperature is only worth a sample when it moved by half a degree
+#define BATT_TEMP_DEADBAND 0.5f
+
+// the dashboard thread prints the average of this many recent samples of the priority 0 objects
+#define DASHBOARD_SAMPLES 8
+#define DASHBOARD_PERIOD_MS 5000
+
+static gateway_port_t g_port;
+static scomx_sched_t g_sched;
+static scomx_subscription_t g_subscriptions[SCOM_NBR_ELEMENTS(k_objects)];
+static scomx_history_t g_histories[SCOM_NBR_ELEMENTS(k_objects)];
+static scomx_history_slot_t g_history_slots[SCOM_NBR_ELEMENTS(k_objects)][HISTORY_SIZE];
+static scomx_filter_t g_filters[SCOM_NBR_ELEMENTS(k_objects)];
+static volatile int g_stopping;
+// latest values shared with other processes, when a snapshot file is given
+static snapshot_file_t g_snapshot;
+static int g_snapshot_slots[SCOM_NBR_ELEMENTS(k_objects)];
+// traffic on the port, when a capture file is given
+static scomx_capture_t g_capture;
+static char g_capture_buffer[CAPTURE_BUFFER_SIZE];
+static scomx_msglog_t g_msglog;
+static char g_message_request[SCOMX_READ_REQUEST_SIZE];
+static int g_message_read_queued;
+static const char *g_cursor_path;
+static unsigned long g_rcc_resets;
+
+static void on_response(gateway_port_t *port, const scomx_dec_result_t *res, void *user)
+{
+    scomx_subscription_t *sub = (scomx_subscription_t *)user;
+    scomx_typed_value_t v = scomx_decode_typed(res);
+    int64_t now = serial_now_ms();
+    size_t i = sub - g_subscriptions;
+
+    (void)port;
+    if (scomx_filter_apply(&g_filters[i], v.value, v.error, now)) {
+        scomx_history_push(&g_histories[i], now, v.value, v.error);
+    }
+    // the snapshot only holds the latest value, readers rely on its timestamp being fresh
+    if (g_snapshot.memory) {
+        scomx_snapshot_publish(&g_snapshot.snap, g_snapshot_slots[i], now, v.value, v.error);
+    }
+    scomx_sched_complete(&g_sched, sub, res->error, now);
+}
+
+// another thread reading the histories while the main thread polls, without locking
+static void *dashboard(void *arg)
+{
+    (void)arg;
+
+    while (!g_stopping) {
+        for (unsigned t = 0; t < DASHBOARD_PERIOD_MS / 100 && !g_stopping; t++) {
+            usleep(100 * 1000);
+        }
+
+        for (unsigned i = 0; i < SCOM_NBR_ELEMENTS(k_objects); i++) {
+            scomx_sample_t samples[DASHBOARD_SAMPLES];
+            size_t count = k_objects[i].priority == 0 ? scomx_history_recent(&g_histories[i], samples, DASHBOARD_SAMPLES) : 0;
+            size_t ok = 0;
+            float sum = 0;
+
+            for (size_t j = 0; j < count; j++) {
+                if (samples[j].error == SCOM_ERROR_NO_ERROR) {
+                    sum += samples[j].value;
+                    ok++;
+                }
+            }
+            if (ok > 0) {
+                printf("object %u: %.2f on average over %zu samples\n", k_objects[i].object, sum / ok, ok);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static uint32_t load_cursor(const char *path)
+{
+    unsigned cursor = 0;
+    FILE *f = path ? fopen(path, "r") : NULL;
+
+    if (f) {
+        if (fscanf(f, "%u", &cursor) != 1) {
+            cursor = 0;
+        }
+        fclose(f);
+    }
+
+    return cursor;
+}
+
+// replaces the file at once so that a crash leaves either the old or the new cursor
+static void save_cursor(const char *path, uint32_t cursor)
+{
+    char tmp_path[512];
+
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    FILE *f = fopen(tmp_path, "w");
+    if (!f) {
+        perror(tmp_path);
+        return;
+    }
+    fprintf(f, "%u\n", cursor);
+    if (fclose(f) != 0 || rename(tmp_path, path) != 0) {
+        perror(path);
+    }
+}
+
+static void print_message(void *user, const scomx_message_t *message)
+{
+    (void)user;
+    printf("message %u from %u: type %u, value %u, time %u\n", message->seq, message->source, message->type, message->value, message->timestamp);
+}
+
+static void submit_message_read(gateway_port_t *port);
+
+static void on_message(gateway_port_t *port, const scomx_dec_result_t *res, void *user)
+{
+    uint32_t cursor = g_msglog.cursor;
+
+    (void)user;
+    g_message_read_queued = 0;
+
+    if (scomx_msglog_complete(&g_msglog, res) != SCOM_ERROR_NO_ERROR) {
+        // fetched again by the next response still flagging the messages
+        scomx_flags_watch_rearm(&port->flags, SCOMX_FLAG_MESSAGE_PENDING);
+    }
+    if (g_msglog.cursor != cursor && g_cursor_path) {
+        save_cursor(g_cursor_path, g_msglog.cursor);
+    }
+
+    submit_message_read(port);
+}
+
+// message reads go to the port one at a time, in between the scheduled reads
+static void submit_message_read(gateway_port_t *port)
+{
+    if (g_message_read_queued || !scomx_msglog_next(&g_msglog, g_message_request)) {
+        return;
+    }
+
+    if (gateway_submit(port, g_message_request, sizeof(g_message_request), on_message, NULL) == 0) {
+        g_message_read_queued = 1;
+    } else {
+        scomx_flags_watch_rearm(&port->flags, SCOMX_FLAG_MESSAGE_PENDING);
+    }
+}
+
+// the message objects are only read when the gateway flags a new message, instead of being polled
+static void on_flags(void *user, uint8_t raised, uint8_t cleared, uint8_t flags)
+{
+    gateway_port_t *port = (gateway_port_t *)user;
+
+    (void)cleared;
+    (void)flags;
+
+    if (raised & SCOMX_FLAG_MESSAGE_PENDING) {
+        scomx_msglog_start(&g_msglog);
+        submit_message_read(port);
+    }
+    if (raised & SCOMX_FLAG_RCC_RESET) {
+        g_rcc_resets++;
+        printf("RCC reset\n");
+    }
+}
+
+// keeps one scheduled read on the port
+static void submit_due(gateway_port_t *port)
+{
+    if (port->queue_count > 0 || port->failed) {
+        return;
+    }
+
+    scomx_subscription_t *sub = scomx_sched_next(&g_sched, serial_now_ms());
+    if (!sub) {
+        return;
+    }
+
+    if (gateway_submit(port, sub->frame, sizeof(sub->frame), on_response, sub) != 0) {
+        scomx_sched_complete(&g_sched, sub, SCOM_ERROR_STACK_BUFFER_TOO_SMALL, serial_now_ms());
+    }
+}
+
+int main(int argc, const char *argv[])
+{
+    gateway_loop_t loop;
+    const char *snapshot_path = NULL;
+    const char *capture_path = NULL;
+    int arg = 1;
+
+    for (; argc > arg + 1 && argv[arg][0] == '-'; arg += 2) {
+        if (strcmp(argv[arg], "-s") == 0) {
+            snapshot_path = argv[arg + 1];
+        } else if (strcmp(argv[arg], "-c") == 0) {
+            capture_path = argv[arg + 1];
+        } else {
+            break;
+        }
+    }
+    if (argc - arg < 2 || argv[arg][0] == '-') {
+        printf("Usage: %s [-s snapshot file] [-c capture file] <seconds> <port> [message cursor file]\n", argv[0]);
+        return 1;
+    }
+
+    int seconds = atoi(argv[arg]);
+
+    if (gateway_loop_init(&loop) != 0) {
+        perror("epoll");
+        return 1;
+    }
+    if (serial_open(&g_port.serial, argv[arg + 1], B38400, PARITY_EVEN, 1) != 0 || gateway_loop_add_port(&loop, &g_port) != 0) {
+        return 1;
+    }
+
+    scomx_flags_watch_init(&g_port.flags, SCOMX_FLAG_MESSAGE_PENDING | SCOMX_FLAG_RCC_RESET, on_flags, &g_port);
+    // only messages newer than the ones printed by the previous run are read
+    g_cursor_path = argc > arg + 2 ? argv[arg + 2] : NULL;
+    scomx_msglog_init(&g_msglog, SCOMX_DEST_232(0), load_cursor(g_cursor_path), print_message, NULL);
+
+    if (capture_path) {
+        // non-blocking in case it is a pipe to another process
+        loop.capture_fd = open(capture_path, O_WRONLY | O_CREAT | O_TRUNC | O_NONBLOCK | O_CLOEXEC, 0644);
+        if (loop.capture_fd < 0) {
+            perror(capture_path);
+            return 1;
+        }
+        scomx_capture_init(&g_capture, g_capture_buffer, sizeof(g_capture_buffer));
+        loop.capture = &g_capture;
+    }
+    if (snapshot_path && snapshot_file_create(&g_snapshot, snapshot_path, SCOM_NBR_ELEMENTS(k_objects)) != 0) {
+        return 1;
+    }
+
+    int64_t start = serial_now_ms();
+    scomx_sched_init(&g_sched, g_subscriptions, SCOM_NBR_ELEMENTS(g_subscriptions), start);
+    for (unsigned i = 0; i < SCOM_NBR_ELEMENTS(k_objects); i++) {
+        scomx_history_init(&g_histories[i], g_history_slots[i], HISTORY_SIZE);
+
+        scomx_filter_config_t filter = scomx_filter_default_config(SCOM_USER_INFO_OBJECT_TYPE, k_objects[i].object);
+        if (k_objects[i].object == SCOMX_INFO_XTENDER_BATT_TEMP) {
+            filter.abs_deadband = BATT_TEMP_DEADBAND;
+        }
+        scomx_filter_init(&g_filters[i], &filter);
+
+        scomx_sched_add(&g_sched, SCOMX_DEST_XTM(0), SCOM_USER_INFO_OBJECT_TYPE, k_objects[i].object, SCOMX_PROP_USER_INFO_VALUE, k_objects[i].period_ms,
+                        k_objects[i].priority, start);
+        if (g_snapshot.memory) {
+            g_snapshot_slots[i] = scomx_snapshot_add(&g_snapshot.snap, SCOMX_DEST_XTM(0), SCOM_USER_INFO_OBJECT_TYPE, k_objects[i].object);
+        }
+    }
+
+    pthread_t dashboard_thread;
+    if (pthread_create(&dashboard_thread, NULL, dashboard, NULL) != 0) {
+        return 1;
+    }
+
+    int64_t end = start + seconds * 1000;
+    int64_t now;
+    while ((now = serial_now_ms()) < end && !g_port.failed) {
+        submit_due(&g_port);
+
+        int wait = (int)(end - now);
+        int due = scomx_sched_wait_ms(&g_sched, now);
+        if (due >= 0 && due < wait) {
+            wait = due;
+        }
+
+        gateway_loop_run_once(&loop, wait);
+    }
+
+    g_stopping = 1;
+    pthread_join(dashboard_thread, NULL);
+
+    unsigned long passed = 0, suppressed = 0;
+    printf("%-8s %8s %6s %6s %8s %8s %6s\n", "object", "period", "reads", "errors", "missed", "cost ms", "passed");
+    for (unsigned i = 0; i < g_sched.count; i++) {
+        const scomx_subscription_t *sub = &g_subscriptions[i];
+        printf("%-8u %8u %6lu %6lu %8lu %8u %6lu\n", sub->object_id, sub->period_ms, sub->reads, sub->errors, sub->missed_deadlines, sub->cost_ms,
+               g_filters[i].passed);
+        passed += g_filters[i].passed;
+        suppressed += g_filters[i].suppressed;
+    }
+
+    scomx_sched_stats_t stats = scomx_sched_stats(&g_sched, serial_now_ms());
+    printf("issued %lu, completed %lu, errors %lu, missed deadlines %lu\n", stats.issued, stats.completed, stats.errors, stats.missed_deadlines);
+    printf("link utilization %.0f%%, demand %.0f%%\n", stats.utilization * 100, stats.demand * 100);
+    printf("%lu of %lu samples passed the change filters\n", passed, passed + suppressed);
+    printf("%lu messages (%lu lost) from %lu reads, %lu RCC resets, %lu flag changes\n", g_msglog.delivered, g_msglog.lost, g_msglog.reads, g_rcc_resets,
+           g_port.flags.changes);
+
+    if (capture_path) {
+        gateway_loop_flush_capture(&loop);
+        printf("%lu records captured, %lu dropped, %lu write errors\n", g_capture.records, g_capture.dropped, loop.capture_errors);
+        close(loop.capture_fd);
+    }
+
+    snapshot_file_close(&g_snapshot);
+    serial_close(&g_port.serial);
+    gateway_loop_close(&loop);
+
+    return 0;
+}
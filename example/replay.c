@@ -0,0 +1,187 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../scomlib_extra/scomlib_extra.h"
+#include "serial.h"
+
+// Feeds a capture written by scomtest or scompoll -c back through the frame parser, either as fast
+// as possible to measure decoding on real traffic, or at the pace the bytes were captured.
+
+#define MAX_FRAME_SIZE 256
+#define PORT_IDS 256
+
+static const char *k_direction_names[] = {"tx", "rx"};
+
+// streams are parsed separately by port and direction, as they were received
+static scomx_parser_t g_parsers[PORT_IDS][2];
+static char g_parser_buffers[PORT_IDS][2][MAX_FRAME_SIZE];
+
+typedef struct {
+    unsigned long records;
+    unsigned long bytes;
+    unsigned long frames[2];
+    unsigned long errors[2];
+} replay_stats_t;
+
+static char *load_file(const char *path, size_t *length)
+{
+    FILE *f = fopen(path, "rb");
+    char *data = NULL;
+    long size;
+
+    if (!f) {
+        perror(path);
+        return NULL;
+    }
+    if (fseek(f, 0, SEEK_END) == 0 && (size = ftell(f)) >= 0 && fseek(f, 0, SEEK_SET) == 0) {
+        data = (char *)malloc(size ? size : 1);
+        if (data && fread(data, 1, size, f) != (size_t)size) {
+            free(data);
+            data = NULL;
+        }
+        *length = (size_t)size;
+    }
+    if (!data) {
+        perror(path);
+    }
+    fclose(f);
+
+    return data;
+}
+
+static void print_frame(const scomx_capture_record_t *rec, int64_t first_us, const scomx_dec_result_t *res)
+{
+    printf("%10.3f ms port %u %s: ", (rec->timestamp_us - first_us) / 1000.0, rec->port, k_direction_names[rec->direction]);
+    if (res->error != SCOM_ERROR_NO_ERROR) {
+        printf("from %u to %u, %s\n", res->src_addr, res->dst_addr, scomx_err2str(res->error));
+    } else if (rec->direction == SCOMX_CAPTURE_TX) {
+        printf("to %u, service %u, object %u/%u, property %u\n", res->dst_addr, res->service_id, res->object_type, res->object_id, res->property_id);
+    } else {
+        scomx_typed_value_t v = scomx_decode_typed(res);
+        printf("from %u, object %u/%u, property %u, value %.3f\n", res->src_addr, res->object_type, res->object_id, res->property_id, v.value);
+    }
+}
+
+// replays the records once; returns -1 when the capture is corrupted
+static int replay(const char *data, size_t length, int paced, int verbose, replay_stats_t *stats)
+{
+    scomx_capture_record_t rec;
+    long offset = scomx_capture_check_header(data, length);
+    long n = 0;
+    int64_t first_us = -1;
+    int64_t start_us = serial_now_us();
+
+    if (offset < 0) {
+        return -1;
+    }
+
+    while ((n = scomx_capture_next(data + offset, length - offset, &rec)) > 0) {
+        offset += n;
+
+        if (first_us < 0) {
+            first_us = rec.timestamp_us;
+        }
+        stats->records++;
+        stats->bytes += rec.length;
+
+        if (paced) {
+            int64_t wait_us = (rec.timestamp_us - first_us) - (serial_now_us() - start_us);
+            if (wait_us > 0) {
+                usleep((useconds_t)wait_us);
+            }
+        }
+
+        scomx_parser_t *parser = &g_parsers[rec.port][rec.direction];
+        size_t pushed = 0;
+        for (;;) {
+            scomx_parse_result_t parsed = scomx_parser_push(parser, rec.data + pushed, rec.length - pushed);
+            pushed += parsed.consumed;
+            if (!parsed.frame_ready) {
+                break;
+            }
+
+            stats->frames[rec.direction]++;
+            if (parsed.result.error != SCOM_ERROR_NO_ERROR) {
+                stats->errors[rec.direction]++;
+            }
+            if (verbose) {
+                print_frame(&rec, first_us, &parsed.result);
+            }
+        }
+    }
+
+    return n < 0 ? -1 : 0;
+}
+
+int main(int argc, const char *argv[])
+{
+    int paced = 0, verbose = 0;
+    unsigned repeat = 1;
+    int arg = 1;
+
+    for (; arg < argc && argv[arg][0] == '-'; arg++) {
+        if (strcmp(argv[arg], "-p") == 0) {
+            paced = 1;
+        } else if (strcmp(argv[arg], "-v") == 0) {
+            verbose = 1;
+        } else if (strcmp(argv[arg], "-n") == 0 && arg + 1 < argc) {
+            repeat = (unsigned)atoi(argv[++arg]);
+        } else {
+            break;
+        }
+    }
+    if (arg + 1 != argc) {
+        printf("Usage: %s [-p] [-v] [-n times] <capture file>\n", argv[0]);
+        printf("  -p  replay at the pace the bytes were captured instead of as fast as possible\n");
+        printf("  -v  print every frame\n");
+        printf("  -n  replay the capture several times, e.g. to measure decoding\n");
+        return 1;
+    }
+
+    size_t length = 0;
+    char *data = load_file(argv[arg], &length);
+    if (!data) {
+        return 1;
+    }
+
+    for (unsigned port = 0; port < PORT_IDS; port++) {
+        for (unsigned dir = 0; dir < 2; dir++) {
+            scomx_parser_init(&g_parsers[port][dir], g_parser_buffers[port][dir], MAX_FRAME_SIZE);
+        }
+        g_parsers[port][SCOMX_CAPTURE_TX].decode_requests = 1;
+    }
+
+    replay_stats_t stats;
+    memset(&stats, 0, sizeof(stats));
+
+    int64_t start = serial_now_us();
+    for (unsigned i = 0; i < repeat; i++) {
+        if (replay(data, length, paced, verbose, &stats) != 0) {
+            printf("%s: not a capture or corrupted after %lu records\n", argv[arg], stats.records);
+            free(data);
+            return 1;
+        }
+    }
+    double elapsed = (serial_now_us() - start) / 1e6;
+
+    unsigned long rejected = 0, discarded = 0;
+    for (unsigned port = 0; port < PORT_IDS; port++) {
+        for (unsigned dir = 0; dir < 2; dir++) {
+            rejected += g_parsers[port][dir].frames_rejected;
+            discarded += g_parsers[port][dir].bytes_discarded;
+        }
+    }
+
+    printf("%lu records, %lu bytes: %lu requests, %lu responses (%lu with an error)\n", stats.records, stats.bytes, stats.frames[SCOMX_CAPTURE_TX],
+           stats.frames[SCOMX_CAPTURE_RX], stats.errors[SCOMX_CAPTURE_RX]);
+    printf("%lu frames rejected, %lu bytes discarded\n", rejected, discarded);
+    if (!paced && elapsed > 0) {
+        printf("%.3f s, %.1f MB/s, %.0f frames/s\n", elapsed, stats.bytes / elapsed / 1e6, (stats.frames[0] + stats.frames[1]) / elapsed);
+    }
+
+    free(data);
+
+    return 0;
+}
@@ -9,15 +9,44 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <stdio.h>
 #include <string.h>
 #include <strings.h>
 #include <termios.h>
+#include <time.h>
 #include <unistd.h>
 
 #define error_message(fmt, ...) fprintf(stderr, fmt, __VA_ARGS__)
 
-int serial_fd = 0;
+// how long the legacy API waits for the device to start responding
+#define LEGACY_RESPONSE_TIMEOUT_MS 2000
+
+static serial_port_t g_port = {-1, 0, 0};
+
+static unsigned speed_to_baud(int speed)
+{
+    switch (speed) {
+    case B1200:
+        return 1200;
+    case B2400:
+        return 2400;
+    case B4800:
+        return 4800;
+    case B9600:
+        return 9600;
+    case B19200:
+        return 19200;
+    case B38400:
+        return 38400;
+    case B57600:
+        return 57600;
+    case B115200:
+        return 115200;
+    default:
+        return 0;
+    }
+}
 
 static int set_interface_attribs(int fd, int speed, serial_parity_t parity, int stop_bits)
 {
@@ -43,57 +72,180 @@ static int set_interface_attribs(int fd, int speed, serial_parity_t parity, int
     tio.c_oflag = 0;
     tio.c_lflag = 0; // will be noncanonical mode (ICANON not set)
 
-    // set blocking
-    tio.c_cc[VMIN] = 255; // minimum number of characters for noncanonical read
-    tio.c_cc[VTIME] = 20; // 2 second read timeout
+    // reads return immediately with whatever is available, waiting is done with poll()
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
 
     if (tcsetattr(fd, TCSANOW, &tio) != 0) {
-        error_message("tcsetattr error %d: %s", errno, strerror(errno));
+        error_message("tcsetattr error %d: %s\n", errno, strerror(errno));
         return -1;
     }
 
     return 0;
 }
 
-int serial_init(const char *port_path, int speed, serial_parity_t parity, int stop_bits)
+// waits until fd is ready for events or the deadline expires; returns 1 when ready, 0 on timeout, -1 on error
+static int wait_fd(int fd, short events, int64_t deadline_ms)
 {
-    int ret;
+    for (;;) {
+        int64_t remaining = deadline_ms - serial_now_ms();
+        if (remaining <= 0) {
+            return 0;
+        }
+
+        struct pollfd pfd = {fd, events, 0};
+        int ret = poll(&pfd, 1, (int)remaining);
 
-    serial_fd = open(port_path, O_RDWR | O_NOCTTY);
-    if (serial_fd < 0) {
-        error_message("error %d opening %s: %s", errno, port_path, strerror(errno));
-        return serial_fd;
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        } else if (ret < 0) {
+            return -1;
+        } else if (ret == 0) {
+            return 0;
+        } else if ((pfd.revents & (POLLERR | POLLNVAL)) || ((pfd.revents & POLLHUP) && !(pfd.revents & events))) {
+            errno = EIO;
+            return -1;
+        }
+
+        return 1;
     }
+}
+
+static serial_io_result_t io_result(serial_status_t status, unsigned length)
+{
+    serial_io_result_t res = {status, length};
+    return res;
+}
+
+int serial_open(serial_port_t *port, const char *port_path, int speed, serial_parity_t parity, int stop_bits)
+{
+    port->fd = open(port_path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (port->fd < 0) {
+        error_message("error %d opening %s: %s\n", errno, port_path, strerror(errno));
+        return -1;
+    }
+
+    port->baud = speed_to_baud(speed);
+    port->bits_per_char = 1 + 8 + (parity ? 1 : 0) + (stop_bits == 2 ? 2 : 1);
 
     // set speed and parity
-    if ((ret = set_interface_attribs(serial_fd, speed, parity, stop_bits)) < 0) {
-        return ret;
+    if (set_interface_attribs(port->fd, speed, parity, stop_bits) < 0) {
+        serial_close(port);
+        return -1;
     }
 
     return 0;
 }
 
-// write to serial port size bytes from ptr
-int serial_write(const void *ptr, unsigned size) { return write(serial_fd, ptr, size); }
+void serial_close(serial_port_t *port)
+{
+    if (port->fd >= 0) {
+        close(port->fd);
+        port->fd = -1;
+    }
+}
 
-// read size bytes from serial into ptr buffer
-int serial_read(void *ptr, unsigned size)
+int64_t serial_now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int64_t serial_now_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+unsigned serial_transfer_ms(const serial_port_t *port, unsigned bytes)
+{
+    if (port->baud == 0) {
+        return 0;
+    }
+    return (unsigned)(((uint64_t)bytes * port->bits_per_char * 1000 + port->baud - 1) / port->baud);
+}
+
+serial_io_result_t serial_write_until(serial_port_t *port, const void *ptr, unsigned size, int64_t deadline_ms)
+{
+    const unsigned char *buf = (const unsigned char *)ptr;
+    unsigned written = 0;
+
+    while (written < size) {
+        ssize_t ret = write(port->fd, buf + written, size - written);
+
+        if (ret > 0) {
+            written += ret;
+            continue;
+        } else if (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            return io_result(SERIAL_ERROR, written);
+        }
+
+        int ready = wait_fd(port->fd, POLLOUT, deadline_ms);
+        if (ready < 0) {
+            return io_result(SERIAL_ERROR, written);
+        } else if (ready == 0) {
+            return io_result(written ? SERIAL_PARTIAL : SERIAL_TIMEOUT, written);
+        }
+    }
+
+    return io_result(SERIAL_OK, written);
+}
+
+serial_io_result_t serial_read_until(serial_port_t *port, void *ptr, unsigned size, int64_t deadline_ms)
 {
     unsigned char *buf = (unsigned char *)ptr;
     unsigned bts_read = 0;
 
     while (bts_read < size) {
-        int ret = read(serial_fd, buf + bts_read, size - bts_read);
+        serial_io_result_t res = serial_read_some(port, buf + bts_read, size - bts_read, deadline_ms);
 
-        if (ret < 0) {
-            return ret;
-        } else if (ret == 0) {
-            // timeout
-            return bts_read;
+        bts_read += res.length;
+
+        if (res.status == SERIAL_ERROR) {
+            return io_result(SERIAL_ERROR, bts_read);
+        } else if (res.status != SERIAL_OK) {
+            return io_result(bts_read ? SERIAL_PARTIAL : SERIAL_TIMEOUT, bts_read);
         }
+    }
 
-        bts_read += ret;
+    return io_result(SERIAL_OK, bts_read);
+}
+
+serial_io_result_t serial_read_some(serial_port_t *port, void *ptr, unsigned size, int64_t deadline_ms)
+{
+    for (;;) {
+        ssize_t ret = read(port->fd, ptr, size);
+
+        if (ret > 0) {
+            return io_result(SERIAL_OK, ret);
+        } else if (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            return io_result(SERIAL_ERROR, 0);
+        }
+
+        // nothing available yet (a tty returns 0 with VMIN=0)
+        int ready = wait_fd(port->fd, POLLIN, deadline_ms);
+        if (ready < 0) {
+            return io_result(SERIAL_ERROR, 0);
+        } else if (ready == 0) {
+            return io_result(SERIAL_TIMEOUT, 0);
+        }
     }
+}
+
+int serial_init(const char *port_path, int speed, serial_parity_t parity, int stop_bits) { return serial_open(&g_port, port_path, speed, parity, stop_bits); }
 
-    return bts_read;
-}
\ No newline at end of file
+// write to serial port size bytes from ptr
+int serial_write(const void *ptr, unsigned size)
+{
+    serial_io_result_t res = serial_write_until(&g_port, ptr, size, serial_now_ms() + serial_transfer_ms(&g_port, size) + LEGACY_RESPONSE_TIMEOUT_MS);
+    return res.status == SERIAL_ERROR && res.length == 0 ? -1 : (int)res.length;
+}
+
+// read size bytes from serial into ptr buffer
+int serial_read(void *ptr, unsigned size)
+{
+    serial_io_result_t res = serial_read_until(&g_port, ptr, size, serial_now_ms() + serial_transfer_ms(&g_port, size) + LEGACY_RESPONSE_TIMEOUT_MS);
+    return res.status == SERIAL_ERROR && res.length == 0 ? -1 : (int)res.length;
+}
@@ -1,4 +1,8 @@
+#ifndef SERIAL_H
+#define SERIAL_H
+
 #include <stdbool.h>
+#include <stdint.h>
 
 typedef enum {
     PARITY_NONE = 0,
@@ -6,11 +10,63 @@ typedef enum {
     PARITY_ODD = (1 << 1),
 } serial_parity_t;
 
+typedef struct {
+    // file descriptor opened with O_NONBLOCK, -1 when closed
+    int fd;
+    // line speed in bits per second
+    unsigned baud;
+    // bits on the wire per transferred byte (start, data, parity and stop bits)
+    unsigned bits_per_char;
+} serial_port_t;
+
+typedef enum {
+    SERIAL_OK = 0,      // all requested bytes were transferred
+    SERIAL_PARTIAL = 1, // the deadline expired after transferring some of the bytes
+    SERIAL_TIMEOUT = 2, // the deadline expired before transferring anything
+    SERIAL_ERROR = 3,   // the transfer failed, see errno
+} serial_status_t;
+
+typedef struct {
+    serial_status_t status;
+    // number of bytes transferred, also on partial transfer
+    unsigned length;
+} serial_io_result_t;
+
+// NON-BLOCKING API
+
+// open the port in non-blocking mode; speed is a termios constant like B38400
+int serial_open(serial_port_t *port, const char *port_path, int speed, serial_parity_t parity, int stop_bits);
+
+// close the port
+void serial_close(serial_port_t *port);
+
+// monotonic time in milliseconds used for the deadlines
+int64_t serial_now_ms();
+
+// the same clock in microseconds, e.g. for capture timestamps
+int64_t serial_now_us();
+
+// time in milliseconds it takes to transfer the given number of bytes at the port speed, rounded up
+unsigned serial_transfer_ms(const serial_port_t *port, unsigned bytes);
+
+// write size bytes from ptr, waiting for the port to accept them until the absolute deadline
+serial_io_result_t serial_write_until(serial_port_t *port, const void *ptr, unsigned size, int64_t deadline_ms);
+
+// read exactly size bytes into ptr, waiting for them until the absolute deadline
+serial_io_result_t serial_read_until(serial_port_t *port, void *ptr, unsigned size, int64_t deadline_ms);
+
+// read whatever is available (up to size bytes) with a single read, waiting for the first byte until the absolute deadline
+serial_io_result_t serial_read_some(serial_port_t *port, void *ptr, unsigned size, int64_t deadline_ms);
+
+// LEGACY SINGLE PORT API
+
 // initialize the serial port
 int serial_init(const char *port_path, int speed, serial_parity_t parity, int stop_bits);
 
 // write to serial port size bytes from ptr
 int serial_write(const void *ptr, unsigned size);
 
-// read size bytes from serial into ptr buffer
-int serial_read(void *ptr, unsigned size);
\ No newline at end of file
+// read size bytes from serial into ptr buffer, giving up when they don't arrive in time
+int serial_read(void *ptr, unsigned size);
+
+#endif
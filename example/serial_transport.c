@@ -0,0 +1,28 @@
+#include "serial_transport.h"
+
+static long transport_write(void *user, const char *data, size_t length, int64_t deadline_ms)
+{
+    serial_io_result_t io = serial_write_until((serial_port_t *)user, data, length, deadline_ms);
+    return io.status == SERIAL_ERROR ? -1 : (long)io.length;
+}
+
+static long transport_read(void *user, char *buffer, size_t size, int64_t deadline_ms)
+{
+    serial_io_result_t io = serial_read_some((serial_port_t *)user, buffer, size, deadline_ms);
+    return io.status == SERIAL_ERROR ? -1 : (long)io.length;
+}
+
+static int64_t transport_now_ms(void *user)
+{
+    (void)user;
+    return serial_now_ms();
+}
+
+void serial_transport_init(scomx_transport_t *transport, serial_port_t *port, unsigned max_response_size)
+{
+    transport->user = port;
+    transport->write = transport_write;
+    transport->read = transport_read;
+    transport->now_ms = transport_now_ms;
+    transport->timeout_ms = serial_transfer_ms(port, SCOMX_READ_REQUEST_SIZE) + SERIAL_TRANSPORT_LATENCY_MS + serial_transfer_ms(port, max_response_size);
+}
@@ -0,0 +1,13 @@
+#ifndef SERIAL_TRANSPORT_H
+#define SERIAL_TRANSPORT_H
+
+#include "../scomlib_extra/scomlib_extra.h"
+#include "serial.h"
+
+// time the gateway may take to start responding after receiving a request
+#define SERIAL_TRANSPORT_LATENCY_MS 500
+
+// set up transport to use the opened port, allowing for a response of up to max_response_size bytes
+void serial_transport_init(scomx_transport_t *transport, serial_port_t *port, unsigned max_response_size);
+
+#endif
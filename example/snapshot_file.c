@@ -0,0 +1,78 @@
+#include "snapshot_file.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+int snapshot_file_create(snapshot_file_t *file, const char *path, size_t capacity)
+{
+    size_t size = scomx_snapshot_size(capacity);
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+
+    if (fd < 0 || ftruncate(fd, (off_t)size) != 0) {
+        perror(path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+
+    void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        perror(path);
+        return -1;
+    }
+
+    file->memory = memory;
+    file->size = size;
+
+    return scomx_snapshot_create(&file->snap, memory, size);
+}
+
+int snapshot_file_open(snapshot_file_t *file, const char *path)
+{
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    if ((size_t)st.st_size < scomx_snapshot_size(0)) {
+        fprintf(stderr, "%s: not a snapshot\n", path);
+        close(fd);
+        return -1;
+    }
+
+    void *memory = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        perror(path);
+        return -1;
+    }
+
+    file->memory = memory;
+    file->size = (size_t)st.st_size;
+
+    if (scomx_snapshot_attach(&file->snap, memory, file->size) != 0) {
+        fprintf(stderr, "%s: not a snapshot\n", path);
+        snapshot_file_close(file);
+        return -1;
+    }
+
+    return 0;
+}
+
+void snapshot_file_close(snapshot_file_t *file)
+{
+    if (file->memory) {
+        munmap(file->memory, file->size);
+        file->memory = NULL;
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef SNAPSHOT_FILE_H
+#define SNAPSHOT_FILE_H
+
+#include "../scomlib_extra/scomlib_extra.h"
+
+// Snapshot of the latest values in a file mapped by the publisher and every reader, e.g. in
+// /dev/shm. A publisher starting again with the same capacity keeps the size of the file, so the
+// readers still mapping it aren't cut off; they see the generation change and find their slots again.
+
+typedef struct {
+    scomx_snapshot_t snap;
+    // mapping of the whole file
+    void *memory;
+    size_t size;
+} snapshot_file_t;
+
+// creates or reuses the file at path with room for capacity slots and initializes it as publisher
+int snapshot_file_create(snapshot_file_t *file, const char *path, size_t capacity);
+// maps the file at path read-only and attaches to the snapshot
+int snapshot_file_open(snapshot_file_t *file, const char *path);
+void snapshot_file_close(snapshot_file_t *file);
+
+#endif
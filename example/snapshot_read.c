@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "serial.h"
+#include "snapshot_file.h"
+
+// values older than this are flagged, e.g. when the publisher stopped
+#define STALE_MS 5000
+
+#define MAX_OBJECTS 64
+
+// the properties to print, found again when the publisher starts over
+typedef struct {
+    uint32_t object_ids[MAX_OBJECTS];
+    int slots[MAX_OBJECTS];
+    unsigned count;
+    uint32_t generation;
+} watch_t;
+
+static void find_slots(watch_t *w, const scomx_snapshot_t *snap)
+{
+    w->generation = scomx_snapshot_generation(snap);
+    for (unsigned i = 0; i < w->count; i++) {
+        w->slots[i] = scomx_snapshot_find(snap, SCOMX_DEST_XTM(0), SCOM_USER_INFO_OBJECT_TYPE, w->object_ids[i]);
+    }
+}
+
+static void print_value(const scomx_snapshot_t *snap, uint32_t object_id, int slot, int64_t now)
+{
+    const scomx_object_meta_t *meta = scomx_object_meta(SCOM_USER_INFO_OBJECT_TYPE, object_id);
+    scomx_sample_t sample;
+
+    printf("%-45s ", meta ? meta->name : "");
+    if (slot < 0) {
+        printf("not published\n");
+    } else if (scomx_snapshot_read(snap, slot, &sample) != 0) {
+        printf("no value\n");
+    } else if (sample.error != SCOM_ERROR_NO_ERROR) {
+        printf("%s\n", scomx_err2str(sample.error));
+    } else {
+        printf("%10.2f %-4s %6lld ms ago%s\n", sample.value, meta ? meta->unit : "", (long long)(now - sample.timestamp_ms),
+               now - sample.timestamp_ms > STALE_MS ? ", stale" : "");
+    }
+}
+
+int main(int argc, const char *argv[])
+{
+    snapshot_file_t file = {0};
+    watch_t watch = {0};
+
+    if (argc < 3) {
+        printf("Usage: %s <snapshot file> <seconds> [object id...]\n", argv[0]);
+        return 1;
+    }
+
+    int seconds = atoi(argv[2]);
+    for (int i = 3; i < argc && watch.count < MAX_OBJECTS; i++) {
+        watch.object_ids[watch.count++] = (uint32_t)atoi(argv[i]);
+    }
+
+    if (snapshot_file_open(&file, argv[1]) != 0) {
+        return 1;
+    }
+    find_slots(&watch, &file.snap);
+
+    for (int t = 0; t < seconds; t++) {
+        sleep(1);
+
+        // the region was initialized again, possibly with other slots
+        if (scomx_snapshot_generation(&file.snap) != watch.generation) {
+            snapshot_file_close(&file);
+            if (snapshot_file_open(&file, argv[1]) != 0) {
+                return 1;
+            }
+            find_slots(&watch, &file.snap);
+            printf("publisher restarted, generation %u\n", watch.generation);
+        }
+
+        int64_t now = serial_now_ms();
+        if (watch.count > 0) {
+            for (unsigned i = 0; i < watch.count; i++) {
+                print_value(&file.snap, watch.object_ids[i], watch.slots[i], now);
+            }
+        } else {
+            // every slot published so far
+            uint32_t count = __atomic_load_n(&file.snap.header->count, __ATOMIC_ACQUIRE);
+            for (uint32_t i = 0; i < count; i++) {
+                print_value(&file.snap, file.snap.slots[i].object_id, (int)i, now);
+            }
+        }
+        printf("\n");
+    }
+
+    snapshot_file_close(&file);
+
+    return 0;
+}
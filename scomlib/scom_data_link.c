@@ -69,8 +69,6 @@ THE SOFTWARE.
 
 
 /* ----------- private definitions ---------------- */
-static uint16_t scom_calc_checksum(    const char *data,
-                                       uint_fast16_t length);
 
 #define SCOM_START_BYTE 0xAA
 
@@ -134,6 +132,42 @@ void scom_encode_request_frame(scom_frame_t* frame)
 }
 
 
+/**
+ * \brief encode a response frame in its buffer, as sent back by a device
+ *
+ * This is the counterpart of scom_encode_request_frame() for implementing a device or a simulator of one.
+ * The frame must have been initialized with scom_initialize_frame().
+ * The frame fields frame_flags, src_addr, dst_addr, service_flags, service_id and data_length must have a valid value.
+ * service_flags.is_response is always encoded as set.
+ */
+void scom_encode_response_frame(scom_frame_t* frame)
+{
+    uint8_t flags;
+
+    scom_encode_request_frame(frame);
+
+    if(frame->last_error == SCOM_ERROR_NO_ERROR) {
+        flags = (uint8_t)(((frame->frame_flags.reserved7to5 & 0x7) << 5)
+                          | ((frame->frame_flags.is_new_datalogger_file_present & 0x1) << 4)
+                          | ((frame->frame_flags.is_sd_card_full & 0x1) << 3)
+                          | ((frame->frame_flags.is_sd_card_present & 0x1) << 2)
+                          | ((frame->frame_flags.was_rcc_reseted & 0x1) << 1)
+                          | ((frame->frame_flags.is_message_pending & 0x1) << 0));
+        frame->buffer[1] = (char)flags;
+
+        flags = (uint8_t)(((frame->service_flags.reserved7to2 & 0x3F) << 2)
+                          | (1 << 1)
+                          | ((frame->service_flags.error & 0x1) << 0));
+        frame->buffer[SCOM_FRAME_HEADER_SIZE] = (char)flags;
+
+        /* both checksums cover the changed flags */
+        scom_write_le16(&frame->buffer[12], scom_calc_checksum(&frame->buffer[1], SCOM_FRAME_HEADER_SIZE - 1 - 2));
+        scom_write_le16(&frame->buffer[SCOM_FRAME_HEADER_SIZE + frame->data_length],
+                        scom_calc_checksum(&frame->buffer[SCOM_FRAME_HEADER_SIZE], frame->data_length));
+    }
+}
+
+
 /**
  * \brief decode the frame header from its buffer
  *
@@ -250,7 +284,7 @@ size_t scom_frame_length(scom_frame_t* frame)
  * \brief calculate the checksum on a buffer
  * based on RFC1146, Appendix I
  *
- * @param checksum a pointer to the 2 bytes of the checksum
+ * @param data the data to checksum
  * @param length number of byte of the data
  * @return the checksum value
  *
@@ -201,11 +201,14 @@ typedef struct {
 
 void scom_initialize_frame(scom_frame_t* frame, char* buffer, size_t buffer_size);
 void scom_encode_request_frame(scom_frame_t* frame);
+void scom_encode_response_frame(scom_frame_t* frame);
 void scom_decode_frame_header(scom_frame_t* frame);
 void scom_decode_frame_data(scom_frame_t* frame);
 
 size_t scom_frame_length(scom_frame_t* frame);
 
+uint16_t scom_calc_checksum(const char *data, uint_fast16_t length);
+
 
 #ifdef __cplusplus
 }
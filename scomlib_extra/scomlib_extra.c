@@ -3,11 +3,10 @@
 
 #include <string.h>
 
-// allocate memory on the heap
+// buffer of the legacy API context
 // normally only a single serial port is used so there is no need to use multiple buffers
 static char g_buffer[256];
-static scom_frame_t g_frame;
-static scom_property_t g_property;
+static scomx_ctx_t g_ctx = {.buffer = g_buffer, .buffer_size = sizeof(g_buffer)};
 
 #define SCOM_SERVICE_HEADER_SIZE 2
 #define SCOM_PROPERTY_HEADER_SIZE 8
@@ -25,255 +24,577 @@ static void scom_decode_property_header(scom_property_t *property)
     property->property_id = scom_read_le16(&header[6]);
 }
 
-static void reset_frame()
+// same as scom_decode_frame_data(), with the data checksum computed by the caller, e.g. while copying
+// the data, by the vector kernels which are much faster on datalog and other large frames
+static void decode_frame_data(scom_frame_t *frame, uint16_t data_checksum)
+{
+    if (frame->last_error != SCOM_ERROR_NO_ERROR) {
+        return;
+    }
+
+    if (data_checksum != scom_read_le16(&frame->buffer[SCOM_FRAME_HEADER_SIZE + frame->data_length])) {
+        frame->last_error = SCOM_ERROR_INVALID_FRAME;
+    }
+
+    uint8_t flags = frame->buffer[SCOM_FRAME_HEADER_SIZE];
+    frame->service_flags.reserved7to2 = (flags >> 2) & 0x3F;
+    frame->service_flags.is_response = (flags >> 1) & 0x1;
+    frame->service_flags.error = (flags >> 0) & 0x1;
+
+    if (!frame->service_flags.is_response) {
+        frame->last_error = SCOM_ERROR_INVALID_FRAME;
+    }
+
+    frame->service_id = (scom_service_t)frame->buffer[SCOM_FRAME_HEADER_SIZE + 1];
+}
+
+// decodes the read or write property service of a received frame into the dec result
+static void decode_property_response(scom_frame_t *frame, scom_property_t *property, scomx_dec_result_t *res)
+{
+    res->error = frame->last_error;
+
+    res->src_addr = frame->src_addr;
+    res->dst_addr = frame->dst_addr;
+    res->service_id = frame->service_id;
+    res->frame_flags = frame->frame_flags;
+    res->has_frame_flags = 1;
+
+    // reuse the structure
+    scom_initialize_property(property, frame);
+
+    // decode the read or write property service
+    ptrdiff_t length = (ptrdiff_t)frame->data_length - SCOM_SERVICE_HEADER_SIZE - SCOM_PROPERTY_HEADER_SIZE;
+
+    if (!frame->service_flags.error && length >= 0 && length <= (ptrdiff_t)property->value_buffer_size) {
+        // property looks ok
+        property->value_length = length;
+        scom_decode_property_header(property);
+    } else if (frame->service_flags.error) {
+        // decode application error
+        if (length == 2) {
+            res->error = (scom_error_t)scom_read_le16(property->value_buffer);
+        } else {
+            res->error = SCOM_ERROR_INVALID_FRAME;
+        }
+        return;
+    } else {
+        // no application error but value over the property buffer size
+        res->error = SCOM_ERROR_STACK_BUFFER_TOO_SMALL;
+        return;
+    }
+
+    // copy property data into the dec result
+    res->object_type = property->object_type;
+    res->object_id = property->object_id;
+    res->property_id = property->property_id;
+
+    res->data = property->value_buffer;
+    res->length = property->value_length;
+}
+
+static void reset_frame(scomx_ctx_t *ctx)
 {
     // init frame
-    scom_initialize_frame(&g_frame, g_buffer, sizeof(g_buffer));
+    scom_initialize_frame(&ctx->frame, ctx->buffer, ctx->buffer_size);
 
-    // clear the buffer just in case
-    memset(g_frame.buffer, 0, g_frame.buffer_size);
+    // clear the headers just in case; every other byte of a frame is written when encoding it
+    memset(ctx->frame.buffer, 0, ctx->frame.buffer_size < SCOM_PROPERTY_VALUE_OFFSET ? ctx->frame.buffer_size : SCOM_PROPERTY_VALUE_OFFSET);
 
     // init property
-    scom_initialize_property(&g_property, &g_frame);
+    scom_initialize_property(&ctx->property, &ctx->frame);
 }
 
-static scomx_enc_result_t encode_request_frame()
+static scomx_enc_result_t encode_request_frame(scomx_ctx_t *ctx)
 {
     scomx_enc_result_t res;
 
     memset(&res, 0, sizeof(res));
 
     // check error of the previous scomx_encode_*_property call done on this frame
-    if (g_frame.last_error != SCOM_ERROR_NO_ERROR) {
-        res.error = g_frame.last_error;
+    if (ctx->frame.last_error != SCOM_ERROR_NO_ERROR) {
+        res.error = ctx->frame.last_error;
         return res;
     }
 
-    scom_encode_request_frame(&g_frame);
+    scom_encode_request_frame(&ctx->frame);
 
-    res.error = g_frame.last_error;
-    res.data = g_frame.buffer;
-    res.length = scom_frame_length(&g_frame);
+    res.error = ctx->frame.last_error;
+    res.data = ctx->frame.buffer;
+    res.length = scom_frame_length(&ctx->frame);
 
     return res;
 }
 
-scomx_enc_result_t scomx_encode_read_property(uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id)
+void scomx_ctx_init(scomx_ctx_t *ctx, char *buffer, size_t buffer_size)
+{
+    memset(ctx, 0, sizeof(*ctx));
+
+    ctx->buffer = buffer;
+    ctx->buffer_size = buffer_size;
+}
+
+scomx_enc_result_t scomx_ctx_encode_read_property(scomx_ctx_t *ctx, uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id)
 {
-    reset_frame();
+    reset_frame(ctx);
 
-    g_frame.src_addr = 1; // our address
-    g_frame.dst_addr = dst_addr;
+    ctx->frame.src_addr = 1; // our address
+    ctx->frame.dst_addr = dst_addr;
 
-    g_property.object_type = object_type;
-    g_property.object_id = object_id;
-    g_property.property_id = property_id;
+    ctx->property.object_type = object_type;
+    ctx->property.object_id = object_id;
+    ctx->property.property_id = property_id;
 
-    scom_encode_read_property(&g_property);
+    scom_encode_read_property(&ctx->property);
 
-    return encode_request_frame();
+    return encode_request_frame(ctx);
 }
 
-scomx_enc_result_t scomx_encode_write_property(uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id, const char *const data,
-                                               size_t data_len)
+void scomx_encode_read_request_frame(char *frame, uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id)
 {
-    reset_frame();
+    char *header = frame + SCOM_PROPERTY_HEADER_OFFSET;
+
+    frame[0] = (char)SCOMX_START_BYTE;
+    frame[1] = 0; // frame flags of a request
+    scom_write_le32(&frame[2], 1); // our address
+    scom_write_le32(&frame[6], dst_addr);
+    scom_write_le16(&frame[10], SCOM_SERVICE_HEADER_SIZE + SCOM_PROPERTY_HEADER_SIZE);
+    scom_write_le16(&frame[12], scom_calc_checksum(&frame[1], SCOM_FRAME_HEADER_SIZE - 1 - 2));
+
+    frame[SCOM_FRAME_HEADER_SIZE] = 0; // service flags of a request
+    frame[SCOM_FRAME_HEADER_SIZE + 1] = SCOM_READ_PROPERTY_SERVICE;
+    scom_write_le16(&header[0], object_type);
+    scom_write_le32(&header[2], object_id);
+    scom_write_le16(&header[6], property_id);
+    scom_write_le16(&frame[SCOM_PROPERTY_VALUE_OFFSET], scom_calc_checksum(&frame[SCOM_FRAME_HEADER_SIZE], SCOM_SERVICE_HEADER_SIZE + SCOM_PROPERTY_HEADER_SIZE));
+}
 
-    g_frame.src_addr = 1; // our address
-    g_frame.dst_addr = dst_addr;
+scomx_enc_result_t scomx_ctx_encode_write_property(scomx_ctx_t *ctx, uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id,
+                                                   const char *const data, size_t data_len)
+{
+    reset_frame(ctx);
 
-    g_property.object_type = object_type;
-    g_property.object_id = object_id;
-    g_property.property_id = property_id;
+    ctx->frame.src_addr = 1; // our address
+    ctx->frame.dst_addr = dst_addr;
 
-    g_property.value_length = data_len;
+    ctx->property.object_type = object_type;
+    ctx->property.object_id = object_id;
+    ctx->property.property_id = property_id;
 
-    // ensure data fits into the buffer
-    if (scom_frame_length(&g_frame) > g_frame.buffer_size) {
+    // ensure data and the trailing data checksum fit into the buffer
+    if (ctx->buffer_size < SCOM_PROPERTY_VALUE_OFFSET + 2 || data_len > ctx->property.value_buffer_size - 2) {
         scomx_enc_result_t res;
+        memset(&res, 0, sizeof(res));
         res.error = SCOM_ERROR_STACK_BUFFER_TOO_SMALL;
         return res;
     }
 
     // scom requires continuous buffer so we must copy the data into the buffer
-    g_property.value_length = data_len;
-    memcpy(g_property.value_buffer, data, data_len);
+    ctx->property.value_length = data_len;
+    memcpy(ctx->property.value_buffer, data, data_len);
 
-    scom_encode_write_property(&g_property);
+    scom_encode_write_property(&ctx->property);
 
-    return encode_request_frame();
+    return encode_request_frame(ctx);
 }
 
-scomx_enc_result_t scomx_encode_read_user_info_value(scomx_dest_t dst_addr, scomx_user_info_object_t object_id)
+scomx_enc_result_t scomx_ctx_encode_read_user_info_value(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_user_info_object_t object_id)
 {
-    return scomx_encode_read_property(dst_addr, SCOM_USER_INFO_OBJECT_TYPE, object_id, SCOMX_PROP_USER_INFO_VALUE);
+    return scomx_ctx_encode_read_property(ctx, dst_addr, SCOM_USER_INFO_OBJECT_TYPE, object_id, SCOMX_PROP_USER_INFO_VALUE);
 }
 
-scomx_enc_result_t scomx_encode_read_parameter_value(scomx_dest_t dst_addr, scomx_parameter_object_t object_id)
+scomx_enc_result_t scomx_ctx_encode_read_parameter_value(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id)
 {
-    return scomx_encode_read_property(dst_addr, SCOM_PARAMETER_OBJECT_TYPE, object_id, SCOMX_PROP_PARAMETER_VALUE_QSP);
+    return scomx_ctx_encode_read_property(ctx, dst_addr, SCOM_PARAMETER_OBJECT_TYPE, object_id, SCOMX_PROP_PARAMETER_VALUE_QSP);
 }
 
-scomx_enc_result_t scomx_encode_read_parameter_min(scomx_dest_t dst_addr, scomx_parameter_object_t object_id)
+scomx_enc_result_t scomx_ctx_encode_read_parameter_min(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id)
 {
-    return scomx_encode_read_property(dst_addr, SCOM_PARAMETER_OBJECT_TYPE, object_id, SCOMX_PROP_PARAMETER_MIN_QSP);
+    return scomx_ctx_encode_read_property(ctx, dst_addr, SCOM_PARAMETER_OBJECT_TYPE, object_id, SCOMX_PROP_PARAMETER_MIN_QSP);
 }
 
-scomx_enc_result_t scomx_encode_read_parameter_max(scomx_dest_t dst_addr, scomx_parameter_object_t object_id)
+scomx_enc_result_t scomx_ctx_encode_read_parameter_max(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id)
 {
-    return scomx_encode_read_property(dst_addr, SCOM_PARAMETER_OBJECT_TYPE, object_id, SCOMX_PROP_PARAMETER_MAX_QSP);
+    return scomx_ctx_encode_read_property(ctx, dst_addr, SCOM_PARAMETER_OBJECT_TYPE, object_id, SCOMX_PROP_PARAMETER_MAX_QSP);
 }
 
-scomx_enc_result_t scomx_encode_read_parameter_unsaved_value(scomx_dest_t dst_addr, scomx_parameter_object_t object_id)
+scomx_enc_result_t scomx_ctx_encode_read_parameter_unsaved_value(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id)
 {
-    return scomx_encode_read_property(dst_addr, SCOM_PARAMETER_OBJECT_TYPE, object_id, SCOMX_PROP_PARAMETER_UNSAVED_VALUE_QSP);
+    return scomx_ctx_encode_read_property(ctx, dst_addr, SCOM_PARAMETER_OBJECT_TYPE, object_id, SCOMX_PROP_PARAMETER_UNSAVED_VALUE_QSP);
 }
 
-scomx_enc_result_t scomx_encode_read_parameter_level(scomx_dest_t dst_addr, scomx_parameter_object_t object_id)
+scomx_enc_result_t scomx_ctx_encode_read_parameter_level(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id)
 {
-    return scomx_encode_read_property(dst_addr, SCOM_PARAMETER_OBJECT_TYPE, object_id, SCOMX_PROP_PARAMETER_LEVEL_QSP);
+    return scomx_ctx_encode_read_property(ctx, dst_addr, SCOM_PARAMETER_OBJECT_TYPE, object_id, SCOMX_PROP_PARAMETER_LEVEL_QSP);
 }
 
-scomx_enc_result_t scomx_encode_write_parameter_value(scomx_dest_t dst_addr, scomx_parameter_object_t object_id, const char *const data, size_t data_len)
+scomx_enc_result_t scomx_ctx_encode_write_parameter_value(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id, const char *const data,
+                                                          size_t data_len)
 {
-    return scomx_encode_write_property(dst_addr, SCOM_PARAMETER_OBJECT_TYPE, object_id, SCOMX_PROP_PARAMETER_VALUE_QSP, data, data_len);
+    return scomx_ctx_encode_write_property(ctx, dst_addr, SCOM_PARAMETER_OBJECT_TYPE, object_id, SCOMX_PROP_PARAMETER_VALUE_QSP, data, data_len);
 }
 
-scomx_enc_result_t scomx_encode_write_parameter_value_u32(scomx_dest_t dst_addr, scomx_parameter_object_t object_id, uint32_t val)
+scomx_enc_result_t scomx_ctx_encode_write_parameter_value_u32(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id, uint32_t val)
 {
     char buf[4];
     scom_write_le32(buf, val);
-    return scomx_encode_write_parameter_value(dst_addr, object_id, buf, sizeof(buf));
+    return scomx_ctx_encode_write_parameter_value(ctx, dst_addr, object_id, buf, sizeof(buf));
 }
 
-scomx_enc_result_t scomx_encode_write_parameter_value_u16(scomx_dest_t dst_addr, scomx_parameter_object_t object_id, uint16_t val)
+scomx_enc_result_t scomx_ctx_encode_write_parameter_value_u16(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id, uint16_t val)
 {
     char buf[2];
     scom_write_le16(buf, val);
-    return scomx_encode_write_parameter_value(dst_addr, object_id, buf, sizeof(buf));
+    return scomx_ctx_encode_write_parameter_value(ctx, dst_addr, object_id, buf, sizeof(buf));
 }
 
-scomx_enc_result_t scomx_encode_write_parameter_value_float(scomx_dest_t dst_addr, scomx_parameter_object_t object_id, float val)
+scomx_enc_result_t scomx_ctx_encode_write_parameter_value_float(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id, float val)
 {
     char buf[4];
     scom_write_le_float(buf, val);
-    return scomx_encode_write_parameter_value(dst_addr, object_id, buf, sizeof(buf));
+    return scomx_ctx_encode_write_parameter_value(ctx, dst_addr, object_id, buf, sizeof(buf));
 }
 
-scomx_enc_result_t scomx_encode_write_parameter_unsaved_value(scomx_dest_t dst_addr, scomx_parameter_object_t object_id, const char *const data, size_t data_len)
+scomx_enc_result_t scomx_ctx_encode_write_parameter_unsaved_value(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id, const char *const data,
+                                                                  size_t data_len)
 {
-    return scomx_encode_write_property(dst_addr, SCOM_PARAMETER_OBJECT_TYPE, object_id, SCOMX_PROP_PARAMETER_UNSAVED_VALUE_QSP, data, data_len);
+    return scomx_ctx_encode_write_property(ctx, dst_addr, SCOM_PARAMETER_OBJECT_TYPE, object_id, SCOMX_PROP_PARAMETER_UNSAVED_VALUE_QSP, data, data_len);
 }
 
-scomx_enc_result_t scomx_encode_write_parameter_unsaved_value_u32(scomx_dest_t dst_addr, scomx_parameter_object_t object_id, uint32_t val)
+scomx_enc_result_t scomx_ctx_encode_write_parameter_unsaved_value_u32(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id, uint32_t val)
 {
     char buf[4];
     scom_write_le32(buf, val);
-    return scomx_encode_write_parameter_unsaved_value(dst_addr, object_id, buf, sizeof(buf));
+    return scomx_ctx_encode_write_parameter_unsaved_value(ctx, dst_addr, object_id, buf, sizeof(buf));
 }
 
-scomx_enc_result_t scomx_encode_write_parameter_unsaved_value_u16(scomx_dest_t dst_addr, scomx_parameter_object_t object_id, uint16_t val)
+scomx_enc_result_t scomx_ctx_encode_write_parameter_unsaved_value_u16(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id, uint16_t val)
 {
     char buf[2];
     scom_write_le16(buf, val);
-    return scomx_encode_write_parameter_unsaved_value(dst_addr, object_id, buf, sizeof(buf));
+    return scomx_ctx_encode_write_parameter_unsaved_value(ctx, dst_addr, object_id, buf, sizeof(buf));
 }
 
-scomx_enc_result_t scomx_encode_write_parameter_unsaved_value_float(scomx_dest_t dst_addr, scomx_parameter_object_t object_id, float val)
+scomx_enc_result_t scomx_ctx_encode_write_parameter_unsaved_value_float(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id, float val)
 {
     char buf[4];
     scom_write_le_float(buf, val);
-    return scomx_encode_write_parameter_unsaved_value(dst_addr, object_id, buf, sizeof(buf));
+    return scomx_ctx_encode_write_parameter_unsaved_value(ctx, dst_addr, object_id, buf, sizeof(buf));
 }
 
-scomx_header_dec_result_t scomx_decode_frame_header(const char *const data, size_t data_len)
+scomx_header_dec_result_t scomx_ctx_decode_frame_header(scomx_ctx_t *ctx, const char *const data, size_t data_len)
 {
     scomx_header_dec_result_t res;
 
     memset(&res, 0, sizeof(res));
 
-    reset_frame();
+    reset_frame(ctx);
 
-    if (data_len != SCOM_FRAME_HEADER_SIZE) {
+    if (data_len != SCOM_FRAME_HEADER_SIZE || ctx->buffer_size < SCOM_FRAME_HEADER_SIZE) {
         // read data must be exactly SCOM_FRAME_HEADER_SIZE bytes long
         res.error = SCOM_ERROR_STACK_PORT_READ_FAILED;
         return res;
     }
 
     // copy header data
-    memcpy(g_frame.buffer, data, data_len);
+    memcpy(ctx->frame.buffer, data, data_len);
 
     // decode the header
-    scom_decode_frame_header(&g_frame);
-    if (g_frame.last_error != SCOM_ERROR_NO_ERROR) {
-        res.error = g_frame.last_error;
+    scom_decode_frame_header(&ctx->frame);
+    if (ctx->frame.last_error != SCOM_ERROR_NO_ERROR) {
+        res.error = ctx->frame.last_error;
         return res;
     }
 
     // request reading the data part
-    res.length_to_read = scom_frame_length(&g_frame) - SCOM_FRAME_HEADER_SIZE;
+    res.length_to_read = scom_frame_length(&ctx->frame) - SCOM_FRAME_HEADER_SIZE;
 
     return res;
 }
 
-scomx_dec_result_t scomx_decode_frame(const char *const data, size_t data_len)
+scomx_dec_result_t scomx_ctx_decode_frame(scomx_ctx_t *ctx, const char *const data, size_t data_len)
 {
     scomx_dec_result_t res;
 
     memset(&res, 0, sizeof(res));
 
-    if (data_len != scom_frame_length(&g_frame) - SCOM_FRAME_HEADER_SIZE) {
+    if (data_len != scom_frame_length(&ctx->frame) - SCOM_FRAME_HEADER_SIZE) {
         // read data must be of specific length
         res.error = SCOM_ERROR_STACK_PORT_READ_FAILED;
         return res;
     }
 
-    // copy frame data into the buffer
-    memcpy(&g_frame.buffer[SCOM_FRAME_HEADER_SIZE], data, data_len);
+    if (scom_frame_length(&ctx->frame) > ctx->frame.buffer_size) {
+        // header was rejected, the data would not fit into the context buffer
+        res.error = SCOM_ERROR_STACK_BUFFER_TOO_SMALL;
+        return res;
+    }
+
+    // copy frame data into the buffer, checksumming it on the way, then the trailing checksum
+    char *dst = &ctx->frame.buffer[SCOM_FRAME_HEADER_SIZE];
+    uint16_t checksum = scomx_copy_checksum(dst, data, ctx->frame.data_length);
+    memcpy(dst + ctx->frame.data_length, data + ctx->frame.data_length, 2);
 
     // decode frame data
-    scom_decode_frame_data(&g_frame);
+    decode_frame_data(&ctx->frame, checksum);
 
-    res.error = g_frame.last_error;
+    decode_property_response(&ctx->frame, &ctx->property, &res);
 
-    res.src_addr = g_frame.src_addr;
-    res.service_id = g_frame.service_id;
+    return res;
+}
 
-    // reuse the structure
-    scom_initialize_property(&g_property, &g_frame);
+scomx_header_dec_result_t scomx_decode_frame_header_inplace(char *const data, size_t data_len)
+{
+    scomx_header_dec_result_t res;
+    scom_frame_t frame;
 
-    // decode the read or write property service
-    ptrdiff_t length = (ptrdiff_t)g_property.frame->data_length - SCOM_SERVICE_HEADER_SIZE - SCOM_PROPERTY_HEADER_SIZE;
+    memset(&res, 0, sizeof(res));
 
-    if (!g_property.frame->service_flags.error && length >= 0 && length <= (ptrdiff_t)g_property.value_buffer_size) {
-        // property looks ok
-        g_property.value_length = length;
-        scom_decode_property_header(&g_property);
-    } else if (g_property.frame->service_flags.error) {
-        // decode application error
-        if (length == 2) {
-            res.error = (scom_error_t)scom_read_le16(g_property.value_buffer);
-        } else {
-            res.error = SCOM_ERROR_INVALID_FRAME;
-        }
+    if (data_len < SCOM_FRAME_HEADER_SIZE) {
+        res.error = SCOM_ERROR_STACK_PORT_READ_FAILED;
         return res;
-    } else {
-        // no application error but value over the property buffer size
+    }
+
+    // the data part has not been received yet so allow any length the header can describe
+    scom_initialize_frame(&frame, data, SCOM_FRAME_HEADER_SIZE + 0xFFFF + 2);
+
+    scom_decode_frame_header(&frame);
+    if (frame.last_error != SCOM_ERROR_NO_ERROR) {
+        res.error = frame.last_error;
+        return res;
+    }
+
+    res.length_to_read = scom_frame_length(&frame) - SCOM_FRAME_HEADER_SIZE;
+
+    return res;
+}
+
+scomx_dec_result_t scomx_decode_frame_inplace(char *const data, size_t data_len)
+{
+    scomx_dec_result_t res;
+    scom_frame_t frame;
+    scom_property_t property;
+
+    memset(&res, 0, sizeof(res));
+
+    if (data_len < SCOM_FRAME_HEADER_SIZE) {
+        res.error = SCOM_ERROR_STACK_PORT_READ_FAILED;
+        return res;
+    }
+
+    scom_initialize_frame(&frame, data, data_len);
+
+    // fails with SCOM_ERROR_INVALID_FRAME also when the whole frame doesn't fit into data_len
+    scom_decode_frame_header(&frame);
+    if (frame.last_error != SCOM_ERROR_NO_ERROR) {
+        res.error = frame.last_error;
+        return res;
+    }
+
+    decode_frame_data(&frame, scomx_checksum(&data[SCOM_FRAME_HEADER_SIZE], frame.data_length));
+
+    decode_property_response(&frame, &property, &res);
+
+    return res;
+}
+
+// encodes a property response into the context buffer; the property value is copied from data
+static scomx_enc_result_t encode_response_frame(scomx_ctx_t *ctx, uint32_t src_addr, scom_frame_flags_t frame_flags, scom_service_t service_id,
+                                                scom_object_type_t object_type, uint32_t object_id, uint16_t property_id, int error, const char *const data,
+                                                size_t data_len)
+{
+    reset_frame(ctx);
+
+    ctx->frame.src_addr = src_addr;
+    ctx->frame.dst_addr = 1; // responses always go to the gateway
+    ctx->frame.frame_flags = frame_flags;
+    ctx->frame.service_flags.error = error;
+
+    ctx->property.object_type = object_type;
+    ctx->property.object_id = object_id;
+    ctx->property.property_id = property_id;
+
+    // ensure data and the trailing data checksum fit into the buffer
+    if (ctx->buffer_size < SCOM_PROPERTY_VALUE_OFFSET + 2 || data_len > ctx->property.value_buffer_size - 2) {
+        scomx_enc_result_t res;
+        memset(&res, 0, sizeof(res));
         res.error = SCOM_ERROR_STACK_BUFFER_TOO_SMALL;
         return res;
     }
 
-    // copy property data into the dec result
-    res.object_type = g_property.object_type;
-    res.object_id = g_property.object_id;
-    res.property_id = g_property.property_id;
+    ctx->property.value_length = data_len;
+    memcpy(ctx->property.value_buffer, data, data_len);
+
+    // the layout of a response is the one of a write request carrying the value
+    scom_encode_write_property(&ctx->property);
+    ctx->frame.service_id = service_id;
 
-    res.data = g_property.value_buffer;
-    res.length = g_property.value_length;
+    scomx_enc_result_t res;
+    memset(&res, 0, sizeof(res));
+
+    scom_encode_response_frame(&ctx->frame);
+
+    res.error = ctx->frame.last_error;
+    res.data = ctx->frame.buffer;
+    res.length = scom_frame_length(&ctx->frame);
 
     return res;
 }
 
+scomx_enc_result_t scomx_ctx_encode_property_response(scomx_ctx_t *ctx, uint32_t src_addr, scom_frame_flags_t frame_flags, scom_service_t service_id,
+                                                      scom_object_type_t object_type, uint32_t object_id, uint16_t property_id, const char *const data, size_t data_len)
+{
+    return encode_response_frame(ctx, src_addr, frame_flags, service_id, object_type, object_id, property_id, 0, data, data_len);
+}
+
+scomx_enc_result_t scomx_ctx_encode_error_response(scomx_ctx_t *ctx, uint32_t src_addr, scom_frame_flags_t frame_flags, scom_service_t service_id,
+                                                   scom_object_type_t object_type, uint32_t object_id, uint16_t property_id, scom_error_t error)
+{
+    char buf[2];
+    scom_write_le16(buf, error);
+    return encode_response_frame(ctx, src_addr, frame_flags, service_id, object_type, object_id, property_id, 1, buf, sizeof(buf));
+}
+
+scomx_dec_result_t scomx_decode_request_inplace(char *const data, size_t data_len)
+{
+    scomx_dec_result_t res;
+    scom_frame_t frame;
+
+    memset(&res, 0, sizeof(res));
+
+    if (data_len < SCOM_FRAME_HEADER_SIZE) {
+        res.error = SCOM_ERROR_STACK_PORT_READ_FAILED;
+        return res;
+    }
+
+    scom_initialize_frame(&frame, data, data_len);
+
+    scom_decode_frame_header(&frame);
+    if (frame.last_error != SCOM_ERROR_NO_ERROR) {
+        res.error = frame.last_error;
+        return res;
+    }
+
+    res.src_addr = frame.src_addr;
+    res.dst_addr = frame.dst_addr;
+    res.frame_flags = frame.frame_flags;
+    res.has_frame_flags = 1;
+
+    // scom_decode_frame_data() only accepts responses, so check the data part here
+    uint16_t sent_checksum = scom_read_le16(&data[SCOM_FRAME_HEADER_SIZE + frame.data_length]);
+    uint8_t service_flags = data[SCOM_FRAME_HEADER_SIZE];
+    ptrdiff_t length = (ptrdiff_t)frame.data_length - SCOM_SERVICE_HEADER_SIZE - SCOM_PROPERTY_HEADER_SIZE;
+
+    if (scomx_checksum(&data[SCOM_FRAME_HEADER_SIZE], frame.data_length) != sent_checksum || (service_flags & 0x3) != 0 || length < 0) {
+        res.error = SCOM_ERROR_INVALID_FRAME;
+        return res;
+    }
+
+    const char *header = data + SCOM_PROPERTY_HEADER_OFFSET;
+
+    res.service_id = data[SCOM_FRAME_HEADER_SIZE + 1];
+    res.object_type = scom_read_le16(&header[0]);
+    res.object_id = scom_read_le32(&header[2]);
+    res.property_id = scom_read_le16(&header[6]);
+
+    res.data = data + SCOM_PROPERTY_VALUE_OFFSET;
+    res.length = length;
+
+    return res;
+}
+
+// LEGACY API - thin wrappers operating on the global context
+
+scomx_enc_result_t scomx_encode_read_property(uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id)
+{
+    return scomx_ctx_encode_read_property(&g_ctx, dst_addr, object_type, object_id, property_id);
+}
+
+scomx_enc_result_t scomx_encode_write_property(uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id, const char *const data,
+                                               size_t data_len)
+{
+    return scomx_ctx_encode_write_property(&g_ctx, dst_addr, object_type, object_id, property_id, data, data_len);
+}
+
+scomx_enc_result_t scomx_encode_read_user_info_value(scomx_dest_t dst_addr, scomx_user_info_object_t object_id)
+{
+    return scomx_ctx_encode_read_user_info_value(&g_ctx, dst_addr, object_id);
+}
+
+scomx_enc_result_t scomx_encode_read_parameter_value(scomx_dest_t dst_addr, scomx_parameter_object_t object_id)
+{
+    return scomx_ctx_encode_read_parameter_value(&g_ctx, dst_addr, object_id);
+}
+
+scomx_enc_result_t scomx_encode_read_parameter_min(scomx_dest_t dst_addr, scomx_parameter_object_t object_id)
+{
+    return scomx_ctx_encode_read_parameter_min(&g_ctx, dst_addr, object_id);
+}
+
+scomx_enc_result_t scomx_encode_read_parameter_max(scomx_dest_t dst_addr, scomx_parameter_object_t object_id)
+{
+    return scomx_ctx_encode_read_parameter_max(&g_ctx, dst_addr, object_id);
+}
+
+scomx_enc_result_t scomx_encode_read_parameter_unsaved_value(scomx_dest_t dst_addr, scomx_parameter_object_t object_id)
+{
+    return scomx_ctx_encode_read_parameter_unsaved_value(&g_ctx, dst_addr, object_id);
+}
+
+scomx_enc_result_t scomx_encode_read_parameter_level(scomx_dest_t dst_addr, scomx_parameter_object_t object_id)
+{
+    return scomx_ctx_encode_read_parameter_level(&g_ctx, dst_addr, object_id);
+}
+
+scomx_enc_result_t scomx_encode_write_parameter_value(scomx_dest_t dst_addr, scomx_parameter_object_t object_id, const char *const data, size_t data_len)
+{
+    return scomx_ctx_encode_write_parameter_value(&g_ctx, dst_addr, object_id, data, data_len);
+}
+
+scomx_enc_result_t scomx_encode_write_parameter_value_u32(scomx_dest_t dst_addr, scomx_parameter_object_t object_id, uint32_t val)
+{
+    return scomx_ctx_encode_write_parameter_value_u32(&g_ctx, dst_addr, object_id, val);
+}
+
+scomx_enc_result_t scomx_encode_write_parameter_value_u16(scomx_dest_t dst_addr, scomx_parameter_object_t object_id, uint16_t val)
+{
+    return scomx_ctx_encode_write_parameter_value_u16(&g_ctx, dst_addr, object_id, val);
+}
+
+scomx_enc_result_t scomx_encode_write_parameter_value_float(scomx_dest_t dst_addr, scomx_parameter_object_t object_id, float val)
+{
+    return scomx_ctx_encode_write_parameter_value_float(&g_ctx, dst_addr, object_id, val);
+}
+
+scomx_enc_result_t scomx_encode_write_parameter_unsaved_value(scomx_dest_t dst_addr, scomx_parameter_object_t object_id, const char *const data, size_t data_len)
+{
+    return scomx_ctx_encode_write_parameter_unsaved_value(&g_ctx, dst_addr, object_id, data, data_len);
+}
+
+scomx_enc_result_t scomx_encode_write_parameter_unsaved_value_u32(scomx_dest_t dst_addr, scomx_parameter_object_t object_id, uint32_t val)
+{
+    return scomx_ctx_encode_write_parameter_unsaved_value_u32(&g_ctx, dst_addr, object_id, val);
+}
+
+scomx_enc_result_t scomx_encode_write_parameter_unsaved_value_u16(scomx_dest_t dst_addr, scomx_parameter_object_t object_id, uint16_t val)
+{
+    return scomx_ctx_encode_write_parameter_unsaved_value_u16(&g_ctx, dst_addr, object_id, val);
+}
+
+scomx_enc_result_t scomx_encode_write_parameter_unsaved_value_float(scomx_dest_t dst_addr, scomx_parameter_object_t object_id, float val)
+{
+    return scomx_ctx_encode_write_parameter_unsaved_value_float(&g_ctx, dst_addr, object_id, val);
+}
+
+scomx_header_dec_result_t scomx_decode_frame_header(const char *const data, size_t data_len)
+{
+    return scomx_ctx_decode_frame_header(&g_ctx, data, data_len);
+}
+
+scomx_dec_result_t scomx_decode_frame(const char *const data, size_t data_len)
+{
+    return scomx_ctx_decode_frame(&g_ctx, data, data_len);
+}
+
 uint32_t scomx_result_int(scomx_dec_result_t res)
 {
     if (res.error == SCOM_ERROR_NO_ERROR) {
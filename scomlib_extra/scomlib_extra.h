@@ -42,8 +42,31 @@ Example setup: XTM4000-48 inverter, VT-80 VarioTrack, BSP battery controller and
 // 4.6 Message objects (firmware >= 1.5.0)
 #define SCOM_MESSAGE_OBJECT_TYPE ((scom_object_type_t)0x3)
 
+// 4.6 property_id of a message object; its value is the message: total number of messages (uint32_t),
+// message type (uint16_t), source address (uint32_t), timestamp (uint32_t) and value (uint32_t)
+#define SCOMX_PROP_MESSAGE 0x0
+#define SCOMX_MESSAGE_SIZE 18
+
 #define SCOM_DATALOG_TRANSFER_OBJECT_TYPE ((scom_object_type_t)0x0101)
 
+// 4.8.1 object_id of the datalog transfer object listing the files; other object_ids select a file
+#define SCOMX_DATALOG_FILE_LIST_ID 0
+
+// 4.8.1 property_ids of the datalog transfer object, read with the read property service
+typedef enum {
+    SCOMX_PROP_DATALOG_SD_START = 0x21,      // starts the transfer of the file; the response holds its size (uint32_t)
+    SCOMX_PROP_DATALOG_SD_READ_NEXT = 0x22,  // acknowledges the previous block and returns the next one: its offset (uint32_t) followed
+                                             // by the data, which is empty at the end of the file
+    SCOMX_PROP_DATALOG_SD_READ_AGAIN = 0x23, // returns the current block again, e.g. after a lost response
+    SCOMX_PROP_DATALOG_SD_ABORT = 0x24,      // ends the transfer
+} scomx_datalog_property_t;
+
+// first byte of every frame, used to find the frame boundaries in a byte stream
+#define SCOMX_START_BYTE 0xAA
+
+// length of a read property request: frame header, service and property headers and data checksum
+#define SCOMX_READ_REQUEST_SIZE (SCOM_FRAME_HEADER_SIZE + 2 + 8 + 2)
+
 // TYPES
 
 typedef struct {
@@ -93,8 +116,756 @@ typedef struct {
 
     /** \brief length of the decoded property data; only valid when no error is set */
     size_t length;
+
+    /** \brief destination address of the frame */
+    uint32_t dst_addr;
+
+    /** \brief flags reported by the gateway in the frame header (pending message, RCC reset, SD card
+     * state); only valid when has_frame_flags is set */
+    scom_frame_flags_t frame_flags;
+
+    /** \brief set when the frame header was decoded, even if the frame carries an error */
+    int has_frame_flags;
 } scomx_dec_result_t;
 
+typedef struct {
+    /** \brief caller-owned buffer where the received bytes are assembled into a frame */
+    char *buffer;
+
+    /** \brief size of the buffer; frames longer than that are dropped */
+    size_t buffer_size;
+
+    /** \brief number of bytes in the buffer */
+    size_t length;
+
+    /** \brief total length of the frame being received; 0 until a valid header was received */
+    size_t frame_length;
+
+    /** \brief set when the buffer holds a complete frame returned by the last push */
+    int frame_ready;
+
+    /** \brief number of complete frames received */
+    unsigned long frames_received;
+
+    /** \brief number of candidate frames rejected because of a bad header or data checksum */
+    unsigned long frames_rejected;
+
+    /** \brief number of bytes skipped while looking for the start of a frame */
+    unsigned long bytes_discarded;
+
+    /** \brief set to parse request frames (as a device would) instead of responses */
+    int decode_requests;
+} scomx_parser_t;
+
+typedef struct {
+    /** \brief number of input bytes consumed; push the rest again when lower than the input length */
+    size_t consumed;
+
+    /** \brief set when a complete frame has been received */
+    int frame_ready;
+
+    /** \brief raw bytes of the received frame; only valid when frame_ready is set */
+    const char *frame;
+
+    /** \brief length of the received frame; only valid when frame_ready is set */
+    size_t frame_length;
+
+    /** \brief decoded frame; only valid when frame_ready is set */
+    scomx_dec_result_t result;
+} scomx_parse_result_t;
+
+typedef struct {
+    /** \brief caller-owned buffer the frames are encoded into and decoded from */
+    char *buffer;
+
+    /** \brief size of the buffer; 256 bytes is enough for any property read or write */
+    size_t buffer_size;
+
+    /** \brief frame state of the last encoded request or decoded response */
+    scom_frame_t frame;
+
+    /** \brief property state of the last encoded request or decoded response */
+    scom_property_t property;
+} scomx_ctx_t;
+
+typedef struct {
+    /** \brief address of the device to read from */
+    uint32_t dst_addr;
+
+    /** \brief object_type of the property to read */
+    scom_object_type_t object_type;
+
+    /** \brief object_id of the property to read */
+    uint32_t object_id;
+
+    /** \brief property_id of the property to read */
+    uint16_t property_id;
+
+    /** \brief the property is read once in every period of this length */
+    uint32_t period_ms;
+
+    /** \brief 0 is the most important; decides which late reads go first when the link is overloaded */
+    uint8_t priority;
+
+    /** \brief start of the current period, the read is not issued before it */
+    int64_t release_ms;
+
+    /** \brief end of the current period, the read should complete before it */
+    int64_t deadline_ms;
+
+    /** \brief set while the read is on the wire */
+    int in_flight;
+
+    /** \brief set when the deadline of the current period has been counted as missed */
+    int late;
+
+    /** \brief time the read in flight was issued */
+    int64_t issued_ms;
+
+    /** \brief smoothed duration of a read, used to estimate the link demand */
+    uint32_t cost_ms;
+
+    /** \brief number of completed reads */
+    unsigned long reads;
+
+    /** \brief number of reads which completed with an error */
+    unsigned long errors;
+
+    /** \brief number of periods in which the read did not complete by the deadline */
+    unsigned long missed_deadlines;
+
+    /** \brief read request encoded when the subscription was added, ready to be sent */
+    char frame[SCOMX_READ_REQUEST_SIZE];
+} scomx_subscription_t;
+
+typedef struct {
+    /** \brief caller-owned array of subscriptions */
+    scomx_subscription_t *subscriptions;
+
+    /** \brief number of elements in the subscriptions array */
+    size_t capacity;
+
+    /** \brief number of subscriptions added */
+    size_t count;
+
+    /** \brief initial estimate of the read duration, used until reads are measured */
+    uint32_t default_cost_ms;
+
+    /** \brief time the statistics were last reset */
+    int64_t stats_start_ms;
+
+    /** \brief time spent with a read in flight since the statistics were reset */
+    int64_t busy_ms;
+
+    /** \brief time the link became busy, valid while in_flight is not 0 */
+    int64_t busy_since_ms;
+
+    /** \brief number of reads in flight */
+    unsigned in_flight;
+
+    /** \brief counters since the statistics were reset */
+    unsigned long issued;
+    unsigned long completed;
+    unsigned long errors;
+    unsigned long missed_deadlines;
+} scomx_sched_t;
+
+typedef struct {
+    /** \brief number of reads issued */
+    unsigned long issued;
+
+    /** \brief number of reads completed, including failed ones */
+    unsigned long completed;
+
+    /** \brief number of reads which completed with an error */
+    unsigned long errors;
+
+    /** \brief number of periods in which a read did not complete by its deadline */
+    unsigned long missed_deadlines;
+
+    /** \brief fraction of the time a read was in flight */
+    float utilization;
+
+    /** \brief fraction of the link time needed to serve all subscriptions (sum of cost / period);
+     * deadlines are missed when it is above 1 */
+    float demand;
+} scomx_sched_stats_t;
+
+typedef struct {
+    /** \brief passed to the functions below, e.g. the serial port */
+    void *user;
+
+    /** \brief writes the data, waiting until the absolute deadline at most; returns the number of
+     * bytes written (less than length on timeout) or -1 on error */
+    long (*write)(void *user, const char *data, size_t length, int64_t deadline_ms);
+
+    /** \brief reads the bytes available, waiting for the first one until the absolute deadline;
+     * returns the number of bytes read, 0 on timeout or -1 on error */
+    long (*read)(void *user, char *buffer, size_t size, int64_t deadline_ms);
+
+    /** \brief returns a monotonic time in milliseconds */
+    int64_t (*now_ms)(void *user);
+
+    /** \brief time from the start of writing a request until its response must be received */
+    uint32_t timeout_ms;
+} scomx_transport_t;
+
+// largest property value returned by scomx_read_many
+#define SCOMX_READ_VALUE_SIZE 8
+
+typedef struct {
+    /** \brief property to read */
+    uint32_t dst_addr;
+    scom_object_type_t object_type;
+    uint32_t object_id;
+    uint16_t property_id;
+
+    /** \brief decoded response or the error of the read; data points to value */
+    scomx_dec_result_t result;
+
+    /** \brief copy of the property value */
+    char value[SCOMX_READ_VALUE_SIZE];
+} scomx_read_item_t;
+
+// receive buffer large enough for a datalog block of the maximum size sent by the Xcom-232i
+#define SCOMX_DATALOG_BUFFER_SIZE 2048
+
+// receives a downloaded block; returns 0 to continue or -1 to stop the download (see sink_refused)
+typedef int (*scomx_datalog_sink_t)(void *user, const char *data, size_t length);
+
+typedef struct {
+    /** \brief transport to the gateway; its timeout_ms must cover a block of the maximum size */
+    const scomx_transport_t *transport;
+
+    /** \brief address of the device holding the SD card */
+    uint32_t dst_addr;
+
+    /** \brief assembles the received blocks in the caller-provided buffer */
+    scomx_parser_t parser;
+
+    /** \brief request being sent */
+    char request[SCOMX_READ_REQUEST_SIZE];
+
+    /** \brief how many times a lost or corrupted block is requested again before giving up */
+    unsigned retries;
+
+    /** \brief size of the file being downloaded as reported by the device */
+    uint32_t file_size;
+
+    /** \brief set when the last download was stopped by its sink rather than failing on the link or the device */
+    int sink_refused;
+
+    /** \brief totals since the initialization */
+    uint64_t bytes_received;
+    unsigned long blocks_received;
+    unsigned long blocks_repeated;
+} scomx_datalog_t;
+
+// bits of the frame_flags byte (section 3.5), as returned by scomx_frame_flags_byte
+typedef enum {
+    SCOMX_FLAG_MESSAGE_PENDING = 0x01,   // a new message is available in the message objects
+    SCOMX_FLAG_RCC_RESET = 0x02,         // the RCC was reset, parameters may have been changed
+    SCOMX_FLAG_SD_CARD_PRESENT = 0x04,   // an SD card is inserted in the Xcom-232i
+    SCOMX_FLAG_SD_CARD_FULL = 0x08,      // the SD card is full
+    SCOMX_FLAG_NEW_DATALOG_FILE = 0x10,  // a new datalog file was written to the SD card
+} scomx_frame_flag_t;
+
+// called with the watched flags which were set (raised) and cleared since the previous frame and all
+// flags of the current frame
+typedef void (*scomx_flags_callback_t)(void *user, uint8_t raised, uint8_t cleared, uint8_t flags);
+
+typedef struct {
+    /** \brief flags whose changes are reported */
+    uint8_t mask;
+
+    /** \brief flags of the last frame */
+    uint8_t flags;
+
+    scomx_flags_callback_t callback;
+    void *user;
+
+    /** \brief number of frames whose flags were checked */
+    unsigned long frames;
+
+    /** \brief number of times the callback was called */
+    unsigned long changes;
+} scomx_flags_watch_t;
+
+typedef struct {
+    /** \brief number of the message counted from the first one logged by the gateway; strictly
+     * increasing, so it orders messages and serves as the cursor of the message log */
+    uint32_t seq;
+
+    /** \brief message type, see the message list of the user manual */
+    uint16_t type;
+
+    /** \brief address of the device which sent the message */
+    uint32_t source;
+
+    /** \brief time of the message, seconds since 1970 */
+    uint32_t timestamp;
+
+    /** \brief value associated with the message */
+    uint32_t value;
+} scomx_message_t;
+
+typedef void (*scomx_message_callback_t)(void *user, const scomx_message_t *message);
+
+typedef struct {
+    /** \brief address of the gateway holding the messages */
+    uint32_t dst_addr;
+
+    /** \brief seq of the first message not delivered yet; messages before it are known history and
+     * are not read. Persist it after a fetch and pass it to scomx_msglog_init after a restart. */
+    uint32_t cursor;
+
+    scomx_message_callback_t callback;
+    void *user;
+
+    /** \brief set while a fetch is in progress */
+    int active;
+
+    /** \brief set when another fetch was requested during the current one */
+    int pending;
+
+    /** \brief object_id (index from the newest message) read next */
+    uint32_t index;
+
+    /** \brief seq of the next message to deliver, counting down */
+    uint32_t expected;
+
+    /** \brief the cursor once the current fetch completes */
+    uint32_t newest;
+
+    /** \brief totals since the initialization */
+    unsigned long reads;
+    unsigned long delivered;
+    // messages dropped by the gateway before they were read
+    unsigned long lost;
+} scomx_msglog_t;
+
+// largest value written by the encode function of an object's metadata
+#define SCOMX_TYPED_VALUE_SIZE 4
+
+typedef struct {
+    /** \brief error of the response, or SCOM_ERROR_INVALID_DATA_LENGTH when the value is shorter than its format */
+    scom_error_t error;
+
+    /** \brief value in the unit of the metadata (scaled); bool, enum and int values as a number */
+    float value;
+
+    /** \brief bool, enum and int values as they are sent; float values truncated after scaling */
+    int32_t integer;
+
+    /** \brief label of an enum value; NULL when the value has none */
+    const char *label;
+} scomx_typed_value_t;
+
+struct scomx_object_meta;
+
+typedef scomx_typed_value_t (*scomx_meta_decode_t)(const struct scomx_object_meta *meta, const scomx_dec_result_t *res);
+typedef size_t (*scomx_meta_encode_t)(const struct scomx_object_meta *meta, float value, char *data);
+
+// metadata of a user info or parameter object, generated from scomlib_extra_objects.def
+typedef struct scomx_object_meta {
+    scom_object_type_t object_type;
+    uint32_t object_id;
+
+    /** \brief name of the object constant, e.g. "SCOMX_INFO_XTENDER_BATT_VOLTAGE" */
+    const char *name;
+
+    /** \brief format of the value on the wire and its size in bytes */
+    scom_format_t format;
+    uint8_t size;
+
+    /** \brief unit of the decoded value, "" when it has none */
+    const char *unit;
+
+    /** \brief the value sent by the device multiplied by scale is in unit, e.g. 1000 for kW sent and W decoded */
+    float scale;
+
+    /** \brief labels of enum values indexed by the value; entries of values without a label are NULL */
+    const char *const *labels;
+    size_t label_count;
+
+    /** \brief set for objects which can be written (parameters) */
+    int writable;
+
+    /** \brief decodes a response of the object's value according to its format */
+    scomx_meta_decode_t decode;
+
+    /** \brief encodes a value in unit into data (SCOMX_TYPED_VALUE_SIZE bytes); returns the encoded size */
+    scomx_meta_encode_t encode;
+} scomx_object_meta_t;
+
+// largest property value kept in the cache; user info and parameter values are 4 bytes at most
+#define SCOMX_CACHE_VALUE_SIZE 8
+
+typedef enum {
+    SCOMX_CACHE_EMPTY = 0, // no value cached and no read in flight
+    SCOMX_CACHE_PENDING,   // a read was issued and its result is awaited
+    SCOMX_CACHE_VALID,     // a value is cached (it may be expired)
+} scomx_cache_state_t;
+
+typedef struct {
+    /** \brief key of the entry */
+    uint32_t dst_addr;
+    uint16_t object_type;
+    uint32_t object_id;
+    uint16_t property_id;
+
+    /** \brief 0 for an unused slot */
+    int used;
+
+    scomx_cache_state_t state;
+
+    /** \brief set when value holds a previously read value, also while a refresh is pending */
+    int has_value;
+
+    /** \brief how long a read value is served from the cache */
+    uint32_t ttl_ms;
+
+    /** \brief time the value was stored */
+    int64_t updated_ms;
+
+    /** \brief time the pending read was issued, or sent when reported with scomx_cache_sent */
+    int64_t pending_since_ms;
+
+    /** \brief set while the pending read waits in a queue (see scomx_cache_queued), its timeout isn't running */
+    int pending_queued;
+
+    /** \brief decoded fields of the cached response */
+    uint32_t src_addr;
+    uint8_t service_id;
+    size_t length;
+    char value[SCOMX_CACHE_VALUE_SIZE];
+
+    /** \brief free for the caller, e.g. the list of consumers waiting for the pending read */
+    void *waiters;
+} scomx_cache_entry_t;
+
+typedef struct {
+    /** \brief caller-owned hash table */
+    scomx_cache_entry_t *entries;
+
+    /** \brief number of entries, must be a power of two */
+    size_t capacity;
+
+    /** \brief number of used entries */
+    size_t count;
+
+    /** \brief TTL of entries without their own */
+    uint32_t default_ttl_ms;
+
+    /** \brief time after which a pending read whose result was never stored is issued again */
+    uint32_t pending_timeout_ms;
+
+    /** \brief lookups served from the cache */
+    unsigned long hits;
+
+    /** \brief lookups which need a read on the wire */
+    unsigned long misses;
+
+    /** \brief lookups which found the same read already pending */
+    unsigned long coalesced;
+
+    /** \brief lookups not cached because the table is full */
+    unsigned long overflows;
+} scomx_cache_t;
+
+typedef enum {
+    SCOMX_CACHE_HIT = 0, // result holds the cached value
+    SCOMX_CACHE_MISS,    // the caller should read the property and pass the response to scomx_cache_store
+    SCOMX_CACHE_WAIT,    // the property is already being read, the caller should wait for that result
+} scomx_cache_status_t;
+
+typedef struct {
+    scomx_cache_status_t status;
+
+    /** \brief entry of the key; NULL on a miss when the table is full */
+    scomx_cache_entry_t *entry;
+
+    /** \brief cached value; only valid on a hit */
+    scomx_dec_result_t result;
+} scomx_cache_lookup_t;
+
+// size of the cache lines kept apart in structures shared between threads
+#define SCOMX_CACHE_LINE_SIZE 64
+
+#ifdef __cplusplus
+#define SCOMX_ALIGNED(n) alignas(n)
+#else
+#define SCOMX_ALIGNED(n) _Alignas(n)
+#endif
+
+typedef struct {
+    int64_t timestamp_ms;
+    float value;
+    scom_error_t error;
+} scomx_sample_t;
+
+// a slot never straddles two cache lines
+typedef struct {
+    SCOMX_ALIGNED(32) int64_t timestamp_ms;
+    float value;
+    uint16_t error;
+
+    /** \brief 2 * n + 2 once sample n is stored in the slot, odd while the producer writes it */
+    uint32_t seq;
+} scomx_history_slot_t;
+
+typedef struct {
+    /** \brief caller-owned array of slots, read by the consumers */
+    scomx_history_slot_t *slots;
+
+    /** \brief number of slots minus one, the number of slots being a power of two */
+    uint32_t mask;
+
+    /** \brief number of samples written so far; on its own cache line, which only the producer writes */
+    SCOMX_ALIGNED(SCOMX_CACHE_LINE_SIZE) uint32_t head;
+} scomx_history_t;
+
+// first bytes of a snapshot region, "SXSN"
+#define SCOMX_SNAPSHOT_MAGIC 0x4E535853u
+// changes with the layout of the region
+#define SCOMX_SNAPSHOT_VERSION 1
+
+// start of a snapshot region; the fields are written by the publisher only, before it adds slots
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+
+    /** \brief sizeof(scomx_snapshot_slot_t) of the publisher */
+    uint32_t slot_size;
+
+    /** \brief number of slots following the header */
+    uint32_t capacity;
+
+    /** \brief number of slots added so far */
+    uint32_t count;
+
+    /** \brief changes every time the publisher initializes the region, so readers can find their slots again */
+    uint32_t generation;
+} scomx_snapshot_header_t;
+
+// latest value of one property; no pointers, the region is mapped at different addresses by every process
+typedef struct {
+    SCOMX_ALIGNED(32) int64_t timestamp_ms;
+    float value;
+    uint16_t error;
+    uint16_t object_type;
+    uint32_t object_id;
+    uint32_t dst_addr;
+
+    /** \brief even once a value is published, odd while the publisher writes it, 0 before the first value */
+    uint32_t seq;
+} scomx_snapshot_slot_t;
+
+typedef struct {
+    /** \brief header at the start of the region, followed by the slots on the next cache line */
+    scomx_snapshot_header_t *header;
+    scomx_snapshot_slot_t *slots;
+} scomx_snapshot_t;
+
+typedef enum {
+    /** \brief every sample passes */
+    SCOMX_FILTER_EVERY = 0,
+    /** \brief values pass when they moved beyond the deadband from the last value passed */
+    SCOMX_FILTER_DEADBAND = 1,
+    /** \brief values pass when they differ from the last value passed, for enums, bools and counters */
+    SCOMX_FILTER_CHANGE = 2,
+} scomx_filter_mode_t;
+
+typedef struct {
+    scomx_filter_mode_t mode;
+
+    /** \brief deadband in the unit of the value; the larger of both deadbands applies */
+    float abs_deadband;
+    /** \brief deadband as a fraction of the last value passed, e.g. 0.01 for 1% */
+    float rel_deadband;
+
+    /** \brief a sample passes when none did for this long, so consumers can tell a steady value from a dead link; 0 for none */
+    uint32_t heartbeat_ms;
+} scomx_filter_config_t;
+
+// change detection of one polled property
+typedef struct {
+    scomx_filter_config_t config;
+
+    /** \brief last sample passed, valid once passed is non-zero */
+    float value;
+    scom_error_t error;
+    int64_t passed_ms;
+
+    /** \brief totals since the initialization */
+    unsigned long passed;
+    unsigned long suppressed;
+} scomx_filter_t;
+
+// first bytes of a capture file, "SXCP", followed by the version and the size of a record header (16 bits each)
+#define SCOMX_CAPTURE_MAGIC 0x50435853u
+#define SCOMX_CAPTURE_VERSION 1
+#define SCOMX_CAPTURE_FILE_HEADER_SIZE 8
+
+// timestamp (64 bits), length of the data (16 bits), port and direction (8 bits each), little endian
+#define SCOMX_CAPTURE_RECORD_HEADER_SIZE 12
+
+typedef enum {
+    /** \brief bytes written to the gateway */
+    SCOMX_CAPTURE_TX = 0,
+    /** \brief bytes read from the gateway, in the chunks they were received */
+    SCOMX_CAPTURE_RX = 1,
+} scomx_capture_direction_t;
+
+typedef struct {
+    /** \brief monotonic time the bytes were transferred, in microseconds */
+    int64_t timestamp_us;
+
+    /** \brief port of the capturing application, e.g. its index in the event loop */
+    uint8_t port;
+    scomx_capture_direction_t direction;
+
+    /** \brief raw bytes as on the wire */
+    const char *data;
+    size_t length;
+} scomx_capture_record_t;
+
+// encoded records waiting to be written out
+typedef struct {
+    char *buffer;
+    size_t size;
+
+    /** \brief number of bytes in the buffer, starting with the file header until the first consume */
+    size_t length;
+
+    /** \brief totals since the initialization */
+    unsigned long records;
+    // records which didn't fit in the buffer because it wasn't written out fast enough
+    unsigned long dropped;
+} scomx_capture_t;
+
+// frame of a hex text log, decoded
+typedef struct {
+    /** \brief line of the frame in the log, counting from 1 */
+    unsigned long line;
+
+    /** \brief binary frame, valid until the next record is read */
+    char *frame;
+    size_t frame_length;
+
+    /** \brief set for responses, by the service flags of the frame */
+    int is_response;
+
+    /** \brief decoded request or response; the property data points into frame */
+    scomx_dec_result_t result;
+
+    /** \brief value decoded by the metadata of the object; only set for responses, its error is that of the result otherwise */
+    scomx_typed_value_t value;
+} scomx_hexlog_record_t;
+
+typedef struct {
+    const char *text;
+    size_t length;
+
+    /** \brief position of the next line in text */
+    size_t offset;
+    unsigned long line;
+
+    /** \brief caller-provided buffer the frames are decoded into; longer frames are invalid lines */
+    char *frame;
+    size_t frame_size;
+
+    /** \brief totals since the initialization */
+    unsigned long records;
+    // lines which aren't an even number of hex digits
+    unsigned long invalid_lines;
+} scomx_hexlog_t;
+
+typedef struct {
+    /** \brief retries after the first attempt */
+    unsigned max_retries;
+
+    /** \brief delay before the first retry, doubled for every further retry */
+    uint32_t base_delay_ms;
+
+    /** \brief bound of the retry delays and of the backoff of a destination */
+    uint32_t max_delay_ms;
+
+    /** \brief share of every delay drawn at random, from 0 (fixed delays) to 1 (uniform in [0, delay]) */
+    float jitter;
+
+    /** \brief time a request may take with its retries, from scomx_retry_begin; 0 for no limit */
+    uint32_t budget_ms;
+} scomx_retry_config_t;
+
+// error codes counted separately for each destination; further codes are counted as other_errors
+#define SCOMX_RETRY_ERROR_SLOTS 6
+
+typedef struct {
+    scom_error_t error;
+    unsigned long count;
+} scomx_retry_error_count_t;
+
+typedef struct {
+    uint32_t dst_addr;
+
+    /** \brief 0 for an unused slot */
+    int used;
+
+    /** \brief grows while the destination is busy or doesn't respond, halves with every success */
+    uint32_t backoff_ms;
+
+    /** \brief no request should be sent to the destination before this time */
+    int64_t not_before_ms;
+
+    /** \brief counters */
+    unsigned long attempts;
+    unsigned long successes;
+    unsigned long retries;
+    /** \brief requests failed with a fatal error, or with a retryable one after the last retry or at the deadline */
+    unsigned long failures;
+    /** \brief failed attempts by error code */
+    scomx_retry_error_count_t errors[SCOMX_RETRY_ERROR_SLOTS];
+    unsigned long other_errors;
+} scomx_retry_dest_t;
+
+typedef struct {
+    scomx_retry_config_t config;
+
+    /** \brief caller-owned array of destinations */
+    scomx_retry_dest_t *dests;
+    size_t capacity;
+
+    /** \brief state of the jitter generator */
+    uint32_t random;
+
+    /** \brief attempts not counted because the destination table is full */
+    unsigned long overflows;
+} scomx_retry_t;
+
+typedef struct {
+    uint32_t dst_addr;
+
+    /** \brief attempts completed so far */
+    unsigned attempts;
+
+    /** \brief the request fails instead of being retried past this time; 0 for no limit */
+    int64_t deadline_ms;
+} scomx_retry_state_t;
+
+typedef enum {
+    SCOMX_RETRY_SUCCEEDED = 0, // the attempt succeeded
+    SCOMX_RETRY_AGAIN,         // the request should be sent again at retry_at_ms
+    SCOMX_RETRY_FAILED,        // fatal error, last retry done or deadline reached: the error goes to the caller
+} scomx_retry_action_t;
+
+typedef struct {
+    scomx_retry_action_t action;
+
+    /** \brief only valid with SCOMX_RETRY_AGAIN */
+    int64_t retry_at_ms;
+} scomx_retry_decision_t;
+
 // DESTINATIONS
 
 typedef uint32_t scomx_dest_t;
@@ -310,6 +1081,7 @@ typedef enum {
     SCOMX_PARAM_RC_DATE = 5002, // unix timestamp of the current date/time
 
     // Xtender (Inverter)
+    SCOMX_PARAM_XTENDER_AC_IN_CURRENT_MAX = 1107,               // A, float - Maximum current of AC source (Input limit)
     SCOMX_PARAM_XTENDER_BAT_CHARGER_ALLOWED = 1125,             // bool - Charger allowed
     SCOMX_PARAM_XTENDER_TRANSFER_RELAY_ALLOWED = 1128,          // bool - enable transfer relay
     SCOMX_PARAM_XTENDER_BAT_CYCLE_FORCE_NEW = 1142,             // int - Force a new cycle
@@ -395,6 +1167,15 @@ scomx_enc_result_t scomx_encode_write_parameter_unsaved_value_u16(scomx_dest_t d
 // Encodes writing into the "unsaved_value_qsp" property of a "parameter-type" (0x2) object
 scomx_enc_result_t scomx_encode_write_parameter_unsaved_value_float(scomx_dest_t dst_addr, scomx_parameter_object_t object_id, float val);
 
+// FUNCTIONS - PRE-ENCODED REQUESTS
+//
+// The bytes of a read request for a fixed property never change, so frames polled repeatedly can be
+// encoded once (or at compile time with scomx::read_request_frame from scomlib_extra_frames.hpp) and
+// sent as they are. The frames are identical to the ones encoded by scomx_encode_read_property.
+
+// Encodes a read request for the property into frame, which must hold SCOMX_READ_REQUEST_SIZE bytes
+void scomx_encode_read_request_frame(char *frame, uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id);
+
 // FUNCTIONS - RESPONSE ENCODING
 
 // Decode frame header from data read from the port. Read data must be exactly
@@ -403,6 +1184,267 @@ scomx_header_dec_result_t scomx_decode_frame_header(const char *const data, size
 // Decode the rest of the frame (after the header)
 scomx_dec_result_t scomx_decode_frame(const char *const data, size_t data_len);
 
+// FUNCTIONS - IN-PLACE RESPONSE DECODING
+//
+// These functions parse the frame where it already sits in the caller's receive buffer, without
+// copying it into a scomx buffer. They keep no state, so they can be called from any thread.
+// The decoded property data points into the passed buffer and stays valid as long as that buffer.
+
+// Decode frame header at the beginning of data, which must contain at least SCOM_FRAME_HEADER_SIZE
+// bytes. Returns the number of bytes which still need to follow the header.
+scomx_header_dec_result_t scomx_decode_frame_header_inplace(char *const data, size_t data_len);
+// Decode a complete frame (header, data and data checksum) starting at the beginning of data.
+// Any bytes after the end of the frame are ignored.
+scomx_dec_result_t scomx_decode_frame_inplace(char *const data, size_t data_len);
+
+// FUNCTIONS - DEVICE SIDE
+//
+// Counterparts of the functions above for implementing a device, e.g. a simulator for tests.
+
+// Decode a complete request frame in place. dst_addr is the addressed device, data points to the
+// value of a write request.
+scomx_dec_result_t scomx_decode_request_inplace(char *const data, size_t data_len);
+// Encodes a successful response to a read (carrying the value) or write (without data) request
+scomx_enc_result_t scomx_ctx_encode_property_response(scomx_ctx_t *ctx, uint32_t src_addr, scom_frame_flags_t frame_flags, scom_service_t service_id,
+                                                      scom_object_type_t object_type, uint32_t object_id, uint16_t property_id, const char *const data, size_t data_len);
+// Encodes a response reporting an error to the request
+scomx_enc_result_t scomx_ctx_encode_error_response(scomx_ctx_t *ctx, uint32_t src_addr, scom_frame_flags_t frame_flags, scom_service_t service_id,
+                                                   scom_object_type_t object_type, uint32_t object_id, uint16_t property_id, scom_error_t error);
+
+// FUNCTIONS - BYTE STREAM PARSING
+//
+// Push-style alternative to reading exactly SCOM_FRAME_HEADER_SIZE and then length_to_read bytes.
+// Any chunk of received bytes can be pushed; the parser hunts for SCOMX_START_BYTE, verifies the header
+// checksum before waiting for the data and drops candidates failing any checksum, so the stream
+// resynchronises on the next frame after a lost byte or a stale response.
+//
+// Typical receive loop:
+//   size_t n = read(fd, buf, sizeof(buf)), off = 0;
+//   for (;;) {
+//       scomx_parse_result_t r = scomx_parser_push(&parser, buf + off, n - off);
+//       off += r.consumed;
+//       if (!r.frame_ready) break;
+//       handle(r.result);
+//   }
+
+// Initializes the parser to assemble frames in the caller-provided buffer. The buffer must hold at least
+// SCOM_FRAME_HEADER_SIZE bytes, plus the data and its checksum of the longest frame expected; with a
+// smaller one buffer_size is set to 0 and every pushed byte is discarded.
+void scomx_parser_init(scomx_parser_t *parser, char *buffer, size_t buffer_size);
+// Drops any partially received frame, e.g. after a response timeout
+void scomx_parser_reset(scomx_parser_t *parser);
+// Consumes input bytes until a complete frame is received or the input is exhausted. The returned
+// frame and result data point into the parser buffer and are valid until the next push or reset.
+scomx_parse_result_t scomx_parser_push(scomx_parser_t *parser, const char *data, size_t data_len);
+
+// FUNCTIONS - CHECKSUM
+//
+// Frame checksums (RFC1146 8 bit Fletcher, as computed by scom_calc_checksum) for large payloads such
+// as datalog or byte stream transfers; the frame decoders verify the data checksum with them, the
+// copying scomx_ctx_decode_frame in the same pass as the copy. The best kernel for the CPU (AVX2,
+// SSE2, NEON or portable C) is picked on the first call. A checksum over data received in pieces is computed by starting from
+// SCOMX_CHECKSUM_INIT and passing the previous result to the *_update variants.
+
+#define SCOMX_CHECKSUM_INIT ((uint16_t)0x00FF)
+
+// Returns the checksum of data
+uint16_t scomx_checksum(const char *data, size_t length);
+// Continues the checksum over the next piece of data
+uint16_t scomx_checksum_update(uint16_t checksum, const char *data, size_t length);
+// Copies src to dst and returns the checksum of the copied data in a single pass
+uint16_t scomx_copy_checksum(char *dst, const char *src, size_t length);
+// Copies src to dst and continues the checksum over the copied data in a single pass
+uint16_t scomx_copy_checksum_update(uint16_t checksum, char *dst, const char *src, size_t length);
+// Byte at a time reference implementation, only meant for verification and benchmarks
+uint16_t scomx_checksum_ref(const char *data, size_t length);
+// Returns the name of the kernel in use ("avx2", "sse2", "neon" or "scalar")
+const char *scomx_checksum_kernel_name();
+
+// FUNCTIONS - POLLING SCHEDULER
+//
+// Decides which property to read next when more values are polled than the link can read at once.
+// Each subscription is read once per period and the read due first (earliest deadline first) is
+// issued next, so fast changing values refresh at their own rate while slow counters get the
+// remaining link time. When the link is overloaded, late reads are issued in priority order.
+// The scheduler does no I/O; all times are passed in by the caller (e.g. serial_now_ms()).
+//
+// Typical loop:
+//   scomx_subscription_t *sub = scomx_sched_next(&sched, now);
+//   if (sub) {
+//       ... send sub->frame (SCOMX_READ_REQUEST_SIZE bytes), receive the response ...
+//       scomx_sched_complete(&sched, sub, res.error, now);
+//   } else {
+//       sleep for scomx_sched_wait_ms(&sched, now)
+//   }
+
+// Initializes the scheduler to keep subscriptions in the caller-provided array
+void scomx_sched_init(scomx_sched_t *sched, scomx_subscription_t *subscriptions, size_t capacity, int64_t now_ms);
+// Adds a property read every period_ms, the first one being due immediately; returns NULL when full
+scomx_subscription_t *scomx_sched_add(scomx_sched_t *sched, uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id,
+                                      uint32_t period_ms, uint8_t priority, int64_t now_ms);
+// Returns the read to issue now and marks it in flight, or NULL when no read is due
+scomx_subscription_t *scomx_sched_next(scomx_sched_t *sched, int64_t now_ms);
+// Reports the end of a read returned by scomx_sched_next, successful or not
+void scomx_sched_complete(scomx_sched_t *sched, scomx_subscription_t *sub, scom_error_t error, int64_t now_ms);
+// Returns the time until the next read is due, 0 when one is due now or -1 when there is nothing to read
+int scomx_sched_wait_ms(const scomx_sched_t *sched, int64_t now_ms);
+// Returns statistics since the last reset
+scomx_sched_stats_t scomx_sched_stats(const scomx_sched_t *sched, int64_t now_ms);
+// Resets the counters and starts measuring the utilization from now
+void scomx_sched_reset_stats(scomx_sched_t *sched, int64_t now_ms);
+
+// FUNCTIONS - FRAME FLAGS
+
+// The Xcom-232i reports pending messages, RCC resets and the SD card state in the header of every
+// response. A watch fed with all received frames calls back only when a flag changes, so work such as
+// reading new messages or dropping cached parameters is done once per event instead of polling for it.
+// The flags are all clear before the first frame, so flags already set then are reported as raised.
+
+// Returns the flags as the frame_flags byte, see scomx_frame_flag_t
+uint8_t scomx_frame_flags_byte(scom_frame_flags_t flags);
+// Returns the flags of a frame_flags byte, e.g. to encode a response
+scom_frame_flags_t scomx_frame_flags_from_byte(uint8_t byte);
+
+// Initializes the watch to call callback when any flag of mask (scomx_frame_flag_t bits) changes
+void scomx_flags_watch_init(scomx_flags_watch_t *watch, uint8_t mask, scomx_flags_callback_t callback, void *user);
+// Checks the flags of a decoded frame, calling the callback on a change; returns the watched flags raised by it.
+// Results without frame flags (e.g. timeouts) are ignored.
+uint8_t scomx_flags_watch_update(scomx_flags_watch_t *watch, const scomx_dec_result_t *res);
+// Forgets that the flags are set, so that they are reported as raised again by the next frame still
+// carrying them, e.g. after handling the event failed
+void scomx_flags_watch_rearm(scomx_flags_watch_t *watch, uint8_t flags);
+
+// FUNCTIONS - MESSAGE LOG
+
+// Reads the messages of the message objects (section 4.6) which are newer than a cursor. object_id 0
+// is the newest message and every message carries the total number of messages, so the fetch reads
+// from the newest message towards older ones and stops as soon as it reaches the cursor; history is
+// never read again. Messages are delivered newest first with their seq. The cursor advances only when
+// a fetch completes, so messages of a failed fetch are delivered again by the next one.
+//
+// The message log does no I/O: the caller sends the requests and completes them with the responses,
+// e.g. on a port of an event loop. A fetch is typically started when SCOMX_FLAG_MESSAGE_PENDING is raised.
+//
+//   scomx_msglog_start(&log);
+//   while (scomx_msglog_next(&log, frame)) {
+//       ... send frame (SCOMX_READ_REQUEST_SIZE bytes), receive the response ...
+//       scomx_msglog_complete(&log, &res);
+//   }
+//   ... persist log.cursor ...
+
+// Decodes the message of a message object response; the index is taken from res->object_id
+scom_error_t scomx_decode_message(const scomx_dec_result_t *res, scomx_message_t *message);
+
+// Initializes the message log to fetch messages from seq cursor on (0 for all messages kept by the gateway)
+void scomx_msglog_init(scomx_msglog_t *log, uint32_t dst_addr, uint32_t cursor, scomx_message_callback_t callback, void *user);
+// Starts a fetch; when one is in progress another one follows it, so messages arriving meanwhile are read too
+void scomx_msglog_start(scomx_msglog_t *log);
+// Encodes the next read of the fetch into frame (SCOMX_READ_REQUEST_SIZE bytes); returns 0 when there is nothing to read
+int scomx_msglog_next(scomx_msglog_t *log, char *frame);
+// Completes the read returned by scomx_msglog_next, delivering the message. Returns the error which ended
+// the fetch without advancing the cursor, SCOM_ERROR_NO_ERROR otherwise.
+scom_error_t scomx_msglog_complete(scomx_msglog_t *log, const scomx_dec_result_t *res);
+
+// FUNCTIONS - VALUE CACHE
+//
+// Read-through cache of property values keyed by (dst_addr, object_type, object_id, property_id), so
+// consumers interested in the same values share the reads on the wire. A lookup of a fresh value is a
+// hit; otherwise the first lookup is a miss, which makes the entry pending, and the caller reads the
+// property and stores the response. Lookups while the read is pending return SCOMX_CACHE_WAIT, so
+// simultaneous misses on a key produce a single frame. Only successful responses are cached.
+//
+// The cache does no I/O and takes the current time from the caller. It is not thread safe.
+
+// Initializes the cache in the caller-provided table; capacity must be a power of two
+void scomx_cache_init(scomx_cache_t *cache, scomx_cache_entry_t *entries, size_t capacity, uint32_t default_ttl_ms);
+// Sets the TTL of a key, e.g. longer for daily counters than for power values; returns NULL when full
+scomx_cache_entry_t *scomx_cache_set_ttl(scomx_cache_t *cache, uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id,
+                                         uint32_t ttl_ms);
+// Looks up a value; see scomx_cache_status_t for what the caller should do next
+scomx_cache_lookup_t scomx_cache_lookup(scomx_cache_t *cache, uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id,
+                                        int64_t now_ms);
+// Stops the pending timeout of the entry returned by a miss while its read waits in a queue, until
+// scomx_cache_sent; the caller must then report the send or store a result
+void scomx_cache_queued(scomx_cache_t *cache, scomx_cache_entry_t *entry);
+// Starts the pending timeout of the entry again when its read is actually sent
+void scomx_cache_sent(scomx_cache_t *cache, scomx_cache_entry_t *entry, int64_t now_ms);
+// Completes the pending read of the entry returned by a miss with the decoded response
+void scomx_cache_store(scomx_cache_t *cache, scomx_cache_entry_t *entry, const scomx_dec_result_t *res, int64_t now_ms);
+// Returns the cached value of the entry as a decoded response with data pointing into the entry
+scomx_dec_result_t scomx_cache_result(scomx_cache_entry_t *entry);
+// Drops the cached value of a key, e.g. after writing the property
+void scomx_cache_invalidate(scomx_cache_t *cache, uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id);
+// Drops the cached values of all properties of the object type, e.g. parameters after an RCC reset
+void scomx_cache_invalidate_type(scomx_cache_t *cache, scom_object_type_t object_type);
+
+// FUNCTIONS - BATCHED READS
+//
+// Reads many properties back to back over a transport. Each request is encoded while the previous
+// one is on the wire and written as soon as the previous response is received, so the link stays busy
+// without round trips through the application.
+
+// Receives the response to a request for the property, skipping frames which don't belong to it, until
+// the absolute deadline. Returns SCOM_ERROR_NO_ERROR when the response arrived (res->error tells whether
+// the device reported an error), SCOM_ERROR_RESPONSE_TIMEOUT or SCOM_ERROR_STACK_PORT_READ_FAILED.
+// The decoded data points into the parser buffer.
+scom_error_t scomx_receive_response(const scomx_transport_t *transport, scomx_parser_t *parser, uint32_t dst_addr, uint16_t object_type, uint32_t object_id,
+                                    uint16_t property_id, int64_t deadline_ms, scomx_dec_result_t *res);
+// Reads all items in order, filling in their result; returns the number of successful reads.
+// After a transport error the remaining items fail with the same error.
+size_t scomx_read_many(const scomx_transport_t *transport, scomx_read_item_t *items, size_t count);
+
+// FUNCTIONS - DATALOG DOWNLOAD
+//
+// Downloads datalog files from the SD card (section 4.8.1) block by block over a transport. Each
+// block is passed to a sink (e.g. written straight to a file), so the memory needed is bounded by the
+// receive buffer whatever the file size. Lost or corrupted blocks are requested again.
+//
+// A download interrupted after some bytes were stored is resumed by fetching the file again with
+// skip set to the number of bytes already stored; those bytes are received but not passed to the sink.
+
+// Initializes the downloader to receive blocks into the caller-provided buffer of at least SCOMX_DATALOG_BUFFER_SIZE bytes
+void scomx_datalog_init(scomx_datalog_t *dl, const scomx_transport_t *transport, uint32_t dst_addr, char *buffer, size_t buffer_size);
+// Reads the object_ids of the files on the SD card into file_ids; count is set to the number of files
+// stored, at most max_files
+scom_error_t scomx_datalog_list(scomx_datalog_t *dl, uint32_t *file_ids, size_t max_files, size_t *count);
+// Downloads the file, passing all bytes after the first skip ones to the sink. When the sink stops the
+// download, SCOM_ERROR_STACK_BUFFER_TOO_SMALL is returned and sink_refused is set.
+scom_error_t scomx_datalog_fetch(scomx_datalog_t *dl, uint32_t file_id, uint32_t skip, scomx_datalog_sink_t sink, void *user);
+
+// FUNCTIONS - REENTRANT CONTEXT API
+//
+// The functions above share a single static buffer, so results of one call are only valid until the
+// next one. The scomx_ctx_* variants below do the same work using a caller-owned context and buffer,
+// so independent contexts (e.g. one per serial port and thread) can be used concurrently.
+// Encoded data and decoded property data point into the context buffer.
+
+// Initializes the context to use the caller-provided buffer
+void scomx_ctx_init(scomx_ctx_t *ctx, char *buffer, size_t buffer_size);
+
+scomx_enc_result_t scomx_ctx_encode_read_property(scomx_ctx_t *ctx, uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id);
+scomx_enc_result_t scomx_ctx_encode_read_user_info_value(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_user_info_object_t object_id);
+scomx_enc_result_t scomx_ctx_encode_read_parameter_value(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id);
+scomx_enc_result_t scomx_ctx_encode_read_parameter_unsaved_value(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id);
+scomx_enc_result_t scomx_ctx_encode_read_parameter_min(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id);
+scomx_enc_result_t scomx_ctx_encode_read_parameter_max(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id);
+scomx_enc_result_t scomx_ctx_encode_read_parameter_level(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id);
+
+scomx_enc_result_t scomx_ctx_encode_write_property(scomx_ctx_t *ctx, uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id,
+                                                   const char *const data, size_t data_len);
+scomx_enc_result_t scomx_ctx_encode_write_parameter_value(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id, const char *const data,
+                                                          size_t data_len);
+scomx_enc_result_t scomx_ctx_encode_write_parameter_value_u32(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id, uint32_t val);
+scomx_enc_result_t scomx_ctx_encode_write_parameter_value_u16(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id, uint16_t val);
+scomx_enc_result_t scomx_ctx_encode_write_parameter_value_float(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id, float val);
+scomx_enc_result_t scomx_ctx_encode_write_parameter_unsaved_value(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id, const char *const data,
+                                                                  size_t data_len);
+scomx_enc_result_t scomx_ctx_encode_write_parameter_unsaved_value_u32(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id, uint32_t val);
+scomx_enc_result_t scomx_ctx_encode_write_parameter_unsaved_value_u16(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id, uint16_t val);
+scomx_enc_result_t scomx_ctx_encode_write_parameter_unsaved_value_float(scomx_ctx_t *ctx, scomx_dest_t dst_addr, scomx_parameter_object_t object_id, float val);
+
+scomx_header_dec_result_t scomx_ctx_decode_frame_header(scomx_ctx_t *ctx, const char *const data, size_t data_len);
+scomx_dec_result_t scomx_ctx_decode_frame(scomx_ctx_t *ctx, const char *const data, size_t data_len);
+
 // FUNCTIONS - RESPONSE RESULT DATA TYPE DECODING
 
 // Reads native-endian uint32_t or uint16_t value from the response if the response is valid and
@@ -412,6 +1454,197 @@ uint32_t scomx_result_int(scomx_dec_result_t res);
 // on all platforms.
 float scomx_result_float(scomx_dec_result_t res);
 
+// FUNCTIONS - OBJECT METADATA
+
+// Format, unit, scale, enum labels and access of the objects listed in scomlib_extra_objects.def,
+// which is the single source of the metadata table. A lookup is a constant time dense index access.
+// The decode and encode functions of the metadata do the conversion of the object's format, so a
+// decoding loop can keep the metadata of each property it reads and needs no per-object branching
+// (C++ code gets the same at compile time with scomx::client::read from scomlib_extra_client.hpp):
+//
+//   const scomx_object_meta_t *meta = scomx_object_meta(SCOM_USER_INFO_OBJECT_TYPE, object_id);
+//   ...
+//   scomx_typed_value_t v = meta->decode(meta, &res);
+//   printf("%.2f %s\n", v.value, meta->unit);
+
+// Returns the metadata of the object, NULL when it isn't listed
+const scomx_object_meta_t *scomx_object_meta(scom_object_type_t object_type, uint32_t object_id);
+// Decodes the value of a response by the metadata of its object; unlisted objects are decoded as float
+scomx_typed_value_t scomx_decode_typed(const scomx_dec_result_t *res);
+
+// FUNCTIONS - RETRY POLICY
+//
+// Decides whether and when a failed request is sent again. Only SCOM_ERROR_RESPONSE_TIMEOUT and
+// SCOM_ERROR_GATEWAY_BUSY are retried, with exponentially growing, jittered delays, up to
+// max_retries and never past the deadline of the request. Every destination also has an adaptive
+// backoff, which grows with each busy or missing response and shrinks with each success, so
+// requests to a struggling device are spread out instead of adding to its load: callers should not
+// send to a destination before the time returned by scomx_retry_begin.
+//
+// Attempts are counted per destination and error code in the caller-provided table. The policy
+// does no I/O and takes the current time from the caller. It is not thread safe.
+//
+// Typical loop:
+//   scomx_retry_state_t state;
+//   int64_t send_at = scomx_retry_begin(&retry, &state, dst_addr, now);
+//   for (;;) {
+//       ... wait until send_at, send the request, receive the response ...
+//       scomx_retry_decision_t d = scomx_retry_complete(&retry, &state, res.error, now);
+//       if (d.action != SCOMX_RETRY_AGAIN) {
+//           break;
+//       }
+//       send_at = d.retry_at_ms;
+//   }
+
+// Initializes the policy with the default configuration and the caller-provided destination table;
+// seed starts the jitter generator, e.g. from the time so that several gateways don't retry in step
+void scomx_retry_init(scomx_retry_t *retry, scomx_retry_dest_t *dests, size_t capacity, uint32_t seed);
+// Returns non-zero for the errors after which the same request may succeed
+int scomx_retry_is_retryable(scom_error_t error);
+// Starts a request to the destination, with its deadline set from budget_ms (the caller may change
+// it); returns the time the first attempt may be sent, later than now_ms while the destination backs off
+int64_t scomx_retry_begin(scomx_retry_t *retry, scomx_retry_state_t *state, uint32_t dst_addr, int64_t now_ms);
+// Counts the outcome of an attempt and decides what to do next
+scomx_retry_decision_t scomx_retry_complete(scomx_retry_t *retry, scomx_retry_state_t *state, scom_error_t error, int64_t now_ms);
+// Returns the counters of a destination, NULL when nothing was sent to it
+const scomx_retry_dest_t *scomx_retry_dest(const scomx_retry_t *retry, uint32_t dst_addr);
+// Returns how often attempts to the destination failed with the error
+unsigned long scomx_retry_error_count(const scomx_retry_dest_t *dest, scom_error_t error);
+
+// FUNCTIONS - SAMPLE HISTORY
+//
+// Fixed-size ring of the latest (timestamp, value, error) samples of one polled property, shared
+// between the thread polling the devices and any number of consumer threads. The producer never
+// waits and overwrites the oldest sample; every slot is a small seqlock, so a consumer copies
+// samples without locks or system calls and drops those overwritten while being read instead of
+// retrying (reads are wait-free). A consumer keeps its own cursor, so consumers don't slow each
+// other down, and one which falls more than the ring size behind loses the oldest samples.
+//
+// There must be a single producer per history. Relies on the GCC/Clang __atomic builtins.
+
+// Initializes an empty history in the caller-provided slots; capacity must be a power of two
+void scomx_history_init(scomx_history_t *history, scomx_history_slot_t *slots, size_t capacity);
+// Appends a sample, e.g. the value of scomx_decode_typed and its error; producer thread only
+void scomx_history_push(scomx_history_t *history, int64_t timestamp_ms, float value, scom_error_t error);
+// Copies the samples written since *cursor (0 for the first call), oldest first, and advances the cursor
+// past them; lost receives the number of samples overwritten before they could be copied (may be NULL)
+size_t scomx_history_read(const scomx_history_t *history, uint32_t *cursor, scomx_sample_t *samples, size_t max, uint32_t *lost);
+// Copies the latest samples, up to max, oldest first
+size_t scomx_history_recent(const scomx_history_t *history, scomx_sample_t *samples, size_t max);
+
+// FUNCTIONS - SHARED SNAPSHOT
+//
+// Latest value of every polled property in a memory region shared between processes, e.g. a file
+// in /dev/shm mapped by the polling daemon and by every reader. The daemon publishes each value
+// into its own slot, which is a seqlock like the slots of the sample history; a reader finds the
+// slot of a property once and then reads the value straight from the mapping, with no system
+// call and no copy besides the value itself. A reader never blocks the publisher and gives up
+// after a few attempts when a value is being written all the time or the publisher died while
+// writing it. Timestamps are those of the publisher, which should use a clock shared by the
+// processes (CLOCK_MONOTONIC, as serial_now_ms).
+//
+// There must be a single publisher per region. Relies on the GCC/Clang __atomic builtins.
+
+// Returns the size of a region holding capacity slots
+size_t scomx_snapshot_size(size_t capacity);
+// Initializes the region as publisher, with as many slots as fit in size; returns -1 when not even one fits
+int scomx_snapshot_create(scomx_snapshot_t *snap, void *memory, size_t size);
+// Attaches to a region initialized by the publisher; returns -1 when it isn't a snapshot of this layout
+int scomx_snapshot_attach(scomx_snapshot_t *snap, const void *memory, size_t size);
+// Adds the slot of a property as publisher; returns its index or -1 when the region is full
+int scomx_snapshot_add(scomx_snapshot_t *snap, uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id);
+// Publishes the latest value of the slot
+void scomx_snapshot_publish(scomx_snapshot_t *snap, int index, int64_t timestamp_ms, float value, scom_error_t error);
+// Returns the index of the slot of a property, -1 when the publisher doesn't publish it
+int scomx_snapshot_find(const scomx_snapshot_t *snap, uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id);
+// Reads the latest value of the slot; returns -1 when no value was published yet or no consistent value could be read
+int scomx_snapshot_read(const scomx_snapshot_t *snap, int index, scomx_sample_t *sample);
+// Returns the generation of the region, which changes when the publisher initializes it again
+uint32_t scomx_snapshot_generation(const scomx_snapshot_t *snap);
+
+// FUNCTIONS - CHANGE FILTER
+//
+// Drops the decoded samples of a polled property which don't tell consumers anything new, before
+// they are published or stored. Float values pass when they moved beyond a deadband, enum, bool and
+// integer values when they changed at all, and errors when the error changed. Whatever the mode, a
+// sample passes when none did for heartbeat_ms. The first sample always passes.
+//
+// The filter does no I/O and takes the current time from the caller. It is not thread safe.
+
+// Returns the configuration by the format of the object: exact change for enums, bools and integers,
+// a 1% deadband for floats, a heartbeat of a minute; every sample passes for unlisted objects
+scomx_filter_config_t scomx_filter_default_config(scom_object_type_t object_type, uint32_t object_id);
+void scomx_filter_init(scomx_filter_t *filter, const scomx_filter_config_t *config);
+// Returns non-zero when the sample is to be published, and then keeps it as the last value passed
+int scomx_filter_apply(scomx_filter_t *filter, float value, scom_error_t error, int64_t now_ms);
+
+// FUNCTIONS - FRAME CAPTURE
+//
+// Compact binary capture of the bytes exchanged with the gateways, for offline reproduction of
+// field problems and for decoding benchmarks on real traffic. A capture is a file header followed
+// by records of the raw bytes transferred in one read or write, with a monotonic timestamp, the
+// direction and the port.
+//
+// Recording only appends to the caller-provided buffer and never blocks: the caller writes the
+// buffer out when convenient, e.g. to a non-blocking file descriptor, and consumes what was
+// written. Records not fitting in the buffer are dropped and counted. Replaying parses the records
+// of a capture loaded in memory, so their data point into it. No I/O, not thread safe.
+//
+// Typical replay:
+//   long n, offset = scomx_capture_check_header(data, length);
+//   scomx_capture_record_t rec;
+//   while (offset > 0 && (n = scomx_capture_next(data + offset, length - offset, &rec)) > 0) {
+//       offset += n;
+//       ... push rec.data to the parser of rec.port and rec.direction ...
+//   }
+
+// Initializes the capture with the caller-provided buffer, holding the file header to write out first
+void scomx_capture_init(scomx_capture_t *capture, char *buffer, size_t size);
+// Appends a record; returns -1 when it was dropped for lack of space
+int scomx_capture_record(scomx_capture_t *capture, int64_t timestamp_us, uint8_t port, scomx_capture_direction_t direction, const char *data, size_t length);
+// Removes the first length bytes of the buffer once they were written out
+void scomx_capture_consume(scomx_capture_t *capture, size_t length);
+// Returns the size of the file header at the start of data, -1 when it isn't a capture of a known version
+long scomx_capture_check_header(const char *data, size_t length);
+// Parses the record at the start of data; returns its size, 0 when data ends before the record does
+// (a capture cut short), -1 when the record is invalid
+long scomx_capture_next(const char *data, size_t length, scomx_capture_record_t *record);
+
+// FUNCTIONS - HEX TEXT
+//
+// Conversion of frames to and from their textual form, e.g. AA3650001000..., as stored by field logs
+// and third-party tools. The best kernel for the CPU (AVX2, SSE2, NEON or portable C) is picked on
+// the first call, as for the checksums; the vector kernels convert 32 to 64 digits at a time.
+//
+// A hex log holds one frame per line, upper or lower case, optionally with blanks between the
+// digits; empty lines and lines starting with '#' are skipped. The log decoder walks a log loaded
+// (or mapped) in memory without copying it and decodes each frame as a request or a response, by
+// its service flags, then the value of responses by the metadata of their object. No I/O, not
+// thread safe, but independent decoders can work on different parts of a log in parallel.
+//
+// Typical loop:
+//   scomx_hexlog_init(&log, text, length, frame, sizeof(frame));
+//   while (scomx_hexlog_next(&log, &rec)) {
+//       ... rec.result, rec.value ...
+//   }
+
+// Decodes length hex digits into length / 2 bytes at dst; returns the number of bytes, -1 when
+// length is odd or a character isn't a hex digit (dst may then be partly written)
+long scomx_hex_decode(char *dst, const char *src, size_t length);
+// Encodes length bytes into 2 * length upper case hex digits at dst, without a terminating 0
+void scomx_hex_encode(char *dst, const char *src, size_t length);
+// Digit at a time reference implementations, only meant for verification and benchmarks
+long scomx_hex_decode_ref(char *dst, const char *src, size_t length);
+void scomx_hex_encode_ref(char *dst, const char *src, size_t length);
+// Returns the name of the kernel in use ("avx2", "sse2", "neon" or "scalar")
+const char *scomx_hex_kernel_name();
+
+// Initializes the decoder of the log in text, decoding frames into the caller-provided buffer
+void scomx_hexlog_init(scomx_hexlog_t *log, const char *text, size_t length, char *frame_buffer, size_t frame_buffer_size);
+// Decodes the next frame of the log; returns 0 at the end of the log. Frames failing to decode are
+// returned with the error in their result, lines which aren't hex digits are skipped and counted.
+int scomx_hexlog_next(scomx_hexlog_t *log, scomx_hexlog_record_t *record);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,147 @@
+#include "scomlib_extra.h"
+
+#include <string.h>
+
+// room for a few frames with the largest values
+#define RX_BUFFER_SIZE 256
+
+static scomx_enc_result_t encode_item(scomx_ctx_t *ctx, const scomx_read_item_t *item)
+{
+    return scomx_ctx_encode_read_property(ctx, item->dst_addr, item->object_type, item->object_id, item->property_id);
+}
+
+// a frame is the response to the request when it comes from the addressed device and, unless it
+// carries an error, describes the requested property
+static int matches_request(const scomx_dec_result_t *res, uint32_t dst_addr, uint16_t object_type, uint32_t object_id, uint16_t property_id)
+{
+    if (res->src_addr != dst_addr) {
+        return 0;
+    }
+    if (res->error != SCOM_ERROR_NO_ERROR) {
+        return 1;
+    }
+    return res->object_type == object_type && res->object_id == object_id && res->property_id == property_id;
+}
+
+static void set_result(scomx_read_item_t *item, const scomx_dec_result_t *res)
+{
+    item->result = *res;
+    item->result.data = item->value;
+
+    if (res->error != SCOM_ERROR_NO_ERROR) {
+        item->result.length = 0;
+    } else if (res->length > sizeof(item->value)) {
+        item->result.error = SCOM_ERROR_STACK_BUFFER_TOO_SMALL;
+        item->result.length = 0;
+    } else {
+        memcpy(item->value, res->data, res->length);
+    }
+}
+
+static void set_error(scomx_read_item_t *item, scom_error_t error)
+{
+    memset(&item->result, 0, sizeof(item->result));
+    item->result.error = error;
+    item->result.data = item->value;
+}
+
+scom_error_t scomx_receive_response(const scomx_transport_t *transport, scomx_parser_t *parser, uint32_t dst_addr, uint16_t object_type, uint32_t object_id,
+                                    uint16_t property_id, int64_t deadline_ms, scomx_dec_result_t *res)
+{
+    char chunk[64];
+
+    for (;;) {
+        long n = transport->read(transport->user, chunk, sizeof(chunk), deadline_ms);
+
+        if (n < 0) {
+            return SCOM_ERROR_STACK_PORT_READ_FAILED;
+        } else if (n == 0) {
+            return SCOM_ERROR_RESPONSE_TIMEOUT;
+        }
+
+        size_t offset = 0;
+        for (;;) {
+            scomx_parse_result_t parsed = scomx_parser_push(parser, chunk + offset, n - offset);
+            offset += parsed.consumed;
+
+            if (!parsed.frame_ready) {
+                break;
+            }
+            // anything else is a late response to an earlier, timed out request
+            if (matches_request(&parsed.result, dst_addr, object_type, object_id, property_id)) {
+                *res = parsed.result;
+                return SCOM_ERROR_NO_ERROR;
+            }
+        }
+    }
+}
+
+size_t scomx_read_many(const scomx_transport_t *transport, scomx_read_item_t *items, size_t count)
+{
+    // two request buffers, so that the next request is encoded while the previous one may still be in use by the transport
+    char txbuf[2][SCOMX_READ_REQUEST_SIZE];
+    scomx_ctx_t tx[2];
+    char rxbuf[RX_BUFFER_SIZE];
+    scomx_parser_t parser;
+    scom_error_t port_error = SCOM_ERROR_NO_ERROR;
+    size_t succeeded = 0;
+
+    if (count == 0) {
+        return 0;
+    }
+
+    scomx_ctx_init(&tx[0], txbuf[0], sizeof(txbuf[0]));
+    scomx_ctx_init(&tx[1], txbuf[1], sizeof(txbuf[1]));
+    scomx_parser_init(&parser, rxbuf, sizeof(rxbuf));
+
+    scomx_enc_result_t next = encode_item(&tx[0], &items[0]);
+
+    for (size_t i = 0; i < count; i++) {
+        scomx_read_item_t *item = &items[i];
+        scomx_enc_result_t req = next;
+
+        if (port_error != SCOM_ERROR_NO_ERROR) {
+            set_error(item, port_error);
+            continue;
+        }
+
+        int64_t deadline = transport->now_ms(transport->user) + transport->timeout_ms;
+        long written = req.error == SCOM_ERROR_NO_ERROR ? transport->write(transport->user, req.data, req.length, deadline) : 0;
+
+        // prepare the next request while this one is on the wire
+        if (i + 1 < count) {
+            next = encode_item(&tx[(i + 1) % 2], &items[i + 1]);
+        }
+
+        if (req.error != SCOM_ERROR_NO_ERROR) {
+            set_error(item, req.error);
+            continue;
+        } else if (written < 0) {
+            port_error = SCOM_ERROR_STACK_PORT_WRITE_FAILED;
+            set_error(item, port_error);
+            continue;
+        } else if ((size_t)written < req.length) {
+            set_error(item, SCOM_ERROR_RESPONSE_TIMEOUT);
+            continue;
+        }
+
+        scomx_parser_reset(&parser);
+
+        scomx_dec_result_t res;
+        scom_error_t error = scomx_receive_response(transport, &parser, item->dst_addr, item->object_type, item->object_id, item->property_id, deadline, &res);
+        if (error == SCOM_ERROR_STACK_PORT_READ_FAILED) {
+            port_error = error;
+        }
+        if (error != SCOM_ERROR_NO_ERROR) {
+            set_error(item, error);
+            continue;
+        }
+
+        set_result(item, &res);
+        if (item->result.error == SCOM_ERROR_NO_ERROR) {
+            succeeded++;
+        }
+    }
+
+    return succeeded;
+}
@@ -0,0 +1,204 @@
+#include "scomlib_extra.h"
+
+#include <string.h>
+
+// a pending read is normally completed (or timed out by the transport) well within this time
+#define DEFAULT_PENDING_TIMEOUT_MS 2000
+
+static size_t hash_key(uint32_t dst_addr, uint16_t object_type, uint32_t object_id, uint16_t property_id)
+{
+    uint32_t h = object_id * 0x9E3779B1u;
+
+    h ^= (dst_addr * 0x85EBCA6Bu) + ((uint32_t)object_type << 16) + property_id;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 13;
+
+    return h;
+}
+
+// finds the entry of the key with linear probing; creates it when create is set and the table isn't full
+static scomx_cache_entry_t *find_entry(scomx_cache_t *cache, uint32_t dst_addr, uint16_t object_type, uint32_t object_id, uint16_t property_id, int create)
+{
+    size_t mask = cache->capacity - 1;
+    size_t idx = hash_key(dst_addr, object_type, object_id, property_id) & mask;
+
+    for (size_t probe = 0; probe < cache->capacity; probe++, idx = (idx + 1) & mask) {
+        scomx_cache_entry_t *entry = &cache->entries[idx];
+
+        if (!entry->used) {
+            if (!create) {
+                return NULL;
+            }
+
+            memset(entry, 0, sizeof(*entry));
+            entry->used = 1;
+            entry->dst_addr = dst_addr;
+            entry->object_type = object_type;
+            entry->object_id = object_id;
+            entry->property_id = property_id;
+            entry->ttl_ms = cache->default_ttl_ms;
+            cache->count++;
+            return entry;
+        }
+
+        if (entry->object_id == object_id && entry->dst_addr == dst_addr && entry->object_type == object_type && entry->property_id == property_id) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+void scomx_cache_init(scomx_cache_t *cache, scomx_cache_entry_t *entries, size_t capacity, uint32_t default_ttl_ms)
+{
+    memset(cache, 0, sizeof(*cache));
+    memset(entries, 0, capacity * sizeof(*entries));
+
+    cache->entries = entries;
+    cache->capacity = capacity;
+    cache->default_ttl_ms = default_ttl_ms;
+    cache->pending_timeout_ms = DEFAULT_PENDING_TIMEOUT_MS;
+}
+
+scomx_cache_entry_t *scomx_cache_set_ttl(scomx_cache_t *cache, uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id,
+                                         uint32_t ttl_ms)
+{
+    scomx_cache_entry_t *entry = find_entry(cache, dst_addr, object_type, object_id, property_id, 1);
+
+    if (entry) {
+        entry->ttl_ms = ttl_ms;
+    }
+
+    return entry;
+}
+
+scomx_cache_lookup_t scomx_cache_lookup(scomx_cache_t *cache, uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id,
+                                        int64_t now_ms)
+{
+    scomx_cache_lookup_t res;
+
+    memset(&res, 0, sizeof(res));
+    res.entry = find_entry(cache, dst_addr, object_type, object_id, property_id, 1);
+
+    if (!res.entry) {
+        // not cached, every lookup goes to the wire
+        cache->overflows++;
+        cache->misses++;
+        res.status = SCOMX_CACHE_MISS;
+        return res;
+    }
+
+    scomx_cache_entry_t *entry = res.entry;
+
+    // a read whose result was never stored is considered lost and issued again
+    if (entry->state == SCOMX_CACHE_PENDING && (entry->pending_queued || now_ms - entry->pending_since_ms < cache->pending_timeout_ms)) {
+        cache->coalesced++;
+        res.status = SCOMX_CACHE_WAIT;
+        return res;
+    }
+
+    if (entry->state == SCOMX_CACHE_VALID && now_ms - entry->updated_ms < entry->ttl_ms) {
+        cache->hits++;
+        res.status = SCOMX_CACHE_HIT;
+        res.result = scomx_cache_result(entry);
+        return res;
+    }
+
+    cache->misses++;
+    entry->state = SCOMX_CACHE_PENDING;
+    entry->pending_since_ms = now_ms;
+    entry->pending_queued = 0;
+    res.status = SCOMX_CACHE_MISS;
+
+    return res;
+}
+
+void scomx_cache_queued(scomx_cache_t *cache, scomx_cache_entry_t *entry)
+{
+    (void)cache;
+
+    if (entry && entry->state == SCOMX_CACHE_PENDING) {
+        entry->pending_queued = 1;
+    }
+}
+
+void scomx_cache_sent(scomx_cache_t *cache, scomx_cache_entry_t *entry, int64_t now_ms)
+{
+    (void)cache;
+
+    if (entry && entry->state == SCOMX_CACHE_PENDING) {
+        entry->pending_since_ms = now_ms;
+        entry->pending_queued = 0;
+    }
+}
+
+void scomx_cache_store(scomx_cache_t *cache, scomx_cache_entry_t *entry, const scomx_dec_result_t *res, int64_t now_ms)
+{
+    (void)cache;
+
+    if (!entry) {
+        return;
+    }
+
+    if (res->error == SCOM_ERROR_NO_ERROR && res->length <= SCOMX_CACHE_VALUE_SIZE) {
+        memcpy(entry->value, res->data, res->length);
+        entry->length = res->length;
+        entry->src_addr = res->src_addr;
+        entry->service_id = res->service_id;
+        entry->updated_ms = now_ms;
+        entry->has_value = 1;
+    }
+
+    // after a failed read the previous, already expired, value is kept so that the next lookup reads again
+    entry->state = entry->has_value ? SCOMX_CACHE_VALID : SCOMX_CACHE_EMPTY;
+    entry->pending_queued = 0;
+}
+
+scomx_dec_result_t scomx_cache_result(scomx_cache_entry_t *entry)
+{
+    scomx_dec_result_t res;
+
+    memset(&res, 0, sizeof(res));
+    res.error = SCOM_ERROR_NO_ERROR;
+    res.src_addr = entry->src_addr;
+    res.service_id = entry->service_id;
+    res.object_type = entry->object_type;
+    res.object_id = entry->object_id;
+    res.property_id = entry->property_id;
+    res.data = entry->value;
+    res.length = entry->length;
+
+    return res;
+}
+
+// drops the value of an entry; a read in progress still stores its response
+static void invalidate_entry(scomx_cache_entry_t *entry)
+{
+    entry->has_value = 0;
+    if (entry->state == SCOMX_CACHE_VALID) {
+        entry->state = SCOMX_CACHE_EMPTY;
+    }
+}
+
+void scomx_cache_invalidate(scomx_cache_t *cache, uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id)
+{
+    scomx_cache_entry_t *entry = find_entry(cache, dst_addr, object_type, object_id, property_id, 0);
+
+    if (!entry) {
+        return;
+    }
+
+    invalidate_entry(entry);
+}
+
+void scomx_cache_invalidate_type(scomx_cache_t *cache, scom_object_type_t object_type)
+{
+    for (size_t i = 0; i < cache->capacity; i++) {
+        scomx_cache_entry_t *entry = &cache->entries[i];
+
+        if (entry->used && entry->object_type == object_type) {
+            invalidate_entry(entry);
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#include "scomlib_extra.h"
+
+#include <string.h>
+
+static void write_le64(char *p, int64_t value)
+{
+    scom_write_le32(p, (uint32_t)(uint64_t)value);
+    scom_write_le32(p + 4, (uint32_t)((uint64_t)value >> 32));
+}
+
+static int64_t read_le64(const char *p) { return (int64_t)((uint64_t)scom_read_le32(p) | (uint64_t)scom_read_le32(p + 4) << 32); }
+
+void scomx_capture_init(scomx_capture_t *capture, char *buffer, size_t size)
+{
+    memset(capture, 0, sizeof(*capture));
+    capture->buffer = buffer;
+    capture->size = size;
+
+    if (size >= SCOMX_CAPTURE_FILE_HEADER_SIZE) {
+        scom_write_le32(buffer, SCOMX_CAPTURE_MAGIC);
+        scom_write_le16(buffer + 4, SCOMX_CAPTURE_VERSION);
+        scom_write_le16(buffer + 6, SCOMX_CAPTURE_RECORD_HEADER_SIZE);
+        capture->length = SCOMX_CAPTURE_FILE_HEADER_SIZE;
+    }
+}
+
+int scomx_capture_record(scomx_capture_t *capture, int64_t timestamp_us, uint8_t port, scomx_capture_direction_t direction, const char *data, size_t length)
+{
+    if (length > 0xFFFF || capture->size - capture->length < SCOMX_CAPTURE_RECORD_HEADER_SIZE + length) {
+        capture->dropped++;
+        return -1;
+    }
+
+    char *p = capture->buffer + capture->length;
+    write_le64(p, timestamp_us);
+    scom_write_le16(p + 8, (uint16_t)length);
+    p[10] = (char)port;
+    p[11] = (char)direction;
+    memcpy(p + SCOMX_CAPTURE_RECORD_HEADER_SIZE, data, length);
+
+    capture->length += SCOMX_CAPTURE_RECORD_HEADER_SIZE + length;
+    capture->records++;
+
+    return 0;
+}
+
+void scomx_capture_consume(scomx_capture_t *capture, size_t length)
+{
+    if (length >= capture->length) {
+        capture->length = 0;
+        return;
+    }
+
+    // what is left is usually a short tail of a partial write
+    memmove(capture->buffer, capture->buffer + length, capture->length - length);
+    capture->length -= length;
+}
+
+long scomx_capture_check_header(const char *data, size_t length)
+{
+    if (length < SCOMX_CAPTURE_FILE_HEADER_SIZE || scom_read_le32(data) != SCOMX_CAPTURE_MAGIC || scom_read_le16(data + 4) != SCOMX_CAPTURE_VERSION ||
+        scom_read_le16(data + 6) != SCOMX_CAPTURE_RECORD_HEADER_SIZE) {
+        return -1;
+    }
+    return SCOMX_CAPTURE_FILE_HEADER_SIZE;
+}
+
+long scomx_capture_next(const char *data, size_t length, scomx_capture_record_t *record)
+{
+    if (length < SCOMX_CAPTURE_RECORD_HEADER_SIZE) {
+        return 0;
+    }
+
+    size_t data_length = scom_read_le16(data + 8);
+    uint8_t direction = (uint8_t)data[11];
+
+    if (direction > SCOMX_CAPTURE_RX) {
+        return -1;
+    }
+    if (length < SCOMX_CAPTURE_RECORD_HEADER_SIZE + data_length) {
+        return 0;
+    }
+
+    record->timestamp_us = read_le64(data);
+    record->port = (uint8_t)data[10];
+    record->direction = (scomx_capture_direction_t)direction;
+    record->data = data + SCOMX_CAPTURE_RECORD_HEADER_SIZE;
+    record->length = data_length;
+
+    return (long)(SCOMX_CAPTURE_RECORD_HEADER_SIZE + data_length);
+}
@@ -0,0 +1,306 @@
+#include "scomlib_extra.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SCOMX_CHECKSUM_AVX2
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SCOMX_CHECKSUM_NEON
+#endif
+
+// The kernels below compute the 8 bit Fletcher sums of RFC1146 a whole vector at a time, using the
+// block-wise formulation below: for a block of n bytes d[0..n-1]
+//   B += n * A + n * d[0] + (n - 1) * d[1] + ... + 1 * d[n - 1]
+//   A += d[0] + d[1] + ... + d[n - 1]
+// Over many blocks the n * A terms are accumulated as n times the running sum of previous blocks.
+// Both sums are only needed modulo 256, so 32 bit lanes may wrap around without any reduction.
+
+typedef uint16_t (*checksum_fn_t)(uint16_t checksum, char *dst, const char *src, size_t length);
+
+// portable scalar kernel, also used for the tails of the vector kernels
+static void sums_scalar(uint32_t *a, uint32_t *b, char *dst, const char *src, size_t length)
+{
+    const unsigned char *p = (const unsigned char *)src;
+    uint32_t A = *a, B = *b;
+
+    while (length >= 8) {
+        B += 8 * A + 8 * p[0] + 7 * p[1] + 6 * p[2] + 5 * p[3] + 4 * p[4] + 3 * p[5] + 2 * p[6] + p[7];
+        A += p[0] + p[1] + p[2] + p[3] + p[4] + p[5] + p[6] + p[7];
+        if (dst) {
+            memcpy(dst, p, 8);
+            dst += 8;
+        }
+        p += 8;
+        length -= 8;
+    }
+
+    while (length--) {
+        if (dst) {
+            *dst++ = (char)*p;
+        }
+        A += *p++;
+        B += A;
+    }
+
+    *a = A;
+    *b = B;
+}
+
+static uint16_t pack(uint32_t a, uint32_t b) { return (uint16_t)((b & 0xFF) << 8 | (a & 0xFF)); }
+
+static uint16_t checksum_scalar(uint16_t checksum, char *dst, const char *src, size_t length)
+{
+    uint32_t A = checksum & 0xFF, B = checksum >> 8;
+
+    sums_scalar(&A, &B, dst, src, length);
+
+    return pack(A, B);
+}
+
+// byte at a time, for frame headers and short properties where the block sums don't pay off; full
+// width sums, as 8 bit ones would stall on partial register writes
+static uint16_t checksum_short(uint16_t checksum, const char *src, size_t length)
+{
+    const unsigned char *p = (const unsigned char *)src;
+    uint32_t A = checksum & 0xFF, B = checksum >> 8;
+
+    while (length--) {
+        A += *p++;
+        B += A;
+    }
+
+    return pack(A, B);
+}
+
+// same with the copy in the loop, a call to memcpy costs as much as the checksum of a short frame
+static uint16_t copy_checksum_short(uint16_t checksum, char *dst, const char *src, size_t length)
+{
+    const unsigned char *p = (const unsigned char *)src;
+    uint32_t A = checksum & 0xFF, B = checksum >> 8;
+
+    while (length--) {
+        *dst++ = (char)*p;
+        A += *p++;
+        B += A;
+    }
+
+    return pack(A, B);
+}
+
+#if defined(__SSE2__)
+static uint32_t hsum_epi32(__m128i v)
+{
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (uint32_t)_mm_cvtsi128_si32(v);
+}
+
+static uint16_t checksum_sse2(uint16_t checksum, char *dst, const char *src, size_t length)
+{
+    uint32_t A = checksum & 0xFF, B = checksum >> 8;
+    size_t blocks = length / 16;
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i weights_lo = _mm_setr_epi16(16, 15, 14, 13, 12, 11, 10, 9);
+    const __m128i weights_hi = _mm_setr_epi16(8, 7, 6, 5, 4, 3, 2, 1);
+    __m128i sum = zero;      // sum of all bytes so far
+    __m128i prev_sums = zero; // sum over blocks of the bytes preceding each block
+    __m128i weighted = zero;  // sum over blocks of the in-block weighted bytes
+
+    for (size_t i = 0; i < blocks; i++) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 16));
+        if (dst) {
+            _mm_storeu_si128((__m128i *)(dst + i * 16), v);
+        }
+
+        prev_sums = _mm_add_epi32(prev_sums, sum);
+        sum = _mm_add_epi32(sum, _mm_sad_epu8(v, zero));
+        weighted = _mm_add_epi32(weighted, _mm_madd_epi16(_mm_unpacklo_epi8(v, zero), weights_lo));
+        weighted = _mm_add_epi32(weighted, _mm_madd_epi16(_mm_unpackhi_epi8(v, zero), weights_hi));
+    }
+
+    B += (uint32_t)(blocks * 16) * A + 16 * hsum_epi32(prev_sums) + hsum_epi32(weighted);
+    A += hsum_epi32(sum);
+
+    sums_scalar(&A, &B, dst ? dst + blocks * 16 : NULL, src + blocks * 16, length - blocks * 16);
+
+    return pack(A, B);
+}
+#endif
+
+#if defined(SCOMX_CHECKSUM_AVX2)
+__attribute__((target("avx2"))) static uint32_t hsum256_epi32(__m256i v)
+{
+    __m128i x = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2)));
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (uint32_t)_mm_cvtsi128_si32(x);
+}
+
+__attribute__((target("avx2"))) static uint16_t checksum_avx2(uint16_t checksum, char *dst, const char *src, size_t length)
+{
+    uint32_t A = checksum & 0xFF, B = checksum >> 8;
+    size_t blocks = length / 32;
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i weights = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+    __m256i sum = zero;
+    __m256i prev_sums = zero;
+    __m256i weighted = zero;
+
+    for (size_t i = 0; i < blocks; i++) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + i * 32));
+        if (dst) {
+            _mm256_storeu_si256((__m256i *)(dst + i * 32), v);
+        }
+
+        prev_sums = _mm256_add_epi32(prev_sums, sum);
+        sum = _mm256_add_epi32(sum, _mm256_sad_epu8(v, zero));
+        // pairs of byte * weight fit into int16 (255 * 63), then widened to 32 bits
+        weighted = _mm256_add_epi32(weighted, _mm256_madd_epi16(_mm256_maddubs_epi16(v, weights), ones));
+    }
+
+    B += (uint32_t)(blocks * 32) * A + 32 * hsum256_epi32(prev_sums) + hsum256_epi32(weighted);
+    A += hsum256_epi32(sum);
+
+    sums_scalar(&A, &B, dst ? dst + blocks * 32 : NULL, src + blocks * 32, length - blocks * 32);
+
+    return pack(A, B);
+}
+#endif
+
+#if defined(SCOMX_CHECKSUM_NEON)
+static uint16_t checksum_neon(uint16_t checksum, char *dst, const char *src, size_t length)
+{
+    uint32_t A = checksum & 0xFF, B = checksum >> 8;
+    size_t blocks = length / 16;
+
+    static const uint8_t k_weights[16] = {16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+    const uint8x8_t weights_lo = vld1_u8(k_weights);
+    const uint8x8_t weights_hi = vld1_u8(k_weights + 8);
+    uint32x4_t sum = vdupq_n_u32(0);
+    uint32x4_t prev_sums = vdupq_n_u32(0);
+    uint32x4_t weighted = vdupq_n_u32(0);
+
+    for (size_t i = 0; i < blocks; i++) {
+        uint8x16_t v = vld1q_u8((const uint8_t *)(src + i * 16));
+        if (dst) {
+            vst1q_u8((uint8_t *)(dst + i * 16), v);
+        }
+
+        prev_sums = vaddq_u32(prev_sums, sum);
+        sum = vpadalq_u16(sum, vpaddlq_u8(v));
+        uint16x8_t w = vmull_u8(vget_low_u8(v), weights_lo);
+        w = vmlal_u8(w, vget_high_u8(v), weights_hi);
+        weighted = vpadalq_u16(weighted, w);
+    }
+
+    B += (uint32_t)(blocks * 16) * A + 16 * (uint32_t)vaddvq_u32(prev_sums) + (uint32_t)vaddvq_u32(weighted);
+    A += (uint32_t)vaddvq_u32(sum);
+
+    sums_scalar(&A, &B, dst ? dst + blocks * 16 : NULL, src + blocks * 16, length - blocks * 16);
+
+    return pack(A, B);
+}
+#endif
+
+// picks the best kernel supported by the CPU on the first call
+static checksum_fn_t select_kernel()
+{
+#if defined(SCOMX_CHECKSUM_AVX2)
+    if (__builtin_cpu_supports("avx2")) {
+        return checksum_avx2;
+    }
+#endif
+#if defined(__SSE2__)
+    return checksum_sse2;
+#endif
+#if defined(SCOMX_CHECKSUM_NEON)
+    return checksum_neon;
+#endif
+    return checksum_scalar;
+}
+
+static checksum_fn_t g_kernel;
+
+static checksum_fn_t kernel()
+{
+    // threads decoding at once may both select the kernel, atomically storing the same pointer
+    checksum_fn_t k = __atomic_load_n(&g_kernel, __ATOMIC_ACQUIRE);
+
+    if (!k) {
+        k = select_kernel();
+        __atomic_store_n(&g_kernel, k, __ATOMIC_RELEASE);
+    }
+    return k;
+}
+
+// headers and short property frames are not worth the vector setup and the indirect call
+#define SHORT_LENGTH 32
+
+static uint16_t run_kernel(uint16_t checksum, char *dst, const char *src, size_t length)
+{
+    if (length < SHORT_LENGTH) {
+        return copy_checksum_short(checksum, dst, src, length);
+    }
+    return kernel()(checksum, dst, src, length);
+}
+
+uint16_t scomx_checksum_ref(const char *data, size_t length)
+{
+    uint8_t A = 0xFF, B = 0;
+
+    while (length--) {
+        A = (A + *data++) & 0xFF;
+        B = (B + A) & 0xFF;
+    }
+
+    return (B & 0xFF) << 8 | (A & 0xFF);
+}
+
+uint16_t scomx_checksum_update(uint16_t checksum, const char *data, size_t length)
+{
+    // kept apart from the copying variants, so that short frames don't pay for saving registers
+    if (length < SHORT_LENGTH) {
+        return checksum_short(checksum, data, length);
+    }
+    return kernel()(checksum, NULL, data, length);
+}
+
+uint16_t scomx_checksum(const char *data, size_t length) { return scomx_checksum_update(SCOMX_CHECKSUM_INIT, data, length); }
+
+uint16_t scomx_copy_checksum(char *dst, const char *src, size_t length) { return run_kernel(SCOMX_CHECKSUM_INIT, dst, src, length); }
+
+uint16_t scomx_copy_checksum_update(uint16_t checksum, char *dst, const char *src, size_t length) { return run_kernel(checksum, dst, src, length); }
+
+const char *scomx_checksum_kernel_name()
+{
+    checksum_fn_t k = kernel();
+
+#if defined(SCOMX_CHECKSUM_AVX2)
+    if (k == checksum_avx2) {
+        return "avx2";
+    }
+#endif
+#if defined(__SSE2__)
+    if (k == checksum_sse2) {
+        return "sse2";
+    }
+#endif
+#if defined(SCOMX_CHECKSUM_NEON)
+    if (k == checksum_neon) {
+        return "neon";
+    }
+#endif
+    (void)k;
+    return "scalar";
+}
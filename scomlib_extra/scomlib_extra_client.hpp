@@ -0,0 +1,214 @@
+#ifndef SCOM_EXTRA_CLIENT_HPP
+#define SCOM_EXTRA_CLIENT_HPP
+
+// Typed reads over a transport (C++17, header only).
+//
+// The object, property and format of a read are template parameters, so the request is encoded from
+// a compile-time frame and the value decoded without any lookup; the C++ type of the value follows
+// the format listed in scomlib_extra_objects.def:
+//
+//   scomx::client<> xtender(transport, SCOMX_DEST_XTM(0));
+//
+//   auto voltage = xtender.read<SCOMX_INFO_XTENDER_BATT_VOLTAGE>(); // scomx::result<float>
+//   if (voltage) {
+//       printf("%.2f %s\n", voltage.value, scomx::object<SCOMX_INFO_XTENDER_BATT_VOLTAGE>::unit);
+//   }
+//   auto charger = xtender.read<SCOMX_PARAM_XTENDER_BAT_CHARGER_ALLOWED>(); // scomx::result<bool>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "scomlib_extra.h"
+#include "scomlib_extra_frames.hpp"
+
+namespace scomx {
+
+// value or error of a read, as scomx_dec_result_t does for the C functions
+template <typename T> struct result {
+    scom_error_t error;
+    T value;
+
+    explicit operator bool() const { return error == SCOM_ERROR_NO_ERROR; }
+};
+
+// C++ type of the values of a format
+template <scom_format_t Format> struct format_traits;
+template <> struct format_traits<SCOM_FORMAT_FLOAT> {
+    using type = float;
+};
+template <> struct format_traits<SCOM_FORMAT_INT32> {
+    using type = int32_t;
+};
+template <> struct format_traits<SCOM_FORMAT_ENUM> {
+    using type = uint16_t;
+};
+template <> struct format_traits<SCOM_FORMAT_BOOL> {
+    using type = bool;
+};
+
+namespace detail {
+
+// offsets patched into a request frame encoded for another destination
+constexpr std::size_t dst_addr_offset = 6;
+constexpr std::size_t header_checksum_offset = SCOM_FRAME_HEADER_SIZE - 2;
+
+// metadata of objects listed in scomlib_extra_objects.def; the others are read as float
+template <auto Object> struct object_def {
+    static constexpr scom_format_t format = SCOM_FORMAT_FLOAT;
+    static constexpr const char *unit = "";
+    static constexpr float scale = 1;
+};
+
+#define SCOMX_OBJECT(block, id, format_, unit_, scale_, labels)                                                                                                \
+    template <> struct object_def<id> {                                                                                                                        \
+        static constexpr scom_format_t format = SCOM_FORMAT_##format_;                                                                                         \
+        static constexpr const char *unit = unit_;                                                                                                             \
+        static constexpr float scale = scale_;                                                                                                                 \
+    };
+#include "scomlib_extra_objects.def"
+#undef SCOMX_OBJECT
+
+} // namespace detail
+
+// A readable property with everything but the destination known at compile time
+template <uint16_t ObjectType, uint32_t ObjectId, uint16_t PropertyId, scom_format_t Format> struct property {
+    using value_type = typename format_traits<Format>::type;
+
+    static constexpr uint16_t object_type = ObjectType;
+    static constexpr uint32_t object_id = ObjectId;
+    static constexpr uint16_t property_id = PropertyId;
+    static constexpr scom_format_t format = Format;
+
+    // request to device 0, only the destination and header checksum differ for other devices
+    static constexpr request_frame request = read_request_frame(0, ObjectType, ObjectId, PropertyId);
+
+    // Encodes the read request for the device
+    static request_frame encode(uint32_t dst_addr)
+    {
+        request_frame frame = request;
+
+        detail::write_le32(frame.data + detail::dst_addr_offset, dst_addr);
+        detail::write_le16(frame.data + detail::header_checksum_offset, detail::checksum(frame.data + 1, SCOM_FRAME_HEADER_SIZE - 1 - 2));
+
+        return frame;
+    }
+
+    // Decodes the value of a response to the request
+    static result<value_type> decode(const scomx_dec_result_t &res)
+    {
+        if (res.error != SCOM_ERROR_NO_ERROR) {
+            return {res.error, value_type()};
+        }
+        if constexpr (Format == SCOM_FORMAT_FLOAT) {
+            if (res.length >= 4) {
+                return {SCOM_ERROR_NO_ERROR, scom_read_le_float(res.data)};
+            }
+        } else if constexpr (Format == SCOM_FORMAT_INT32) {
+            if (res.length >= 4) {
+                return {SCOM_ERROR_NO_ERROR, static_cast<int32_t>(scom_read_le32(res.data))};
+            }
+        } else if constexpr (Format == SCOM_FORMAT_ENUM) {
+            if (res.length >= 2) {
+                return {SCOM_ERROR_NO_ERROR, scom_read_le16(res.data)};
+            }
+        } else if constexpr (Format == SCOM_FORMAT_BOOL) {
+            if (res.length >= 1) {
+                return {SCOM_ERROR_NO_ERROR, res.data[0] != 0};
+            }
+        }
+        return {SCOM_ERROR_INVALID_DATA_LENGTH, value_type()};
+    }
+};
+
+namespace detail {
+
+template <auto Object> constexpr bool is_parameter = std::is_same_v<decltype(Object), scomx_parameter_object_t>;
+
+template <auto Object>
+using value_property = property<is_parameter<Object> ? SCOM_PARAMETER_OBJECT_TYPE : SCOM_USER_INFO_OBJECT_TYPE, static_cast<uint32_t>(Object),
+                                is_parameter<Object> ? SCOMX_PROP_PARAMETER_VALUE_QSP : SCOMX_PROP_USER_INFO_VALUE, object_def<Object>::format>;
+
+} // namespace detail
+
+// The value property of a user info (scomx_user_info_object_t) or parameter (scomx_parameter_object_t)
+// object, decoded into the unit of its metadata
+template <auto Object> struct object : detail::value_property<Object> {
+    static_assert(std::is_same_v<decltype(Object), scomx_user_info_object_t> || detail::is_parameter<Object>,
+                  "Object must be a scomx_user_info_object_t or scomx_parameter_object_t");
+
+    using base = detail::value_property<Object>;
+    using value_type = typename base::value_type;
+
+    static constexpr const char *unit = detail::object_def<Object>::unit;
+    static constexpr float scale = detail::object_def<Object>::scale;
+
+    static_assert(scale == 1 || std::is_same_v<value_type, float>, "only float values are scaled");
+
+    static result<value_type> decode(const scomx_dec_result_t &res)
+    {
+        result<value_type> r = base::decode(res);
+        if constexpr (scale != 1) {
+            r.value *= scale;
+        }
+        return r;
+    }
+};
+
+// Reads properties from a device over a transport. The client owns the buffer the responses are
+// parsed in, so it can't be copied; use one client per port and thread.
+template <std::size_t BufferSize = 256> class client {
+public:
+    client(const scomx_transport_t &transport, uint32_t dst_addr) : transport_(transport), dst_addr_(dst_addr)
+    {
+        scomx_parser_init(&parser_, buffer_, sizeof(buffer_));
+    }
+
+    client(const client &) = delete;
+    client &operator=(const client &) = delete;
+
+    uint32_t dst_addr() const { return dst_addr_; }
+
+    // Reads the value of a user info or parameter object, e.g. read<SCOMX_INFO_XTENDER_BATT_VOLTAGE>()
+    template <auto Object> result<typename object<Object>::value_type> read() { return read_as<object<Object>>(dst_addr_); }
+    template <auto Object> result<typename object<Object>::value_type> read(uint32_t dst_addr) { return read_as<object<Object>>(dst_addr); }
+
+    // Reads any property, e.g. read_as<property<SCOM_PARAMETER_OBJECT_TYPE, 1107, SCOMX_PROP_PARAMETER_MAX_QSP, SCOM_FORMAT_FLOAT>>()
+    template <typename Property> result<typename Property::value_type> read_as() { return read_as<Property>(dst_addr_); }
+
+    template <typename Property> result<typename Property::value_type> read_as(uint32_t dst_addr)
+    {
+        using value_type = typename Property::value_type;
+
+        request_frame frame = Property::encode(dst_addr);
+        int64_t deadline = transport_.now_ms(transport_.user) + transport_.timeout_ms;
+
+        scomx_parser_reset(&parser_);
+
+        long written = transport_.write(transport_.user, frame.data, frame.size(), deadline);
+        if (written < 0) {
+            return {SCOM_ERROR_STACK_PORT_WRITE_FAILED, value_type()};
+        } else if (static_cast<std::size_t>(written) < frame.size()) {
+            return {SCOM_ERROR_RESPONSE_TIMEOUT, value_type()};
+        }
+
+        scomx_dec_result_t res;
+        scom_error_t error =
+            scomx_receive_response(&transport_, &parser_, dst_addr, Property::object_type, Property::object_id, Property::property_id, deadline, &res);
+        if (error != SCOM_ERROR_NO_ERROR) {
+            return {error, value_type()};
+        }
+
+        return Property::decode(res);
+    }
+
+private:
+    scomx_transport_t transport_;
+    uint32_t dst_addr_;
+    scomx_parser_t parser_;
+    char buffer_[BufferSize];
+};
+
+} // namespace scomx
+
+#endif
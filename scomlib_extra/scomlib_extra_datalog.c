@@ -0,0 +1,183 @@
+#include "scomlib_extra.h"
+
+#include <string.h>
+
+// offset of the block in front of its data in SD_READ_NEXT and SD_READ_AGAIN responses
+#define BLOCK_OFFSET_SIZE 4
+
+#define DEFAULT_RETRIES 5
+
+typedef struct {
+    uint32_t *file_ids;
+    size_t max_files;
+    size_t count;
+
+    // bytes of an id split between two blocks
+    char partial[4];
+    size_t partial_length;
+} file_list_t;
+
+// sends a request on the datalog transfer object and waits for its response
+static scom_error_t request(scomx_datalog_t *dl, uint32_t file_id, uint16_t property_id, scomx_dec_result_t *res)
+{
+    const scomx_transport_t *transport = dl->transport;
+    int64_t deadline = transport->now_ms(transport->user) + transport->timeout_ms;
+
+    scomx_encode_read_request_frame(dl->request, dl->dst_addr, SCOM_DATALOG_TRANSFER_OBJECT_TYPE, file_id, property_id);
+    scomx_parser_reset(&dl->parser);
+
+    long written = transport->write(transport->user, dl->request, sizeof(dl->request), deadline);
+    if (written < 0) {
+        return SCOM_ERROR_STACK_PORT_WRITE_FAILED;
+    } else if ((size_t)written < sizeof(dl->request)) {
+        return SCOM_ERROR_RESPONSE_TIMEOUT;
+    }
+
+    scom_error_t error =
+        scomx_receive_response(transport, &dl->parser, dl->dst_addr, SCOM_DATALOG_TRANSFER_OBJECT_TYPE, file_id, property_id, deadline, res);
+
+    return error != SCOM_ERROR_NO_ERROR ? error : res->error;
+}
+
+static scom_error_t start_transfer(scomx_datalog_t *dl, uint32_t file_id)
+{
+    scomx_dec_result_t res;
+    scom_error_t error;
+    unsigned attempts = 0;
+
+    while (scomx_retry_is_retryable(error = request(dl, file_id, SCOMX_PROP_DATALOG_SD_START, &res)) && attempts++ < dl->retries) {
+    }
+
+    if (error == SCOM_ERROR_NO_ERROR) {
+        dl->file_size = res.length >= 4 ? scom_read_le32(res.data) : 0;
+    }
+
+    return error;
+}
+
+static void abort_transfer(scomx_datalog_t *dl, uint32_t file_id)
+{
+    scomx_dec_result_t res;
+
+    // best effort, the device ends the transfer on its own when the next one starts
+    request(dl, file_id, SCOMX_PROP_DATALOG_SD_ABORT, &res);
+}
+
+static int list_sink(void *user, const char *data, size_t length)
+{
+    file_list_t *list = (file_list_t *)user;
+
+    while (length > 0) {
+        size_t n = sizeof(list->partial) - list->partial_length;
+        if (n > length) {
+            n = length;
+        }
+
+        memcpy(list->partial + list->partial_length, data, n);
+        list->partial_length += n;
+        data += n;
+        length -= n;
+
+        if (list->partial_length == sizeof(list->partial)) {
+            if (list->count < list->max_files) {
+                list->file_ids[list->count++] = scom_read_le32(list->partial);
+            }
+            list->partial_length = 0;
+        }
+    }
+
+    return 0;
+}
+
+void scomx_datalog_init(scomx_datalog_t *dl, const scomx_transport_t *transport, uint32_t dst_addr, char *buffer, size_t buffer_size)
+{
+    memset(dl, 0, sizeof(*dl));
+
+    dl->transport = transport;
+    dl->dst_addr = dst_addr;
+    dl->retries = DEFAULT_RETRIES;
+    scomx_parser_init(&dl->parser, buffer, buffer_size);
+}
+
+scom_error_t scomx_datalog_list(scomx_datalog_t *dl, uint32_t *file_ids, size_t max_files, size_t *count)
+{
+    file_list_t list;
+
+    memset(&list, 0, sizeof(list));
+    list.file_ids = file_ids;
+    list.max_files = max_files;
+
+    scom_error_t error = scomx_datalog_fetch(dl, SCOMX_DATALOG_FILE_LIST_ID, 0, list_sink, &list);
+
+    *count = list.count;
+    return error;
+}
+
+scom_error_t scomx_datalog_fetch(scomx_datalog_t *dl, uint32_t file_id, uint32_t skip, scomx_datalog_sink_t sink, void *user)
+{
+    scomx_dec_result_t res;
+    uint32_t expected = 0;
+    uint16_t property_id = SCOMX_PROP_DATALOG_SD_READ_NEXT;
+    unsigned attempts = 0;
+
+    dl->sink_refused = 0;
+
+    scom_error_t error = start_transfer(dl, file_id);
+    if (error != SCOM_ERROR_NO_ERROR) {
+        return error;
+    }
+
+    for (;;) {
+        error = request(dl, file_id, property_id, &res);
+
+        if (scomx_retry_is_retryable(error) || (error == SCOM_ERROR_NO_ERROR && res.length >= BLOCK_OFFSET_SIZE && scom_read_le32(res.data) != expected)) {
+            if (attempts++ >= dl->retries) {
+                break;
+            }
+
+            // a lost response is sent again; when the device repeated the previous block instead, it
+            // never received the acknowledgement and is asked for the next one
+            property_id = scomx_retry_is_retryable(error) ? SCOMX_PROP_DATALOG_SD_READ_AGAIN : SCOMX_PROP_DATALOG_SD_READ_NEXT;
+            dl->blocks_repeated++;
+            continue;
+        }
+
+        if (error != SCOM_ERROR_NO_ERROR) {
+            break;
+        }
+        if (res.length < BLOCK_OFFSET_SIZE) {
+            error = SCOM_ERROR_INVALID_FRAME;
+            break;
+        }
+
+        const char *data = res.data + BLOCK_OFFSET_SIZE;
+        size_t length = res.length - BLOCK_OFFSET_SIZE;
+
+        attempts = 0;
+        property_id = SCOMX_PROP_DATALOG_SD_READ_NEXT;
+
+        if (length == 0) {
+            return SCOM_ERROR_NO_ERROR;
+        }
+
+        dl->bytes_received += length;
+        dl->blocks_received++;
+
+        // bytes stored by an earlier, interrupted download are skipped
+        if (expected + length > skip) {
+            size_t stored = expected < skip ? skip - expected : 0;
+
+            if (sink(user, data + stored, length - stored) != 0) {
+                dl->sink_refused = 1;
+                error = SCOM_ERROR_STACK_BUFFER_TOO_SMALL;
+                break;
+            }
+        }
+
+        expected += length;
+    }
+
+    abort_transfer(dl, file_id);
+
+    return error;
+}
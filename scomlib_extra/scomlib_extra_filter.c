@@ -0,0 +1,78 @@
+#include "scomlib_extra.h"
+
+#include <math.h>
+#include <string.h>
+
+#define DEFAULT_REL_DEADBAND 0.01f
+#define DEFAULT_HEARTBEAT_MS 60000
+
+scomx_filter_config_t scomx_filter_default_config(scom_object_type_t object_type, uint32_t object_id)
+{
+    const scomx_object_meta_t *meta = scomx_object_meta(object_type, object_id);
+    scomx_filter_config_t config;
+
+    memset(&config, 0, sizeof(config));
+    config.heartbeat_ms = DEFAULT_HEARTBEAT_MS;
+
+    if (!meta) {
+        config.mode = SCOMX_FILTER_EVERY;
+    } else if (meta->format == SCOM_FORMAT_FLOAT) {
+        config.mode = SCOMX_FILTER_DEADBAND;
+        config.rel_deadband = DEFAULT_REL_DEADBAND;
+    } else {
+        config.mode = SCOMX_FILTER_CHANGE;
+    }
+
+    return config;
+}
+
+void scomx_filter_init(scomx_filter_t *filter, const scomx_filter_config_t *config)
+{
+    memset(filter, 0, sizeof(*filter));
+    filter->config = *config;
+}
+
+// returns non-zero when the value is news compared with the last value passed
+static int value_changed(const scomx_filter_t *filter, float value)
+{
+    const scomx_filter_config_t *config = &filter->config;
+    float last = filter->value;
+
+    // NaN differs from everything, including itself
+    if (isnan(value) || isnan(last)) {
+        return isnan(value) != isnan(last);
+    }
+
+    switch (config->mode) {
+    case SCOMX_FILTER_DEADBAND: {
+        float threshold = config->rel_deadband * fabsf(last);
+        if (config->abs_deadband > threshold) {
+            threshold = config->abs_deadband;
+        }
+        return fabsf(value - last) > threshold;
+    }
+    case SCOMX_FILTER_CHANGE:
+        return value != last;
+    default:
+        return 1;
+    }
+}
+
+int scomx_filter_apply(scomx_filter_t *filter, float value, scom_error_t error, int64_t now_ms)
+{
+    int pass = filter->passed == 0 || error != filter->error ||
+               (filter->config.heartbeat_ms && now_ms - filter->passed_ms >= filter->config.heartbeat_ms) ||
+               (error == SCOM_ERROR_NO_ERROR && value_changed(filter, value));
+
+    if (!pass) {
+        filter->suppressed++;
+        return 0;
+    }
+
+    filter->value = value;
+    filter->error = error;
+    filter->passed_ms = now_ms;
+    filter->passed++;
+
+    return 1;
+}
@@ -0,0 +1,62 @@
+#include "scomlib_extra.h"
+
+#include <string.h>
+
+uint8_t scomx_frame_flags_byte(scom_frame_flags_t flags)
+{
+    // the fields are signed one bit fields, so a set flag reads as -1
+    return (uint8_t)((flags.is_message_pending ? SCOMX_FLAG_MESSAGE_PENDING : 0) | (flags.was_rcc_reseted ? SCOMX_FLAG_RCC_RESET : 0) |
+                     (flags.is_sd_card_present ? SCOMX_FLAG_SD_CARD_PRESENT : 0) | (flags.is_sd_card_full ? SCOMX_FLAG_SD_CARD_FULL : 0) |
+                     (flags.is_new_datalogger_file_present ? SCOMX_FLAG_NEW_DATALOG_FILE : 0));
+}
+
+scom_frame_flags_t scomx_frame_flags_from_byte(uint8_t byte)
+{
+    scom_frame_flags_t flags;
+
+    memset(&flags, 0, sizeof(flags));
+    flags.is_message_pending = (byte & SCOMX_FLAG_MESSAGE_PENDING) != 0;
+    flags.was_rcc_reseted = (byte & SCOMX_FLAG_RCC_RESET) != 0;
+    flags.is_sd_card_present = (byte & SCOMX_FLAG_SD_CARD_PRESENT) != 0;
+    flags.is_sd_card_full = (byte & SCOMX_FLAG_SD_CARD_FULL) != 0;
+    flags.is_new_datalogger_file_present = (byte & SCOMX_FLAG_NEW_DATALOG_FILE) != 0;
+
+    return flags;
+}
+
+void scomx_flags_watch_init(scomx_flags_watch_t *watch, uint8_t mask, scomx_flags_callback_t callback, void *user)
+{
+    memset(watch, 0, sizeof(*watch));
+
+    watch->mask = mask;
+    watch->callback = callback;
+    watch->user = user;
+}
+
+uint8_t scomx_flags_watch_update(scomx_flags_watch_t *watch, const scomx_dec_result_t *res)
+{
+    if (!res->has_frame_flags) {
+        return 0;
+    }
+
+    uint8_t flags = scomx_frame_flags_byte(res->frame_flags);
+    uint8_t changed = (uint8_t)((flags ^ watch->flags) & watch->mask);
+
+    watch->flags = flags;
+    watch->frames++;
+
+    if (!changed) {
+        return 0;
+    }
+
+    uint8_t raised = changed & flags;
+
+    watch->changes++;
+    if (watch->callback) {
+        watch->callback(watch->user, raised, changed & ~flags, flags);
+    }
+
+    return raised;
+}
+
+void scomx_flags_watch_rearm(scomx_flags_watch_t *watch, uint8_t flags) { watch->flags &= (uint8_t)~flags; }
@@ -0,0 +1,89 @@
+#ifndef SCOM_EXTRA_FRAMES_HPP
+#define SCOM_EXTRA_FRAMES_HPP
+
+// Compile-time encoding of read property requests (C++14).
+//
+// Produces the same bytes as scomx_encode_read_request_frame, so fixed requests can live in
+// read-only memory and be sent without any encoding at run time:
+//
+//   static constexpr auto k_power = scomx::read_user_info_frame(SCOMX_DEST_XTM(0), SCOMX_INFO_XTENDER_OUT_AC_POWER);
+//   write(fd, k_power.data, k_power.size());
+
+#include <cstddef>
+#include <cstdint>
+
+#include "scomlib_extra.h"
+
+namespace scomx {
+
+struct request_frame {
+    char data[SCOMX_READ_REQUEST_SIZE];
+
+    static constexpr std::size_t size() { return SCOMX_READ_REQUEST_SIZE; }
+};
+
+namespace detail {
+
+constexpr void write_le16(char *p, uint16_t v)
+{
+    p[0] = static_cast<char>(v & 0xFF);
+    p[1] = static_cast<char>(v >> 8);
+}
+
+constexpr void write_le32(char *p, uint32_t v)
+{
+    write_le16(p, static_cast<uint16_t>(v & 0xFFFF));
+    write_le16(p + 2, static_cast<uint16_t>(v >> 16));
+}
+
+// same as scom_calc_checksum
+constexpr uint16_t checksum(const char *data, std::size_t length)
+{
+    uint8_t a = 0xFF, b = 0;
+    for (std::size_t i = 0; i < length; i++) {
+        a = static_cast<uint8_t>(a + static_cast<uint8_t>(data[i]));
+        b = static_cast<uint8_t>(b + a);
+    }
+    return static_cast<uint16_t>(a | (b << 8));
+}
+
+} // namespace detail
+
+// Encodes a read property request for the property
+constexpr request_frame read_request_frame(uint32_t dst_addr, uint16_t object_type, uint32_t object_id, uint16_t property_id)
+{
+    request_frame f{};
+    char *p = f.data;
+
+    p[0] = static_cast<char>(SCOMX_START_BYTE);
+    p[1] = 0; // frame flags of a request
+    detail::write_le32(p + 2, 1); // our address
+    detail::write_le32(p + 6, dst_addr);
+    detail::write_le16(p + 10, 2 + 8);
+    detail::write_le16(p + 12, detail::checksum(p + 1, SCOM_FRAME_HEADER_SIZE - 1 - 2));
+
+    p[SCOM_FRAME_HEADER_SIZE] = 0; // service flags of a request
+    p[SCOM_FRAME_HEADER_SIZE + 1] = SCOM_READ_PROPERTY_SERVICE;
+    detail::write_le16(p + SCOM_FRAME_HEADER_SIZE + 2, object_type);
+    detail::write_le32(p + SCOM_FRAME_HEADER_SIZE + 4, object_id);
+    detail::write_le16(p + SCOM_FRAME_HEADER_SIZE + 8, property_id);
+    detail::write_le16(p + SCOM_FRAME_HEADER_SIZE + 10, detail::checksum(p + SCOM_FRAME_HEADER_SIZE, 2 + 8));
+
+    return f;
+}
+
+// Encodes a request to read "value" property of an "user info-type" (0x1) object
+constexpr request_frame read_user_info_frame(uint32_t dst_addr, uint32_t object_id)
+{
+    return read_request_frame(dst_addr, SCOM_USER_INFO_OBJECT_TYPE, object_id, SCOMX_PROP_USER_INFO_VALUE);
+}
+
+// Encodes a request to read "value_qsp" property of a "parameter-type" (0x2) object
+constexpr request_frame read_parameter_frame(uint32_t dst_addr, uint32_t object_id)
+{
+    return read_request_frame(dst_addr, SCOM_PARAMETER_OBJECT_TYPE, object_id, SCOMX_PROP_PARAMETER_VALUE_QSP);
+}
+
+} // namespace scomx
+
+#endif
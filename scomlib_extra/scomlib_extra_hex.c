@@ -0,0 +1,386 @@
+#include "scomlib_extra.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// the AVX2 kernel leaves the tail to the SSE2 one
+#if defined(__GNUC__) && defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SCOMX_HEX_AVX2
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SCOMX_HEX_NEON
+#endif
+
+// The vector kernels turn every character into its digit value with two range checks, '0'-'9' and
+// 'a'-'f' after folding the case, and fail the whole input when a character passes neither. Pairs of
+// values are then combined into bytes, the first digit of a pair being the high nibble.
+
+typedef long (*hex_decode_fn_t)(char *dst, const char *src, size_t length);
+typedef void (*hex_encode_fn_t)(char *dst, const char *src, size_t length);
+
+typedef struct {
+    const char *name;
+    hex_decode_fn_t decode;
+    hex_encode_fn_t encode;
+} hex_kernel_t;
+
+static const char k_digits[] = "0123456789ABCDEF";
+
+// the value of a hex digit, -1 for other characters
+static int digit_value(unsigned char c)
+{
+    if ((unsigned)(c - '0') < 10) {
+        return c - '0';
+    }
+    c |= 0x20;
+    if ((unsigned)(c - 'a') < 6) {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+// portable scalar kernels, also used for the tails of the vector kernels; length is even
+static long decode_scalar(char *dst, const char *src, size_t length)
+{
+    for (size_t i = 0; i < length; i += 2) {
+        int hi = digit_value((unsigned char)src[i]);
+        int lo = digit_value((unsigned char)src[i + 1]);
+
+        if (hi < 0 || lo < 0) {
+            return -1;
+        }
+        dst[i / 2] = (char)(hi << 4 | lo);
+    }
+    return (long)(length / 2);
+}
+
+static void encode_scalar(char *dst, const char *src, size_t length)
+{
+    for (size_t i = 0; i < length; i++) {
+        unsigned char b = (unsigned char)src[i];
+
+        dst[2 * i] = k_digits[b >> 4];
+        dst[2 * i + 1] = k_digits[b & 0x0F];
+    }
+}
+
+#if defined(__SSE2__)
+// digit values of 16 characters; returns 0 when one of them isn't a hex digit
+static int values_sse2(__m128i c, __m128i *values)
+{
+    __m128i digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    __m128i letter = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    __m128i is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+
+    *values = _mm_or_si128(_mm_and_si128(is_digit, digit), _mm_and_si128(is_letter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+
+    return _mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) == 0xFFFF;
+}
+
+// combines the pairs of values into bytes in the low half of each 16 bit lane
+static __m128i pairs_sse2(__m128i values)
+{
+    __m128i hi = _mm_slli_epi16(_mm_and_si128(values, _mm_set1_epi16(0x00FF)), 4);
+    return _mm_or_si128(hi, _mm_srli_epi16(values, 8));
+}
+
+static long decode_sse2(char *dst, const char *src, size_t length)
+{
+    size_t blocks = length / 32;
+
+    for (size_t i = 0; i < blocks; i++) {
+        __m128i a, b;
+
+        if (!values_sse2(_mm_loadu_si128((const __m128i *)(src + i * 32)), &a) || !values_sse2(_mm_loadu_si128((const __m128i *)(src + i * 32 + 16)), &b)) {
+            return -1;
+        }
+        _mm_storeu_si128((__m128i *)(dst + i * 16), _mm_packus_epi16(pairs_sse2(a), pairs_sse2(b)));
+    }
+
+    if (decode_scalar(dst + blocks * 16, src + blocks * 32, length - blocks * 32) < 0) {
+        return -1;
+    }
+    return (long)(length / 2);
+}
+
+static __m128i chars_sse2(__m128i nibbles)
+{
+    __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9)), _mm_set1_epi8('A' - '0' - 10));
+    return _mm_add_epi8(_mm_add_epi8(nibbles, _mm_set1_epi8('0')), letters);
+}
+
+static void encode_sse2(char *dst, const char *src, size_t length)
+{
+    size_t blocks = length / 16;
+    const __m128i mask = _mm_set1_epi8(0x0F);
+
+    for (size_t i = 0; i < blocks; i++) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i * 16));
+        __m128i hi = chars_sse2(_mm_and_si128(_mm_srli_epi16(v, 4), mask));
+        __m128i lo = chars_sse2(_mm_and_si128(v, mask));
+
+        _mm_storeu_si128((__m128i *)(dst + i * 32), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i *)(dst + i * 32 + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+
+    encode_scalar(dst + blocks * 32, src + blocks * 16, length - blocks * 16);
+}
+#endif
+
+#if defined(SCOMX_HEX_AVX2)
+__attribute__((target("avx2"))) static int values_avx2(__m256i c, __m256i *values)
+{
+    __m256i digit = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+    __m256i letter = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+    __m256i is_letter = _mm256_cmpeq_epi8(_mm256_min_epu8(letter, _mm256_set1_epi8(5)), letter);
+
+    *values = _mm256_or_si256(_mm256_and_si256(is_digit, digit), _mm256_and_si256(is_letter, _mm256_add_epi8(letter, _mm256_set1_epi8(10))));
+
+    return (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(is_digit, is_letter)) == 0xFFFFFFFFu;
+}
+
+__attribute__((target("avx2"))) static long decode_avx2(char *dst, const char *src, size_t length)
+{
+    size_t blocks = length / 64;
+    // first digit of a pair times 16 plus the second one
+    const __m256i weights = _mm256_set1_epi16(0x0110);
+
+    for (size_t i = 0; i < blocks; i++) {
+        __m256i a, b;
+
+        if (!values_avx2(_mm256_loadu_si256((const __m256i *)(src + i * 64)), &a) ||
+            !values_avx2(_mm256_loadu_si256((const __m256i *)(src + i * 64 + 32)), &b)) {
+            return -1;
+        }
+        // the pack works within 128 bit lanes, the permutation restores the order of the bytes
+        __m256i bytes = _mm256_packus_epi16(_mm256_maddubs_epi16(a, weights), _mm256_maddubs_epi16(b, weights));
+        _mm256_storeu_si256((__m256i *)(dst + i * 32), _mm256_permute4x64_epi64(bytes, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+
+    if (decode_sse2(dst + blocks * 32, src + blocks * 64, length - blocks * 64) < 0) {
+        return -1;
+    }
+    return (long)(length / 2);
+}
+#endif
+
+#if defined(SCOMX_HEX_NEON)
+// digit values of 16 characters; returns 0 when one of them isn't a hex digit
+static int values_neon(uint8x16_t c, uint8x16_t *values)
+{
+    uint8x16_t digit = vsubq_u8(c, vdupq_n_u8('0'));
+    uint8x16_t letter = vsubq_u8(vorrq_u8(c, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+    uint8x16_t is_digit = vcleq_u8(digit, vdupq_n_u8(9));
+    uint8x16_t is_letter = vcleq_u8(letter, vdupq_n_u8(5));
+
+    *values = vbslq_u8(is_digit, digit, vaddq_u8(letter, vdupq_n_u8(10)));
+
+    return vminvq_u8(vorrq_u8(is_digit, is_letter)) == 0xFF;
+}
+
+static long decode_neon(char *dst, const char *src, size_t length)
+{
+    size_t blocks = length / 32;
+
+    for (size_t i = 0; i < blocks; i++) {
+        // the first and second digits of the pairs, deinterleaved
+        uint8x16x2_t c = vld2q_u8((const uint8_t *)(src + i * 32));
+        uint8x16_t hi, lo;
+
+        if (!values_neon(c.val[0], &hi) || !values_neon(c.val[1], &lo)) {
+            return -1;
+        }
+        vst1q_u8((uint8_t *)(dst + i * 16), vorrq_u8(vshlq_n_u8(hi, 4), lo));
+    }
+
+    if (decode_scalar(dst + blocks * 16, src + blocks * 32, length - blocks * 32) < 0) {
+        return -1;
+    }
+    return (long)(length / 2);
+}
+
+static uint8x16_t chars_neon(uint8x16_t nibbles)
+{
+    uint8x16_t letters = vandq_u8(vcgtq_u8(nibbles, vdupq_n_u8(9)), vdupq_n_u8('A' - '0' - 10));
+    return vaddq_u8(vaddq_u8(nibbles, vdupq_n_u8('0')), letters);
+}
+
+static void encode_neon(char *dst, const char *src, size_t length)
+{
+    size_t blocks = length / 16;
+
+    for (size_t i = 0; i < blocks; i++) {
+        uint8x16_t v = vld1q_u8((const uint8_t *)(src + i * 16));
+        uint8x16x2_t c;
+
+        c.val[0] = chars_neon(vshrq_n_u8(v, 4));
+        c.val[1] = chars_neon(vandq_u8(v, vdupq_n_u8(0x0F)));
+        vst2q_u8((uint8_t *)(dst + i * 32), c);
+    }
+
+    encode_scalar(dst + blocks * 32, src + blocks * 16, length - blocks * 16);
+}
+#endif
+
+// picks the best kernels supported by the CPU on the first call
+static const hex_kernel_t *select_kernel()
+{
+#if defined(SCOMX_HEX_AVX2)
+    static const hex_kernel_t avx2 = {"avx2", decode_avx2, encode_sse2};
+    if (__builtin_cpu_supports("avx2")) {
+        return &avx2;
+    }
+#endif
+#if defined(__SSE2__)
+    static const hex_kernel_t sse2 = {"sse2", decode_sse2, encode_sse2};
+    return &sse2;
+#endif
+#if defined(SCOMX_HEX_NEON)
+    static const hex_kernel_t neon = {"neon", decode_neon, encode_neon};
+    return &neon;
+#endif
+    static const hex_kernel_t scalar = {"scalar", decode_scalar, encode_scalar};
+    return &scalar;
+}
+
+static const hex_kernel_t *g_kernel;
+
+static const hex_kernel_t *kernel()
+{
+    // threads converting at once may both select the kernel, atomically storing the same pointer
+    const hex_kernel_t *k = __atomic_load_n(&g_kernel, __ATOMIC_ACQUIRE);
+
+    if (!k) {
+        k = select_kernel();
+        __atomic_store_n(&g_kernel, k, __ATOMIC_RELEASE);
+    }
+    return k;
+}
+
+long scomx_hex_decode_ref(char *dst, const char *src, size_t length) { return length % 2 ? -1 : decode_scalar(dst, src, length); }
+
+void scomx_hex_encode_ref(char *dst, const char *src, size_t length) { encode_scalar(dst, src, length); }
+
+long scomx_hex_decode(char *dst, const char *src, size_t length)
+{
+    if (length % 2) {
+        return -1;
+    }
+    // a frame header is not worth the indirect call
+    if (length < 32) {
+        return decode_scalar(dst, src, length);
+    }
+    return kernel()->decode(dst, src, length);
+}
+
+void scomx_hex_encode(char *dst, const char *src, size_t length)
+{
+    if (length < 16) {
+        encode_scalar(dst, src, length);
+        return;
+    }
+    kernel()->encode(dst, src, length);
+}
+
+const char *scomx_hex_kernel_name() { return kernel()->name; }
+
+static int is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// slow path for lines with blanks between the digits
+static long decode_spaced(char *dst, size_t size, const char *src, size_t length)
+{
+    size_t count = 0;
+    int hi = -1;
+
+    for (size_t i = 0; i < length; i++) {
+        if (is_blank(src[i])) {
+            continue;
+        }
+
+        int value = digit_value((unsigned char)src[i]);
+        if (value < 0) {
+            return -1;
+        }
+        if (hi < 0) {
+            hi = value;
+        } else {
+            if (count == size) {
+                return -1;
+            }
+            dst[count++] = (char)(hi << 4 | value);
+            hi = -1;
+        }
+    }
+
+    return hi < 0 ? (long)count : -1;
+}
+
+void scomx_hexlog_init(scomx_hexlog_t *log, const char *text, size_t length, char *frame_buffer, size_t frame_buffer_size)
+{
+    memset(log, 0, sizeof(*log));
+    log->text = text;
+    log->length = length;
+    log->frame = frame_buffer;
+    log->frame_size = frame_buffer_size;
+}
+
+int scomx_hexlog_next(scomx_hexlog_t *log, scomx_hexlog_record_t *record)
+{
+    while (log->offset < log->length) {
+        const char *line = log->text + log->offset;
+        size_t rest = log->length - log->offset;
+        const char *end = (const char *)memchr(line, '\n', rest);
+        size_t length = end ? (size_t)(end - line) : rest;
+
+        log->offset += end ? length + 1 : length;
+        log->line++;
+
+        while (length > 0 && is_blank(line[length - 1])) {
+            length--;
+        }
+        while (length > 0 && is_blank(line[0])) {
+            line++;
+            length--;
+        }
+        if (length == 0 || line[0] == '#') {
+            continue;
+        }
+
+        long n = length / 2 <= log->frame_size ? scomx_hex_decode(log->frame, line, length) : -1;
+        if (n < 0) {
+            n = decode_spaced(log->frame, log->frame_size, line, length);
+        }
+        if (n < 0) {
+            log->invalid_lines++;
+            continue;
+        }
+
+        memset(record, 0, sizeof(*record));
+        record->line = log->line;
+        record->frame = log->frame;
+        record->frame_length = (size_t)n;
+        // service flags following the frame header
+        record->is_response = record->frame_length > SCOM_FRAME_HEADER_SIZE && (log->frame[SCOM_FRAME_HEADER_SIZE] & 0x02);
+
+        if (record->is_response) {
+            record->result = scomx_decode_frame_inplace(log->frame, record->frame_length);
+            record->value = scomx_decode_typed(&record->result);
+        } else {
+            record->result = scomx_decode_request_inplace(log->frame, record->frame_length);
+            record->value.error = record->result.error;
+        }
+        log->records++;
+
+        return 1;
+    }
+
+    return 0;
+}
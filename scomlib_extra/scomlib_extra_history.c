@@ -0,0 +1,104 @@
+#include "scomlib_extra.h"
+
+#include <string.h>
+
+// The head and the slot sequence numbers are the only synchronization: the producer marks a slot
+// odd, writes the sample and publishes it with its even sequence number, then advances the head.
+// A consumer copies a slot between two loads of its sequence number and keeps the copy only when
+// both are the sequence number of the sample it wanted.
+
+static uint32_t slot_seq(uint32_t n) { return 2 * n + 2; }
+
+// copies sample n; returns 0 when it was overwritten (or is being overwritten)
+static int read_slot(const scomx_history_t *history, uint32_t n, scomx_sample_t *sample)
+{
+    const scomx_history_slot_t *slot = &history->slots[n & history->mask];
+    uint32_t seq = slot_seq(n);
+
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != seq) {
+        return 0;
+    }
+
+    sample->timestamp_ms = __atomic_load_n(&slot->timestamp_ms, __ATOMIC_RELAXED);
+    __atomic_load(&slot->value, &sample->value, __ATOMIC_RELAXED);
+    sample->error = (scom_error_t)__atomic_load_n(&slot->error, __ATOMIC_RELAXED);
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    return __atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == seq;
+}
+
+void scomx_history_init(scomx_history_t *history, scomx_history_slot_t *slots, size_t capacity)
+{
+    memset(history, 0, sizeof(*history));
+    memset(slots, 0, capacity * sizeof(*slots));
+
+    history->slots = slots;
+    history->mask = (uint32_t)capacity - 1;
+}
+
+void scomx_history_push(scomx_history_t *history, int64_t timestamp_ms, float value, scom_error_t error)
+{
+    // only the producer writes the head
+    uint32_t n = history->head;
+    scomx_history_slot_t *slot = &history->slots[n & history->mask];
+
+    __atomic_store_n(&slot->seq, slot_seq(n) - 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    __atomic_store_n(&slot->timestamp_ms, timestamp_ms, __ATOMIC_RELAXED);
+    __atomic_store(&slot->value, &value, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->error, (uint16_t)error, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&slot->seq, slot_seq(n), __ATOMIC_RELEASE);
+    __atomic_store_n(&history->head, n + 1, __ATOMIC_RELEASE);
+}
+
+size_t scomx_history_read(const scomx_history_t *history, uint32_t *cursor, scomx_sample_t *samples, size_t max, uint32_t *lost)
+{
+    uint32_t head = __atomic_load_n(&history->head, __ATOMIC_ACQUIRE);
+    uint32_t capacity = history->mask + 1;
+    uint32_t n = *cursor;
+    uint32_t skipped = 0;
+    size_t count = 0;
+
+    // counters wrap, only their difference matters
+    if (head - n > capacity) {
+        skipped = head - n - capacity;
+        n = head - capacity;
+    }
+
+    for (; n != head && count < max; n++) {
+        if (read_slot(history, n, &samples[count])) {
+            count++;
+        } else {
+            skipped++;
+        }
+    }
+
+    *cursor = n;
+    if (lost) {
+        *lost = skipped;
+    }
+
+    return count;
+}
+
+size_t scomx_history_recent(const scomx_history_t *history, scomx_sample_t *samples, size_t max)
+{
+    uint32_t head = __atomic_load_n(&history->head, __ATOMIC_ACQUIRE);
+    uint32_t available = head < history->mask + 1 ? head : history->mask + 1;
+    size_t count = 0;
+
+    if (max > available) {
+        max = available;
+    }
+
+    for (uint32_t n = head - (uint32_t)max; n != head; n++) {
+        if (read_slot(history, n, &samples[count])) {
+            count++;
+        }
+    }
+
+    return count;
+}
@@ -0,0 +1,128 @@
+#include "scomlib_extra.h"
+
+#include <string.h>
+
+scom_error_t scomx_decode_message(const scomx_dec_result_t *res, scomx_message_t *message)
+{
+    if (res->error != SCOM_ERROR_NO_ERROR) {
+        return res->error;
+    }
+    if (res->object_type != SCOM_MESSAGE_OBJECT_TYPE || res->length < SCOMX_MESSAGE_SIZE) {
+        return SCOM_ERROR_INVALID_DATA_LENGTH;
+    }
+
+    uint32_t total = scom_read_le32(res->data);
+    if (res->object_id >= total) {
+        return SCOM_ERROR_INVALID_DATA;
+    }
+
+    message->seq = total - 1 - res->object_id;
+    message->type = scom_read_le16(res->data + 4);
+    message->source = scom_read_le32(res->data + 6);
+    message->timestamp = scom_read_le32(res->data + 10);
+    message->value = scom_read_le32(res->data + 14);
+
+    return SCOM_ERROR_NO_ERROR;
+}
+
+void scomx_msglog_init(scomx_msglog_t *log, uint32_t dst_addr, uint32_t cursor, scomx_message_callback_t callback, void *user)
+{
+    memset(log, 0, sizeof(*log));
+
+    log->dst_addr = dst_addr;
+    log->cursor = cursor;
+    log->callback = callback;
+    log->user = user;
+}
+
+static void finish(scomx_msglog_t *log)
+{
+    log->cursor = log->newest;
+    log->active = 0;
+}
+
+void scomx_msglog_start(scomx_msglog_t *log) { log->pending = 1; }
+
+int scomx_msglog_next(scomx_msglog_t *log, char *frame)
+{
+    if (!log->active) {
+        if (!log->pending) {
+            return 0;
+        }
+        log->pending = 0;
+        log->active = 1;
+        log->index = 0;
+    }
+
+    scomx_encode_read_request_frame(frame, log->dst_addr, SCOM_MESSAGE_OBJECT_TYPE, log->index, SCOMX_PROP_MESSAGE);
+
+    return 1;
+}
+
+scom_error_t scomx_msglog_complete(scomx_msglog_t *log, const scomx_dec_result_t *res)
+{
+    scomx_message_t message;
+
+    if (!log->active) {
+        return SCOM_ERROR_NO_ERROR;
+    }
+
+    log->reads++;
+
+    if (res->error == SCOM_ERROR_OBJECT_ID_NOT_FOUND) {
+        // past the oldest message kept by the gateway, or there is no message at all
+        if (log->index > 0) {
+            log->lost += log->expected - log->cursor + 1;
+        }
+        log->newest = log->index > 0 ? log->newest : log->cursor;
+        finish(log);
+        return SCOM_ERROR_NO_ERROR;
+    }
+
+    scom_error_t error = scomx_decode_message(res, &message);
+    if (error != SCOM_ERROR_NO_ERROR) {
+        log->active = 0;
+        return error;
+    }
+
+    if (log->index == 0) {
+        if (message.seq + 1 < log->cursor) {
+            // the gateway lost its messages (e.g. a reset), so all the messages it has are new
+            log->cursor = 0;
+        }
+        log->newest = message.seq + 1;
+        log->expected = message.seq;
+    }
+
+    if (message.seq < log->cursor) {
+        // known history
+        finish(log);
+        return SCOM_ERROR_NO_ERROR;
+    }
+
+    if (message.seq > log->expected) {
+        // messages arrived during the fetch and moved the older ones to higher indexes; they are
+        // read by another fetch
+        log->index += message.seq - log->expected;
+        log->pending = 1;
+        return SCOM_ERROR_NO_ERROR;
+    }
+
+    log->index++;
+    if (message.seq < log->expected) {
+        log->lost += log->expected - message.seq;
+    }
+
+    log->delivered++;
+    if (log->callback) {
+        log->callback(log->user, &message);
+    }
+
+    if (message.seq == log->cursor) {
+        finish(log);
+    } else {
+        log->expected = message.seq - 1;
+    }
+
+    return SCOM_ERROR_NO_ERROR;
+}
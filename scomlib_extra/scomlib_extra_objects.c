@@ -0,0 +1,255 @@
+#include "scomlib_extra.h"
+
+#include <string.h>
+
+// The table and its index are expanded from scomlib_extra_objects.def, so that adding an object
+// there is the only change needed.
+
+#define TYPE_INFO_XTENDER SCOM_USER_INFO_OBJECT_TYPE
+#define TYPE_INFO_BSP SCOM_USER_INFO_OBJECT_TYPE
+#define TYPE_INFO_VARIOTRACK SCOM_USER_INFO_OBJECT_TYPE
+#define TYPE_PARAM_RC SCOM_PARAMETER_OBJECT_TYPE
+#define TYPE_PARAM_XTENDER SCOM_PARAMETER_OBJECT_TYPE
+#define TYPE_PARAM_VARIOTRACK SCOM_PARAMETER_OBJECT_TYPE
+
+#define WRITABLE_INFO_XTENDER 0
+#define WRITABLE_INFO_BSP 0
+#define WRITABLE_INFO_VARIOTRACK 0
+#define WRITABLE_PARAM_RC 1
+#define WRITABLE_PARAM_XTENDER 1
+#define WRITABLE_PARAM_VARIOTRACK 1
+
+// object_ids of a block are in [base, base + 1000)
+#define BLOCK_SIZE 1000
+#define BASE_INFO_XTENDER 3000
+#define BASE_INFO_BSP 7000
+#define BASE_INFO_VARIOTRACK 11000
+#define BASE_PARAM_RC 5000
+#define BASE_PARAM_XTENDER 1000
+#define BASE_PARAM_VARIOTRACK 10000
+
+#define SIZE_FLOAT 4
+#define SIZE_INT32 4
+#define SIZE_ENUM 2
+#define SIZE_BOOL 1
+
+#define LABELS(...) (const char *const[]){__VA_ARGS__}, SCOM_NBR_ELEMENTS(((const char *const[]){__VA_ARGS__}))
+#define NO_LABELS NULL, 0
+
+// position of each object in k_objects
+enum {
+#define SCOMX_OBJECT(block, id, format, unit, scale, labels) POS_##id,
+#include "scomlib_extra_objects.def"
+#undef SCOMX_OBJECT
+    OBJECT_COUNT
+};
+
+static scomx_typed_value_t decode_error(scom_error_t error)
+{
+    scomx_typed_value_t v;
+
+    memset(&v, 0, sizeof(v));
+    v.error = error;
+
+    return v;
+}
+
+static scomx_typed_value_t decode_float(const scomx_object_meta_t *meta, const scomx_dec_result_t *res)
+{
+    if (res->error != SCOM_ERROR_NO_ERROR || res->length < 4) {
+        return decode_error(res->error != SCOM_ERROR_NO_ERROR ? res->error : SCOM_ERROR_INVALID_DATA_LENGTH);
+    }
+
+    scomx_typed_value_t v = decode_error(SCOM_ERROR_NO_ERROR);
+    v.value = scom_read_le_float(res->data) * meta->scale;
+    v.integer = (int32_t)v.value;
+
+    return v;
+}
+
+static scomx_typed_value_t decode_int32(const scomx_object_meta_t *meta, const scomx_dec_result_t *res)
+{
+    if (res->error != SCOM_ERROR_NO_ERROR || res->length < 4) {
+        return decode_error(res->error != SCOM_ERROR_NO_ERROR ? res->error : SCOM_ERROR_INVALID_DATA_LENGTH);
+    }
+
+    scomx_typed_value_t v = decode_error(SCOM_ERROR_NO_ERROR);
+    v.integer = (int32_t)scom_read_le32(res->data);
+    v.value = (float)v.integer * meta->scale;
+
+    return v;
+}
+
+static scomx_typed_value_t decode_enum(const scomx_object_meta_t *meta, const scomx_dec_result_t *res)
+{
+    if (res->error != SCOM_ERROR_NO_ERROR || res->length < 2) {
+        return decode_error(res->error != SCOM_ERROR_NO_ERROR ? res->error : SCOM_ERROR_INVALID_DATA_LENGTH);
+    }
+
+    scomx_typed_value_t v = decode_error(SCOM_ERROR_NO_ERROR);
+    v.integer = scom_read_le16(res->data);
+    v.value = (float)v.integer;
+    v.label = (size_t)v.integer < meta->label_count ? meta->labels[v.integer] : NULL;
+
+    return v;
+}
+
+static scomx_typed_value_t decode_bool(const scomx_object_meta_t *meta, const scomx_dec_result_t *res)
+{
+    (void)meta;
+
+    if (res->error != SCOM_ERROR_NO_ERROR || res->length < 1) {
+        return decode_error(res->error != SCOM_ERROR_NO_ERROR ? res->error : SCOM_ERROR_INVALID_DATA_LENGTH);
+    }
+
+    scomx_typed_value_t v = decode_error(SCOM_ERROR_NO_ERROR);
+    v.integer = res->data[0] != 0;
+    v.value = (float)v.integer;
+
+    return v;
+}
+
+// rounds half away from zero, without pulling in libm
+static int32_t round_int32(float value) { return (int32_t)(value < 0 ? value - 0.5f : value + 0.5f); }
+
+static size_t encode_float(const scomx_object_meta_t *meta, float value, char *data)
+{
+    scom_write_le_float(data, value / meta->scale);
+    return 4;
+}
+
+static size_t encode_int32(const scomx_object_meta_t *meta, float value, char *data)
+{
+    scom_write_le32(data, (uint32_t)round_int32(value / meta->scale));
+    return 4;
+}
+
+static size_t encode_enum(const scomx_object_meta_t *meta, float value, char *data)
+{
+    (void)meta;
+    scom_write_le16(data, (uint16_t)round_int32(value));
+    return 2;
+}
+
+static size_t encode_bool(const scomx_object_meta_t *meta, float value, char *data)
+{
+    (void)meta;
+    data[0] = value != 0;
+    return 1;
+}
+
+#define DECODE_FLOAT decode_float
+#define DECODE_INT32 decode_int32
+#define DECODE_ENUM decode_enum
+#define DECODE_BOOL decode_bool
+
+#define ENCODE_FLOAT encode_float
+#define ENCODE_INT32 encode_int32
+#define ENCODE_ENUM encode_enum
+#define ENCODE_BOOL encode_bool
+
+static const scomx_object_meta_t k_objects[OBJECT_COUNT] = {
+#define SCOMX_OBJECT(block, id, format, unit, scale, labels)                                                                                                   \
+    {TYPE_##block, id, #id, SCOM_FORMAT_##format, SIZE_##format, unit, scale, labels, WRITABLE_##block, DECODE_##format, ENCODE_##format},
+#include "scomlib_extra_objects.def"
+#undef SCOMX_OBJECT
+};
+
+// Dense index of each block: entry object_id - base holds the position in k_objects plus one, 0
+// for object_ids which aren't listed. The arrays are sized by the largest listed object_id.
+#define INDEX_ENTRY(block, id) [(id) - BASE_##block] = POS_##id + 1,
+#define SKIP_ENTRY(block, id)
+
+// each array is expanded with the entries of its own block selected by the IS_ macros
+#define SCOMX_OBJECT(block, id, format, unit, scale, labels) IS_##block(block, id)
+
+#define IS_INFO_XTENDER INDEX_ENTRY
+#define IS_INFO_BSP SKIP_ENTRY
+#define IS_INFO_VARIOTRACK SKIP_ENTRY
+#define IS_PARAM_RC SKIP_ENTRY
+#define IS_PARAM_XTENDER SKIP_ENTRY
+#define IS_PARAM_VARIOTRACK SKIP_ENTRY
+static const uint16_t k_index_info_xtender[] = {
+#include "scomlib_extra_objects.def"
+};
+#undef IS_INFO_XTENDER
+#undef IS_INFO_BSP
+#define IS_INFO_XTENDER SKIP_ENTRY
+#define IS_INFO_BSP INDEX_ENTRY
+static const uint16_t k_index_info_bsp[] = {
+#include "scomlib_extra_objects.def"
+};
+#undef IS_INFO_BSP
+#undef IS_INFO_VARIOTRACK
+#define IS_INFO_BSP SKIP_ENTRY
+#define IS_INFO_VARIOTRACK INDEX_ENTRY
+static const uint16_t k_index_info_variotrack[] = {
+#include "scomlib_extra_objects.def"
+};
+#undef IS_INFO_VARIOTRACK
+#undef IS_PARAM_RC
+#define IS_INFO_VARIOTRACK SKIP_ENTRY
+#define IS_PARAM_RC INDEX_ENTRY
+static const uint16_t k_index_param_rc[] = {
+#include "scomlib_extra_objects.def"
+};
+#undef IS_PARAM_RC
+#undef IS_PARAM_XTENDER
+#define IS_PARAM_RC SKIP_ENTRY
+#define IS_PARAM_XTENDER INDEX_ENTRY
+static const uint16_t k_index_param_xtender[] = {
+#include "scomlib_extra_objects.def"
+};
+#undef IS_PARAM_XTENDER
+#undef IS_PARAM_VARIOTRACK
+#define IS_PARAM_XTENDER SKIP_ENTRY
+#define IS_PARAM_VARIOTRACK INDEX_ENTRY
+static const uint16_t k_index_param_variotrack[] = {
+#include "scomlib_extra_objects.def"
+};
+
+#undef SCOMX_OBJECT
+
+typedef struct {
+    scom_object_type_t object_type;
+    const uint16_t *index;
+    size_t length;
+} block_t;
+
+#define BLOCK(block, index) [BASE_##block / BLOCK_SIZE] = {TYPE_##block, index, SCOM_NBR_ELEMENTS(index)}
+
+// blocks by object_id / BLOCK_SIZE
+static const block_t k_blocks[] = {
+    BLOCK(PARAM_XTENDER, k_index_param_xtender),   BLOCK(INFO_XTENDER, k_index_info_xtender), BLOCK(PARAM_RC, k_index_param_rc),
+    BLOCK(INFO_BSP, k_index_info_bsp),             BLOCK(PARAM_VARIOTRACK, k_index_param_variotrack), BLOCK(INFO_VARIOTRACK, k_index_info_variotrack),
+};
+
+const scomx_object_meta_t *scomx_object_meta(scom_object_type_t object_type, uint32_t object_id)
+{
+    uint32_t b = object_id / BLOCK_SIZE;
+    uint32_t offset = object_id % BLOCK_SIZE;
+
+    if (b >= SCOM_NBR_ELEMENTS(k_blocks) || !k_blocks[b].index || k_blocks[b].object_type != object_type || offset >= k_blocks[b].length) {
+        return NULL;
+    }
+
+    uint16_t pos = k_blocks[b].index[offset];
+
+    return pos ? &k_objects[pos - 1] : NULL;
+}
+
+scomx_typed_value_t scomx_decode_typed(const scomx_dec_result_t *res)
+{
+    const scomx_object_meta_t *meta = res->error == SCOM_ERROR_NO_ERROR ? scomx_object_meta((scom_object_type_t)res->object_type, res->object_id) : NULL;
+
+    if (!meta) {
+        scomx_object_meta_t fallback;
+
+        memset(&fallback, 0, sizeof(fallback));
+        fallback.scale = 1;
+
+        return decode_float(&fallback, res);
+    }
+
+    return meta->decode(meta, res);
+}
@@ -0,0 +1,133 @@
+#include "scomlib_extra.h"
+
+#include <string.h>
+
+// drops the first n buffered bytes
+static void drop_buffered(scomx_parser_t *parser, size_t n)
+{
+    memmove(parser->buffer, parser->buffer + n, parser->length - n);
+    parser->length -= n;
+    parser->frame_length = 0;
+}
+
+// drops the start byte of a rejected frame so that the search for the next start byte begins right after it
+static void resync(scomx_parser_t *parser)
+{
+    parser->frames_rejected++;
+    parser->bytes_discarded++;
+    drop_buffered(parser, 1);
+}
+
+// ensures the buffer begins with a start byte, dropping any garbage in front of it
+static void strip_to_start_byte(scomx_parser_t *parser)
+{
+    const char *start = memchr(parser->buffer, SCOMX_START_BYTE, parser->length);
+    size_t skip = start ? (size_t)(start - parser->buffer) : parser->length;
+
+    if (skip > 0) {
+        parser->bytes_discarded += skip;
+        drop_buffered(parser, skip);
+    }
+}
+
+void scomx_parser_init(scomx_parser_t *parser, char *buffer, size_t buffer_size)
+{
+    memset(parser, 0, sizeof(*parser));
+
+    parser->buffer = buffer;
+    // a buffer which can't even hold a header is never written to
+    parser->buffer_size = buffer_size < SCOM_FRAME_HEADER_SIZE ? 0 : buffer_size;
+}
+
+void scomx_parser_reset(scomx_parser_t *parser)
+{
+    parser->bytes_discarded += parser->frame_ready ? 0 : parser->length;
+    parser->length = 0;
+    parser->frame_length = 0;
+    parser->frame_ready = 0;
+}
+
+scomx_parse_result_t scomx_parser_push(scomx_parser_t *parser, const char *data, size_t data_len)
+{
+    scomx_parse_result_t res;
+
+    memset(&res, 0, sizeof(res));
+
+    // release the frame returned by the previous call, keeping any bytes buffered after it
+    if (parser->frame_ready) {
+        parser->frame_ready = 0;
+        drop_buffered(parser, parser->frame_length);
+    }
+
+    if (parser->buffer_size < SCOM_FRAME_HEADER_SIZE) {
+        parser->bytes_discarded += data_len;
+        res.consumed = data_len;
+        return res;
+    }
+
+    for (;;) {
+        strip_to_start_byte(parser);
+
+        if (parser->length == 0) {
+            // hunt for the start byte directly in the input
+            const char *start = memchr(data + res.consumed, SCOMX_START_BYTE, data_len - res.consumed);
+            size_t skip = start ? (size_t)(start - (data + res.consumed)) : data_len - res.consumed;
+
+            parser->bytes_discarded += skip;
+            res.consumed += skip;
+
+            if (!start) {
+                return res;
+            }
+        }
+
+        // buffer the header first, then the rest of the frame once the header is known to be valid
+        size_t needed = parser->frame_length ? parser->frame_length : SCOM_FRAME_HEADER_SIZE;
+
+        if (parser->length < needed) {
+            size_t chunk = SCOM_MIN(needed - parser->length, data_len - res.consumed);
+
+            memcpy(parser->buffer + parser->length, data + res.consumed, chunk);
+            parser->length += chunk;
+            res.consumed += chunk;
+
+            if (parser->length < needed) {
+                return res;
+            }
+        }
+
+        if (!parser->frame_length) {
+            scomx_header_dec_result_t hdr = scomx_decode_frame_header_inplace(parser->buffer, parser->length);
+
+            if (hdr.error != SCOM_ERROR_NO_ERROR || SCOM_FRAME_HEADER_SIZE + hdr.length_to_read > parser->buffer_size) {
+                // a 0xAA inside of other data or a frame we could never buffer, look for the next start byte
+                resync(parser);
+                continue;
+            }
+
+            parser->frame_length = SCOM_FRAME_HEADER_SIZE + hdr.length_to_read;
+            continue;
+        }
+
+        if (parser->decode_requests) {
+            res.result = scomx_decode_request_inplace(parser->buffer, parser->frame_length);
+        } else {
+            res.result = scomx_decode_frame_inplace(parser->buffer, parser->frame_length);
+        }
+        if (res.result.error == SCOM_ERROR_INVALID_FRAME) {
+            // data checksum mismatch, the header matched just by chance
+            memset(&res.result, 0, sizeof(res.result));
+            resync(parser);
+            continue;
+        }
+
+        parser->frame_ready = 1;
+        parser->frames_received++;
+
+        res.frame_ready = 1;
+        res.frame = parser->buffer;
+        res.frame_length = parser->frame_length;
+
+        return res;
+    }
+}
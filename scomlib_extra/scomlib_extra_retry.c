@@ -0,0 +1,185 @@
+#include "scomlib_extra.h"
+
+#include <string.h>
+
+#define DEFAULT_MAX_RETRIES 3
+// about the time the gateway takes to answer a read, so the first retry doesn't find it busy again
+#define DEFAULT_BASE_DELAY_MS 100
+#define DEFAULT_MAX_DELAY_MS 5000
+#define DEFAULT_JITTER 0.5f
+#define DEFAULT_BUDGET_MS 10000
+
+// finds the slot of the destination; creates it when create is set and the table isn't full
+static scomx_retry_dest_t *find_dest(const scomx_retry_t *retry, uint32_t dst_addr, int create)
+{
+    for (size_t i = 0; i < retry->capacity; i++) {
+        scomx_retry_dest_t *dest = &retry->dests[i];
+
+        if (!dest->used) {
+            if (!create) {
+                return NULL;
+            }
+            memset(dest, 0, sizeof(*dest));
+            dest->used = 1;
+            dest->dst_addr = dst_addr;
+            return dest;
+        }
+        if (dest->dst_addr == dst_addr) {
+            return dest;
+        }
+    }
+    return NULL;
+}
+
+// xorshift32, good enough to spread retries
+static uint32_t next_random(scomx_retry_t *retry)
+{
+    uint32_t x = retry->random;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    retry->random = x;
+
+    return x;
+}
+
+// removes a random share (the jitter) of the delay
+static uint32_t jittered(scomx_retry_t *retry, uint32_t delay_ms)
+{
+    float fraction = (float)(next_random(retry) >> 8) / (float)(1u << 24);
+
+    return delay_ms - (uint32_t)(delay_ms * retry->config.jitter * fraction);
+}
+
+static void count_error(scomx_retry_dest_t *dest, scom_error_t error)
+{
+    for (size_t i = 0; i < SCOMX_RETRY_ERROR_SLOTS; i++) {
+        if (dest->errors[i].count == 0) {
+            dest->errors[i].error = error;
+        }
+        if (dest->errors[i].error == error) {
+            dest->errors[i].count++;
+            return;
+        }
+    }
+    dest->other_errors++;
+}
+
+void scomx_retry_init(scomx_retry_t *retry, scomx_retry_dest_t *dests, size_t capacity, uint32_t seed)
+{
+    memset(retry, 0, sizeof(*retry));
+    memset(dests, 0, capacity * sizeof(*dests));
+
+    retry->config.max_retries = DEFAULT_MAX_RETRIES;
+    retry->config.base_delay_ms = DEFAULT_BASE_DELAY_MS;
+    retry->config.max_delay_ms = DEFAULT_MAX_DELAY_MS;
+    retry->config.jitter = DEFAULT_JITTER;
+    retry->config.budget_ms = DEFAULT_BUDGET_MS;
+    retry->dests = dests;
+    retry->capacity = capacity;
+    // xorshift never leaves 0
+    retry->random = seed ? seed : 0x9E3779B9u;
+}
+
+int scomx_retry_is_retryable(scom_error_t error) { return error == SCOM_ERROR_RESPONSE_TIMEOUT || error == SCOM_ERROR_GATEWAY_BUSY; }
+
+int64_t scomx_retry_begin(scomx_retry_t *retry, scomx_retry_state_t *state, uint32_t dst_addr, int64_t now_ms)
+{
+    const scomx_retry_dest_t *dest = find_dest(retry, dst_addr, 0);
+
+    state->dst_addr = dst_addr;
+    state->attempts = 0;
+    state->deadline_ms = retry->config.budget_ms ? now_ms + retry->config.budget_ms : 0;
+
+    return dest && dest->not_before_ms > now_ms ? dest->not_before_ms : now_ms;
+}
+
+scomx_retry_decision_t scomx_retry_complete(scomx_retry_t *retry, scomx_retry_state_t *state, scom_error_t error, int64_t now_ms)
+{
+    const scomx_retry_config_t *config = &retry->config;
+    scomx_retry_dest_t *dest = find_dest(retry, state->dst_addr, 1);
+    scomx_retry_decision_t decision;
+
+    state->attempts++;
+    decision.action = SCOMX_RETRY_FAILED;
+    decision.retry_at_ms = 0;
+
+    if (!dest) {
+        retry->overflows++;
+    } else {
+        dest->attempts++;
+    }
+
+    if (error == SCOM_ERROR_NO_ERROR) {
+        if (dest) {
+            dest->successes++;
+            dest->backoff_ms /= 2;
+            if (dest->backoff_ms < config->base_delay_ms) {
+                dest->backoff_ms = 0;
+            }
+        }
+        decision.action = SCOMX_RETRY_SUCCEEDED;
+        return decision;
+    }
+
+    if (dest) {
+        count_error(dest, error);
+    }
+
+    if (!scomx_retry_is_retryable(error)) {
+        if (dest) {
+            dest->failures++;
+        }
+        return decision;
+    }
+
+    // the destination as a whole slows down, whatever happens to this request
+    if (dest) {
+        dest->backoff_ms = dest->backoff_ms ? dest->backoff_ms * 2 : config->base_delay_ms;
+        if (dest->backoff_ms > config->max_delay_ms) {
+            dest->backoff_ms = config->max_delay_ms;
+        }
+        dest->not_before_ms = now_ms + jittered(retry, dest->backoff_ms);
+    }
+
+    uint32_t delay = config->base_delay_ms;
+    for (unsigned i = 1; i < state->attempts && delay < config->max_delay_ms; i++) {
+        delay *= 2;
+    }
+    if (delay > config->max_delay_ms) {
+        delay = config->max_delay_ms;
+    }
+
+    int64_t retry_at = now_ms + jittered(retry, delay);
+    if (dest && dest->not_before_ms > retry_at) {
+        retry_at = dest->not_before_ms;
+    }
+
+    if (state->attempts > config->max_retries || (state->deadline_ms && retry_at >= state->deadline_ms)) {
+        if (dest) {
+            dest->failures++;
+        }
+        return decision;
+    }
+
+    if (dest) {
+        dest->retries++;
+    }
+    decision.action = SCOMX_RETRY_AGAIN;
+    decision.retry_at_ms = retry_at;
+
+    return decision;
+}
+
+const scomx_retry_dest_t *scomx_retry_dest(const scomx_retry_t *retry, uint32_t dst_addr) { return find_dest(retry, dst_addr, 0); }
+
+unsigned long scomx_retry_error_count(const scomx_retry_dest_t *dest, scom_error_t error)
+{
+    for (size_t i = 0; i < SCOMX_RETRY_ERROR_SLOTS; i++) {
+        if (dest->errors[i].count > 0 && dest->errors[i].error == error) {
+            return dest->errors[i].count;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,179 @@
+#include "scomlib_extra.h"
+
+#include <string.h>
+
+// a read completing exactly at its deadline is still on time
+static int is_late(const scomx_subscription_t *sub, int64_t now_ms)
+{
+    return now_ms > sub->deadline_ms;
+}
+
+// returns 1 when a should be read before b
+static int goes_before(const scomx_subscription_t *a, const scomx_subscription_t *b, int64_t now_ms)
+{
+    // with both already late, the link is overloaded and the more important value goes first
+    if (is_late(a, now_ms) && is_late(b, now_ms) && a->priority != b->priority) {
+        return a->priority < b->priority;
+    }
+    if (a->deadline_ms != b->deadline_ms) {
+        return a->deadline_ms < b->deadline_ms;
+    }
+    return a->priority < b->priority;
+}
+
+void scomx_sched_init(scomx_sched_t *sched, scomx_subscription_t *subscriptions, size_t capacity, int64_t now_ms)
+{
+    memset(sched, 0, sizeof(*sched));
+
+    sched->subscriptions = subscriptions;
+    sched->capacity = capacity;
+    // a user info read at 38400 baud 8E1: the 26 byte request and the 30 byte response of a float take
+    // 56 * 11 bits / 38400 = 16 ms on the wire, before the gateway latency
+    sched->default_cost_ms = 16;
+    sched->stats_start_ms = now_ms;
+}
+
+scomx_subscription_t *scomx_sched_add(scomx_sched_t *sched, uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id, uint16_t property_id,
+                                      uint32_t period_ms, uint8_t priority, int64_t now_ms)
+{
+    if (sched->count >= sched->capacity || period_ms == 0) {
+        return NULL;
+    }
+
+    scomx_subscription_t *sub = &sched->subscriptions[sched->count++];
+
+    memset(sub, 0, sizeof(*sub));
+    sub->dst_addr = dst_addr;
+    sub->object_type = object_type;
+    sub->object_id = object_id;
+    sub->property_id = property_id;
+    sub->period_ms = period_ms;
+    sub->priority = priority;
+    sub->release_ms = now_ms;
+    sub->deadline_ms = now_ms + period_ms;
+    sub->cost_ms = sched->default_cost_ms;
+    scomx_encode_read_request_frame(sub->frame, dst_addr, object_type, object_id, property_id);
+
+    return sub;
+}
+
+scomx_subscription_t *scomx_sched_next(scomx_sched_t *sched, int64_t now_ms)
+{
+    scomx_subscription_t *best = NULL;
+
+    for (size_t i = 0; i < sched->count; i++) {
+        scomx_subscription_t *sub = &sched->subscriptions[i];
+
+        if (sub->in_flight || sub->release_ms > now_ms) {
+            continue;
+        }
+
+        // count a read starved past its deadline now rather than when it eventually completes
+        if (is_late(sub, now_ms) && !sub->late) {
+            sub->late = 1;
+            sub->missed_deadlines++;
+            sched->missed_deadlines++;
+        }
+
+        if (!best || goes_before(sub, best, now_ms)) {
+            best = sub;
+        }
+    }
+
+    if (best) {
+        best->in_flight = 1;
+        best->issued_ms = now_ms;
+
+        if (sched->in_flight++ == 0) {
+            sched->busy_since_ms = now_ms;
+        }
+        sched->issued++;
+    }
+
+    return best;
+}
+
+void scomx_sched_complete(scomx_sched_t *sched, scomx_subscription_t *sub, scom_error_t error, int64_t now_ms)
+{
+    if (!sub->in_flight) {
+        return;
+    }
+
+    int64_t duration = now_ms - sub->issued_ms;
+
+    sub->in_flight = 0;
+    sub->cost_ms = (uint32_t)((3 * (int64_t)sub->cost_ms + (duration > 0 ? duration : 0) + 2) / 4);
+    sub->reads++;
+    sched->completed++;
+
+    if (--sched->in_flight == 0) {
+        sched->busy_ms += now_ms - sched->busy_since_ms;
+    }
+
+    if (error != SCOM_ERROR_NO_ERROR) {
+        sub->errors++;
+        sched->errors++;
+    }
+
+    if (is_late(sub, now_ms) && !sub->late) {
+        sub->missed_deadlines++;
+        sched->missed_deadlines++;
+    }
+
+    // the next period starts when the current one ends; periods which already passed are skipped
+    // instead of being read in a burst
+    sub->release_ms = sub->deadline_ms > now_ms ? sub->deadline_ms : now_ms;
+    sub->deadline_ms = sub->release_ms + sub->period_ms;
+    sub->late = 0;
+}
+
+int scomx_sched_wait_ms(const scomx_sched_t *sched, int64_t now_ms)
+{
+    int64_t wait = -1;
+
+    for (size_t i = 0; i < sched->count; i++) {
+        const scomx_subscription_t *sub = &sched->subscriptions[i];
+
+        if (sub->in_flight) {
+            continue;
+        }
+
+        int64_t remaining = sub->release_ms > now_ms ? sub->release_ms - now_ms : 0;
+        if (wait < 0 || remaining < wait) {
+            wait = remaining;
+        }
+    }
+
+    return (int)wait;
+}
+
+scomx_sched_stats_t scomx_sched_stats(const scomx_sched_t *sched, int64_t now_ms)
+{
+    scomx_sched_stats_t stats;
+    int64_t busy = sched->busy_ms + (sched->in_flight ? now_ms - sched->busy_since_ms : 0);
+    int64_t elapsed = now_ms - sched->stats_start_ms;
+
+    memset(&stats, 0, sizeof(stats));
+    stats.issued = sched->issued;
+    stats.completed = sched->completed;
+    stats.errors = sched->errors;
+    stats.missed_deadlines = sched->missed_deadlines;
+    stats.utilization = elapsed > 0 ? (float)busy / elapsed : 0;
+
+    for (size_t i = 0; i < sched->count; i++) {
+        stats.demand += (float)sched->subscriptions[i].cost_ms / sched->subscriptions[i].period_ms;
+    }
+
+    return stats;
+}
+
+void scomx_sched_reset_stats(scomx_sched_t *sched, int64_t now_ms)
+{
+    sched->stats_start_ms = now_ms;
+    sched->busy_ms = 0;
+    sched->busy_since_ms = now_ms;
+    sched->issued = 0;
+    sched->completed = 0;
+    sched->errors = 0;
+    sched->missed_deadlines = 0;
+}
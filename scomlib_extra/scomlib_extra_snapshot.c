@@ -0,0 +1,137 @@
+#include "scomlib_extra.h"
+
+#include <string.h>
+
+// attempts of a reader to get a value the publisher isn't writing at the same time
+#define READ_ATTEMPTS 16
+
+// the slots start on the cache line after the header
+#define SLOTS_OFFSET SCOMX_CACHE_LINE_SIZE
+
+size_t scomx_snapshot_size(size_t capacity) { return SLOTS_OFFSET + capacity * sizeof(scomx_snapshot_slot_t); }
+
+static void set_layout(scomx_snapshot_t *snap, const void *memory)
+{
+    snap->header = (scomx_snapshot_header_t *)memory;
+    snap->slots = (scomx_snapshot_slot_t *)((char *)memory + SLOTS_OFFSET);
+}
+
+int scomx_snapshot_create(scomx_snapshot_t *snap, void *memory, size_t size)
+{
+    if (size < scomx_snapshot_size(1)) {
+        return -1;
+    }
+
+    set_layout(snap, memory);
+    scomx_snapshot_header_t *header = snap->header;
+
+    // readers still attached to a previous run see the region invalid until it is ready again
+    uint32_t generation = header->magic == SCOMX_SNAPSHOT_MAGIC ? header->generation + 1 : 1;
+    __atomic_store_n(&header->magic, 0, __ATOMIC_RELEASE);
+
+    memset((char *)memory + sizeof(*header), 0, size - sizeof(*header));
+    header->version = SCOMX_SNAPSHOT_VERSION;
+    header->slot_size = sizeof(scomx_snapshot_slot_t);
+    header->capacity = (uint32_t)((size - SLOTS_OFFSET) / sizeof(scomx_snapshot_slot_t));
+    header->count = 0;
+    header->generation = generation;
+
+    __atomic_store_n(&header->magic, SCOMX_SNAPSHOT_MAGIC, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+int scomx_snapshot_attach(scomx_snapshot_t *snap, const void *memory, size_t size)
+{
+    const scomx_snapshot_header_t *header = (const scomx_snapshot_header_t *)memory;
+
+    if (size < scomx_snapshot_size(0) || __atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != SCOMX_SNAPSHOT_MAGIC ||
+        header->version != SCOMX_SNAPSHOT_VERSION || header->slot_size != sizeof(scomx_snapshot_slot_t) || scomx_snapshot_size(header->capacity) > size) {
+        return -1;
+    }
+
+    set_layout(snap, memory);
+
+    return 0;
+}
+
+int scomx_snapshot_add(scomx_snapshot_t *snap, uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id)
+{
+    scomx_snapshot_header_t *header = snap->header;
+    uint32_t count = header->count;
+
+    if (count >= header->capacity) {
+        return -1;
+    }
+
+    scomx_snapshot_slot_t *slot = &snap->slots[count];
+    slot->dst_addr = dst_addr;
+    slot->object_type = (uint16_t)object_type;
+    slot->object_id = object_id;
+
+    // readers only look at the slots below the count
+    __atomic_store_n(&header->count, count + 1, __ATOMIC_RELEASE);
+
+    return (int)count;
+}
+
+void scomx_snapshot_publish(scomx_snapshot_t *snap, int index, int64_t timestamp_ms, float value, scom_error_t error)
+{
+    scomx_snapshot_slot_t *slot = &snap->slots[index];
+    // only the publisher writes the sequence number
+    uint32_t seq = slot->seq;
+
+    __atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    __atomic_store_n(&slot->timestamp_ms, timestamp_ms, __ATOMIC_RELAXED);
+    __atomic_store(&slot->value, &value, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->error, (uint16_t)error, __ATOMIC_RELAXED);
+
+    // 0 is kept for slots without a value
+    seq += 2;
+    __atomic_store_n(&slot->seq, seq ? seq : 2, __ATOMIC_RELEASE);
+}
+
+int scomx_snapshot_find(const scomx_snapshot_t *snap, uint32_t dst_addr, scom_object_type_t object_type, uint32_t object_id)
+{
+    uint32_t count = __atomic_load_n(&snap->header->count, __ATOMIC_ACQUIRE);
+
+    for (uint32_t i = 0; i < count; i++) {
+        const scomx_snapshot_slot_t *slot = &snap->slots[i];
+
+        if (slot->dst_addr == dst_addr && slot->object_type == object_type && slot->object_id == object_id) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+int scomx_snapshot_read(const scomx_snapshot_t *snap, int index, scomx_sample_t *sample)
+{
+    const scomx_snapshot_slot_t *slot = &snap->slots[index];
+
+    for (unsigned attempt = 0; attempt < READ_ATTEMPTS; attempt++) {
+        uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+
+        if (seq == 0) {
+            return -1;
+        }
+        if (seq & 1) {
+            continue;
+        }
+
+        sample->timestamp_ms = __atomic_load_n(&slot->timestamp_ms, __ATOMIC_RELAXED);
+        __atomic_load(&slot->value, &sample->value, __ATOMIC_RELAXED);
+        sample->error = (scom_error_t)__atomic_load_n(&slot->error, __ATOMIC_RELAXED);
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == seq) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+uint32_t scomx_snapshot_generation(const scomx_snapshot_t *snap) { return __atomic_load_n(&snap->header->generation, __ATOMIC_ACQUIRE); }
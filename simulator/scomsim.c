@@ -0,0 +1,823 @@
+// Xcom-232i simulator
+//
+// Opens pseudo-terminals and answers read/write property requests like an Xcom-232i gateway with
+// an Xtender, VarioTrack and BSP behind it and datalog files on its SD card, so that scomlib_extra
+// and the examples can be exercised and benchmarked without Studer hardware. Faults (busy gateway, lost bytes, bad checksums) can be
+// injected with configurable probabilities, device messages and RCC resets at configurable intervals.
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 600
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../scomlib_extra/scomlib_extra.h"
+
+#define MAX_PORTS 16
+#define MAX_LATENCY_OVERRIDES 16
+#define MAX_PARAMETERS 128
+#define MAX_DATALOG_FILES 64
+
+// largest datalog block, limited by the frame buffers
+#define MAX_DATALOG_BLOCK 1024
+
+// first datalog file, named LG240101.CSV on the SD card
+#define FIRST_DATALOG_FILE_ID 240101
+
+// messages kept in the message objects, older ones are dropped
+#define MAX_MESSAGES 128
+
+// a pty without a client is left out of poll for this long, then checked again for a client
+#define HANGUP_RECHECK_MS 100
+
+typedef struct {
+    uint32_t addr;
+    unsigned latency_ms;
+} latency_override_t;
+
+typedef struct {
+    unsigned ports;
+    unsigned baud;
+    unsigned latency_ms;
+    latency_override_t latency_overrides[MAX_LATENCY_OVERRIDES];
+    unsigned latency_override_count;
+    unsigned busy_percent;
+    unsigned drop_percent;
+    unsigned corrupt_percent;
+    unsigned datalog_files;
+    unsigned datalog_size;
+    unsigned datalog_block;
+    unsigned message_interval_ms;
+    unsigned rcc_reset_interval_ms;
+    const char *link_prefix;
+    int verbose;
+} sim_config_t;
+
+typedef struct {
+    int fd;
+    char link_path[256];
+
+    scomx_parser_t parser;
+    char rxbuf[256];
+
+    scomx_ctx_t ctx;
+    char txbuf[SCOM_FRAME_HEADER_SIZE + 2 + 8 + 4 + MAX_DATALOG_BLOCK + 2];
+
+    // datalog transfer in progress, NULL when none
+    const struct sim_file *dl_file;
+    uint32_t dl_offset;
+    // set when the block at dl_offset has been sent and the next SD_READ_NEXT moves past it
+    int dl_sent;
+
+    // messages and RCC resets already reported to the client of this port
+    unsigned long messages_read;
+    unsigned long rcc_resets_reported;
+
+    // response being sent: starts at due_ms and is paced at the configured baud rate
+    const char *tx_data;
+    size_t tx_length;
+    size_t tx_sent;
+    int64_t due_ms;
+
+    // bytes read after a request whose response is still being sent, parsed once it has been sent
+    char pending[256];
+    size_t pending_length;
+
+    // no client had the pty open when polled, it isn't polled again until this time
+    int64_t hangup_until_ms;
+
+    unsigned long requests;
+} sim_port_t;
+
+typedef struct {
+    uint32_t dst_addr;
+    uint32_t object_id;
+    char value[SCOMX_TYPED_VALUE_SIZE];
+} sim_parameter_t;
+
+typedef struct sim_file {
+    uint32_t object_id;
+    char *data;
+    uint32_t size;
+} sim_file_t;
+
+static sim_config_t g_config = {1, 38400, 20, {{0, 0}}, 0, 0, 0, 0, 3, 65536, MAX_DATALOG_BLOCK, 0, 0, NULL, 0};
+static sim_port_t g_ports[MAX_PORTS];
+static sim_parameter_t g_parameters[MAX_PARAMETERS];
+static unsigned g_parameter_count;
+// g_files[0] is the list of the other files
+static sim_file_t g_files[MAX_DATALOG_FILES + 1];
+static unsigned g_file_count;
+static int64_t g_start_ms;
+// messages generated and RCC resets done since the start
+static unsigned long g_message_total;
+static unsigned long g_rcc_resets;
+static volatile int g_running = 1;
+
+static int64_t now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    g_running = 0;
+}
+
+static int chance(unsigned percent) { return percent > 0 && (unsigned)(rand() % 100) < percent; }
+
+static unsigned latency_for(uint32_t addr)
+{
+    for (unsigned i = 0; i < g_config.latency_override_count; i++) {
+        if (g_config.latency_overrides[i].addr == addr) {
+            return g_config.latency_overrides[i].latency_ms;
+        }
+    }
+    return g_config.latency_ms;
+}
+
+// 0 when the device doesn't exist, otherwise the first digit of the object ids the device answers
+// (3xxx/1xxx Xtender, 11xxx/10xxx VarioTrack, 7xxx/6xxx BSP, 5xxx remote control)
+static int device_family(uint32_t addr)
+{
+    if (addr >= 101 && addr <= 109) {
+        return 1;
+    } else if (addr >= 301 && addr <= 315) {
+        return 2;
+    } else if (addr == 601) {
+        return 3;
+    } else if (addr == 501) {
+        return 4;
+    }
+    return 0;
+}
+
+static int user_info_family(uint32_t object_id)
+{
+    if (object_id >= 3000 && object_id < 3200) {
+        return 1;
+    } else if (object_id >= 11000 && object_id < 11100) {
+        return 2;
+    } else if (object_id >= 7000 && object_id < 7100) {
+        return 3;
+    }
+    return 0;
+}
+
+static int parameter_family(uint32_t object_id)
+{
+    if (object_id >= 1000 && object_id < 2000) {
+        return 1;
+    } else if (object_id >= 10000 && object_id < 11000) {
+        return 2;
+    } else if (object_id >= 6000 && object_id < 7000) {
+        return 3;
+    } else if (object_id >= 5000 && object_id < 6000) {
+        return 4;
+    }
+    return 0;
+}
+
+static sim_parameter_t *find_parameter(uint32_t dst_addr, uint32_t object_id, int create)
+{
+    for (unsigned i = 0; i < g_parameter_count; i++) {
+        if (g_parameters[i].dst_addr == dst_addr && g_parameters[i].object_id == object_id) {
+            return &g_parameters[i];
+        }
+    }
+    if (!create || g_parameter_count >= MAX_PARAMETERS) {
+        return NULL;
+    }
+
+    sim_parameter_t *param = &g_parameters[g_parameter_count++];
+    param->dst_addr = dst_addr;
+    param->object_id = object_id;
+    scom_write_le_float(param->value, 0);
+    return param;
+}
+
+// a slowly varying value derived from the object id
+static float user_info_value(uint32_t object_id, unsigned long counter) { return (float)(object_id % 1000) / 10.0f + (float)(counter % 10) / 10.0f; }
+
+// encodes a user info value in the format of the object, as float when it has no metadata
+static size_t encode_user_info(uint32_t object_id, unsigned long counter, char *value)
+{
+    const scomx_object_meta_t *meta = scomx_object_meta(SCOM_USER_INFO_OBJECT_TYPE, object_id);
+
+    if (!meta) {
+        scom_write_le_float(value, user_info_value(object_id, counter));
+        return 4;
+    }
+    // enums step through their labelled values, the others vary as sent by the device
+    if (meta->label_count > 0) {
+        return meta->encode(meta, (float)(counter % meta->label_count), value);
+    }
+    return meta->encode(meta, user_info_value(object_id, counter) * meta->scale, value);
+}
+
+// parameters without metadata are kept as float
+static size_t parameter_size(uint32_t object_id)
+{
+    const scomx_object_meta_t *meta = scomx_object_meta(SCOM_PARAMETER_OBJECT_TYPE, object_id);
+    return meta ? meta->size : 4;
+}
+
+static size_t encode_parameter(uint32_t object_id, float v, char *value)
+{
+    const scomx_object_meta_t *meta = scomx_object_meta(SCOM_PARAMETER_OBJECT_TYPE, object_id);
+
+    if (!meta) {
+        scom_write_le_float(value, v);
+        return 4;
+    }
+    return meta->encode(meta, v, value);
+}
+
+// datalog files with a CSV line per minute, plus the list of their ids
+static int create_datalog_files()
+{
+    sim_file_t *list = &g_files[0];
+
+    list->object_id = SCOMX_DATALOG_FILE_LIST_ID;
+    list->size = g_config.datalog_files * 4;
+    list->data = malloc(list->size + 1);
+
+    for (unsigned i = 0; i < g_config.datalog_files; i++) {
+        sim_file_t *file = &g_files[i + 1];
+
+        file->object_id = FIRST_DATALOG_FILE_ID + i;
+        file->size = g_config.datalog_size;
+        file->data = malloc(file->size + 64);
+        if (!list->data || !file->data) {
+            return -1;
+        }
+
+        uint32_t length = 0;
+        for (unsigned minute = 0; length < file->size; minute++) {
+            length += sprintf(file->data + length, "%02u:%02u;%u;%.1f;%.2f\n", minute / 60 % 24, minute % 60, file->object_id, 48.0f + (minute % 50) / 10.0f,
+                              (float)((minute * 37 + i) % 1000) / 100.0f);
+        }
+        // whole lines only
+        file->size = length;
+
+        scom_write_le32(list->data + i * 4, file->object_id);
+    }
+
+    g_file_count = g_config.datalog_files + 1;
+
+    return 0;
+}
+
+static const sim_file_t *find_file(uint32_t object_id)
+{
+    for (unsigned i = 0; i < g_file_count; i++) {
+        if (g_files[i].object_id == object_id) {
+            return &g_files[i];
+        }
+    }
+    return NULL;
+}
+
+// generates the messages and RCC resets due by now; a reset restores the default parameter values
+static void update_events(int64_t now)
+{
+    if (g_config.message_interval_ms > 0) {
+        g_message_total = (unsigned long)((now - g_start_ms) / g_config.message_interval_ms);
+    }
+    if (g_config.rcc_reset_interval_ms > 0) {
+        unsigned long resets = (unsigned long)((now - g_start_ms) / g_config.rcc_reset_interval_ms);
+        if (resets != g_rcc_resets) {
+            g_rcc_resets = resets;
+            g_parameter_count = 0;
+        }
+    }
+}
+
+// message object object_id, 0 being the newest message
+static scomx_enc_result_t encode_message(sim_port_t *port, const scomx_dec_result_t *req, scom_frame_flags_t flags)
+{
+    // alternating battery and AC input warnings
+    static const uint16_t k_types[] = {0, 1, 20, 22, 81};
+    unsigned long kept = g_message_total < MAX_MESSAGES ? g_message_total : MAX_MESSAGES;
+    char message[SCOMX_MESSAGE_SIZE];
+
+    if (req->object_id >= kept) {
+        return scomx_ctx_encode_error_response(&port->ctx, req->dst_addr, flags, (scom_service_t)req->service_id, SCOM_MESSAGE_OBJECT_TYPE, req->object_id,
+                                               req->property_id, SCOM_ERROR_OBJECT_ID_NOT_FOUND);
+    }
+
+    unsigned long seq = g_message_total - 1 - req->object_id;
+
+    scom_write_le32(message, (uint32_t)g_message_total);
+    scom_write_le16(message + 4, k_types[seq % SCOM_NBR_ELEMENTS(k_types)]);
+    scom_write_le32(message + 6, SCOMX_DEST_XTM(0));
+    // the simulated clock starts at 2024-01-01
+    scom_write_le32(message + 10, (uint32_t)(1704067200 + (int64_t)seq * g_config.message_interval_ms / 1000));
+    scom_write_le32(message + 14, (uint32_t)seq);
+
+    if (req->object_id == 0) {
+        port->messages_read = g_message_total;
+    }
+
+    return scomx_ctx_encode_property_response(&port->ctx, req->dst_addr, flags, SCOM_READ_PROPERTY_SERVICE, SCOM_MESSAGE_OBJECT_TYPE, req->object_id,
+                                              req->property_id, message, sizeof(message));
+}
+
+// the block at the current offset of the transfer: its offset followed by up to datalog_block bytes
+static scomx_enc_result_t encode_datalog_block(sim_port_t *port, const scomx_dec_result_t *req, scom_frame_flags_t flags)
+{
+    char block[4 + MAX_DATALOG_BLOCK];
+    uint32_t length = port->dl_file->size - port->dl_offset;
+
+    if (length > g_config.datalog_block) {
+        length = g_config.datalog_block;
+    }
+
+    scom_write_le32(block, port->dl_offset);
+    memcpy(block + 4, port->dl_file->data + port->dl_offset, length);
+    port->dl_sent = 1;
+
+    return scomx_ctx_encode_property_response(&port->ctx, req->dst_addr, flags, SCOM_READ_PROPERTY_SERVICE, SCOM_DATALOG_TRANSFER_OBJECT_TYPE, req->object_id,
+                                              req->property_id, block, 4 + length);
+}
+
+static scomx_enc_result_t handle_datalog_request(sim_port_t *port, const scomx_dec_result_t *req, scom_frame_flags_t flags)
+{
+    const sim_file_t *file = find_file(req->object_id);
+    char size[4];
+
+#define ERROR_RESPONSE(err)                                                                                                                                         \
+    scomx_ctx_encode_error_response(&port->ctx, req->dst_addr, flags, (scom_service_t)req->service_id, (scom_object_type_t)req->object_type, req->object_id,       \
+                                    req->property_id, err)
+
+    if (req->service_id != SCOM_READ_PROPERTY_SERVICE) {
+        return ERROR_RESPONSE(SCOM_ERROR_PROPERTY_IS_READ_ONLY);
+    }
+    if (!file) {
+        return ERROR_RESPONSE(SCOM_ERROR_OBJECT_ID_NOT_FOUND);
+    }
+
+    switch (req->property_id) {
+    case SCOMX_PROP_DATALOG_SD_START:
+        port->dl_file = file;
+        port->dl_offset = 0;
+        port->dl_sent = 0;
+        scom_write_le32(size, file->size);
+        return scomx_ctx_encode_property_response(&port->ctx, req->dst_addr, flags, SCOM_READ_PROPERTY_SERVICE, SCOM_DATALOG_TRANSFER_OBJECT_TYPE, req->object_id,
+                                                  req->property_id, size, sizeof(size));
+    case SCOMX_PROP_DATALOG_SD_READ_NEXT:
+    case SCOMX_PROP_DATALOG_SD_READ_AGAIN:
+        if (port->dl_file != file) {
+            return ERROR_RESPONSE(SCOM_ERROR_READ_PROPERTY_FAILED);
+        }
+        if (req->property_id == SCOMX_PROP_DATALOG_SD_READ_NEXT && port->dl_sent) {
+            uint32_t remaining = file->size - port->dl_offset;
+            port->dl_offset += remaining < g_config.datalog_block ? remaining : g_config.datalog_block;
+        }
+        return encode_datalog_block(port, req, flags);
+    case SCOMX_PROP_DATALOG_SD_ABORT:
+        port->dl_file = NULL;
+        return scomx_ctx_encode_property_response(&port->ctx, req->dst_addr, flags, SCOM_READ_PROPERTY_SERVICE, SCOM_DATALOG_TRANSFER_OBJECT_TYPE, req->object_id,
+                                                  req->property_id, NULL, 0);
+    default:
+        return ERROR_RESPONSE(SCOM_ERROR_PROPERTY_NOT_SUPPORTED);
+    }
+
+#undef ERROR_RESPONSE
+}
+
+static scomx_enc_result_t handle_request(sim_port_t *port, const scomx_dec_result_t *req)
+{
+    scom_frame_flags_t flags;
+    char value[SCOMX_TYPED_VALUE_SIZE];
+    size_t value_length = 4;
+    int family = device_family(req->dst_addr);
+
+    update_events(now_ms());
+
+    // reported in the header of every response of the gateway
+    uint8_t flag_bits = g_config.datalog_files > 0 ? SCOMX_FLAG_SD_CARD_PRESENT : 0;
+    if (port->messages_read < g_message_total) {
+        flag_bits |= SCOMX_FLAG_MESSAGE_PENDING;
+    }
+    if (port->rcc_resets_reported != g_rcc_resets) {
+        flag_bits |= SCOMX_FLAG_RCC_RESET;
+        port->rcc_resets_reported = g_rcc_resets;
+    }
+    flags = scomx_frame_flags_from_byte(flag_bits);
+
+#define ERROR_RESPONSE(err)                                                                                                                                         \
+    scomx_ctx_encode_error_response(&port->ctx, req->dst_addr, flags, (scom_service_t)req->service_id, (scom_object_type_t)req->object_type, req->object_id,       \
+                                    req->property_id, err)
+
+    if (chance(g_config.busy_percent)) {
+        return ERROR_RESPONSE(SCOM_ERROR_GATEWAY_BUSY);
+    }
+    if (family == 0) {
+        return ERROR_RESPONSE(SCOM_ERROR_DEVICE_NOT_FOUND);
+    }
+    if (req->service_id != SCOM_READ_PROPERTY_SERVICE && req->service_id != SCOM_WRITE_PROPERTY_SERVICE) {
+        return ERROR_RESPONSE(SCOM_ERROR_SERVICE_NOT_SUPPORTED);
+    }
+
+    if (req->object_type == SCOM_USER_INFO_OBJECT_TYPE) {
+        if (user_info_family(req->object_id) != family) {
+            return ERROR_RESPONSE(SCOM_ERROR_OBJECT_ID_NOT_FOUND);
+        }
+        if (req->property_id != SCOMX_PROP_USER_INFO_VALUE) {
+            return ERROR_RESPONSE(SCOM_ERROR_PROPERTY_NOT_SUPPORTED);
+        }
+        if (req->service_id == SCOM_WRITE_PROPERTY_SERVICE) {
+            return ERROR_RESPONSE(SCOM_ERROR_PROPERTY_IS_READ_ONLY);
+        }
+
+        value_length = encode_user_info(req->object_id, port->requests, value);
+        return scomx_ctx_encode_property_response(&port->ctx, req->dst_addr, flags, SCOM_READ_PROPERTY_SERVICE, SCOM_USER_INFO_OBJECT_TYPE, req->object_id,
+                                                  req->property_id, value, value_length);
+    }
+
+    if (req->object_type == SCOM_PARAMETER_OBJECT_TYPE) {
+        if (parameter_family(req->object_id) != family) {
+            return ERROR_RESPONSE(SCOM_ERROR_OBJECT_ID_NOT_FOUND);
+        }
+
+        switch (req->property_id) {
+        case SCOMX_PROP_PARAMETER_VALUE_QSP:
+        case SCOMX_PROP_PARAMETER_UNSAVED_VALUE_QSP:
+            if (req->service_id == SCOM_WRITE_PROPERTY_SERVICE) {
+                if (req->length != parameter_size(req->object_id)) {
+                    return ERROR_RESPONSE(SCOM_ERROR_INVALID_DATA_LENGTH);
+                }
+                sim_parameter_t *param = find_parameter(req->dst_addr, req->object_id, 1);
+                if (!param) {
+                    return ERROR_RESPONSE(SCOM_ERROR_WRITE_PROPERTY_FAILED);
+                }
+                memcpy(param->value, req->data, req->length);
+                return scomx_ctx_encode_property_response(&port->ctx, req->dst_addr, flags, SCOM_WRITE_PROPERTY_SERVICE, SCOM_PARAMETER_OBJECT_TYPE,
+                                                          req->object_id, req->property_id, NULL, 0);
+            } else {
+                sim_parameter_t *param = find_parameter(req->dst_addr, req->object_id, 0);
+                value_length = parameter_size(req->object_id);
+                if (param) {
+                    memcpy(value, param->value, value_length);
+                } else {
+                    encode_parameter(req->object_id, 0, value);
+                }
+            }
+            break;
+        case SCOMX_PROP_PARAMETER_MIN_QSP:
+            value_length = encode_parameter(req->object_id, 0, value);
+            break;
+        case SCOMX_PROP_PARAMETER_MAX_QSP:
+            value_length = encode_parameter(req->object_id, 1000, value);
+            break;
+        case SCOMX_PROP_PARAMETER_LEVEL_QSP:
+            scom_write_le32(value, 0x10);
+            break;
+        default:
+            return ERROR_RESPONSE(SCOM_ERROR_PROPERTY_NOT_SUPPORTED);
+        }
+
+        if (req->service_id == SCOM_WRITE_PROPERTY_SERVICE) {
+            return ERROR_RESPONSE(SCOM_ERROR_PROPERTY_IS_READ_ONLY);
+        }
+        return scomx_ctx_encode_property_response(&port->ctx, req->dst_addr, flags, SCOM_READ_PROPERTY_SERVICE, SCOM_PARAMETER_OBJECT_TYPE, req->object_id,
+                                                  req->property_id, value, value_length);
+    }
+
+    // the messages are kept by the gateway
+    if (req->object_type == SCOM_MESSAGE_OBJECT_TYPE && family == 4) {
+        if (req->property_id != SCOMX_PROP_MESSAGE) {
+            return ERROR_RESPONSE(SCOM_ERROR_PROPERTY_NOT_SUPPORTED);
+        }
+        if (req->service_id == SCOM_WRITE_PROPERTY_SERVICE) {
+            return ERROR_RESPONSE(SCOM_ERROR_PROPERTY_IS_READ_ONLY);
+        }
+        return encode_message(port, req, flags);
+    }
+
+    // the SD card is in the gateway
+    if (req->object_type == SCOM_DATALOG_TRANSFER_OBJECT_TYPE && family == 4) {
+        return handle_datalog_request(port, req, flags);
+    }
+
+    return ERROR_RESPONSE(SCOM_ERROR_TYPE_NOT_SUPPORTED);
+
+#undef ERROR_RESPONSE
+}
+
+// injects the configured faults into an encoded response
+static void inject_faults(scomx_enc_result_t *res)
+{
+    if (chance(g_config.corrupt_percent)) {
+        // flip a bit of the data checksum
+        res->data[res->length - 1] ^= 0x01;
+    }
+    if (chance(g_config.drop_percent) && res->length > 1) {
+        size_t pos = rand() % res->length;
+        memmove(res->data + pos, res->data + pos + 1, res->length - pos - 1);
+        res->length--;
+    }
+}
+
+// answers the requests in data until one has a response to send, keeping the rest as pending
+static void handle_input(sim_port_t *port, const char *data, size_t length)
+{
+    size_t offset = 0;
+
+    while (offset < length && !port->tx_data) {
+        scomx_parse_result_t parsed = scomx_parser_push(&port->parser, data + offset, length - offset);
+        offset += parsed.consumed;
+
+        if (!parsed.frame_ready) {
+            break;
+        }
+        if (parsed.result.error != SCOM_ERROR_NO_ERROR) {
+            // the gateway ignores corrupted requests, the client times out
+            continue;
+        }
+
+        port->requests++;
+
+        scomx_enc_result_t res = handle_request(port, &parsed.result);
+        if (res.error != SCOM_ERROR_NO_ERROR) {
+            continue;
+        }
+
+        inject_faults(&res);
+
+        if (g_config.verbose) {
+            printf("port %ld: request dst %u type %u obj %u prop %u -> %zu byte response\n", (long)(port - g_ports), parsed.result.dst_addr,
+                   parsed.result.object_type, parsed.result.object_id, parsed.result.property_id, res.length);
+        }
+
+        port->tx_data = res.data;
+        port->tx_length = res.length;
+        port->tx_sent = 0;
+        port->due_ms = now_ms() + latency_for(parsed.result.dst_addr);
+    }
+
+    // a client pipelining its requests may have sent the next ones in the same chunk
+    memmove(port->pending, data + offset, length - offset);
+    port->pending_length = length - offset;
+}
+
+static void receive(sim_port_t *port)
+{
+    char buf[sizeof(port->pending)];
+    ssize_t ret = read(port->fd, buf, sizeof(buf));
+
+    if (ret > 0) {
+        handle_input(port, buf, (size_t)ret);
+    }
+}
+
+// sends as much of the pending response as the simulated line speed allows; returns ms until more can be sent
+static int transmit(sim_port_t *port, int64_t now)
+{
+    if (!port->tx_data) {
+        return -1;
+    }
+    if (now < port->due_ms) {
+        return (int)(port->due_ms - now);
+    }
+
+    size_t allowed = port->tx_length;
+    if (g_config.baud > 0) {
+        // 11 bits per byte with 8E1
+        allowed = (size_t)((now - port->due_ms) * g_config.baud / 11000) + 1;
+        if (allowed > port->tx_length) {
+            allowed = port->tx_length;
+        }
+    }
+
+    if (allowed > port->tx_sent) {
+        ssize_t ret = write(port->fd, port->tx_data + port->tx_sent, allowed - port->tx_sent);
+        if (ret > 0) {
+            port->tx_sent += ret;
+        }
+    }
+
+    if (port->tx_sent >= port->tx_length) {
+        port->tx_data = NULL;
+        if (port->pending_length > 0) {
+            handle_input(port, port->pending, port->pending_length);
+        }
+        return port->tx_data ? (int)(port->due_ms - now) : -1;
+    }
+    return 1;
+}
+
+static int open_port(sim_port_t *port, unsigned index)
+{
+    struct termios tio;
+
+    port->fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (port->fd < 0 || grantpt(port->fd) != 0 || unlockpt(port->fd) != 0) {
+        perror("posix_openpt");
+        return -1;
+    }
+
+    // raw mode on the slave side so that the frames pass unchanged
+    int slave = open(ptsname(port->fd), O_RDWR | O_NOCTTY);
+    if (slave >= 0) {
+        if (tcgetattr(slave, &tio) == 0) {
+            cfmakeraw(&tio);
+            tcsetattr(slave, TCSANOW, &tio);
+        }
+        close(slave);
+    }
+
+    if (g_config.link_prefix) {
+        snprintf(port->link_path, sizeof(port->link_path), "%s%u", g_config.link_prefix, index);
+        unlink(port->link_path);
+        if (symlink(ptsname(port->fd), port->link_path) != 0) {
+            perror("symlink");
+            return -1;
+        }
+        printf("%s -> %s\n", port->link_path, ptsname(port->fd));
+    } else {
+        printf("%s\n", ptsname(port->fd));
+    }
+
+    scomx_parser_init(&port->parser, port->rxbuf, sizeof(port->rxbuf));
+    port->parser.decode_requests = 1;
+    scomx_ctx_init(&port->ctx, port->txbuf, sizeof(port->txbuf));
+
+    return 0;
+}
+
+static void usage(const char *name)
+{
+    printf("Usage: %s [options]\n"
+           "  -p ports      number of pseudo-terminals to open (default 1, max %d)\n"
+           "  -o prefix     create symlinks prefix0, prefix1, ... to the pseudo-terminals\n"
+           "  -b baud       pace responses at this line speed, 0 to disable (default 38400)\n"
+           "  -l ms         response latency of all devices (default 20)\n"
+           "  -L addr:ms    response latency of a single device, may be repeated\n"
+           "  -B percent    probability of a GATEWAY_BUSY response\n"
+           "  -D percent    probability of dropping a byte of a response\n"
+           "  -C percent    probability of a corrupted response checksum\n"
+           "  -F files      number of datalog files on the SD card (default 3, max %d)\n"
+           "  -S bytes      size of every datalog file (default 65536)\n"
+           "  -k bytes      largest datalog block sent in a response (default and max %d)\n"
+           "  -m ms         generate a device message every ms (default 0, no messages)\n"
+           "  -R ms         reset the RCC every ms, restoring the default parameters (default 0, never)\n"
+           "  -s seed       random seed for the fault injection\n"
+           "  -v            print every request\n",
+           name, MAX_PORTS, MAX_DATALOG_FILES, MAX_DATALOG_BLOCK);
+}
+
+int main(int argc, char *argv[])
+{
+    int opt;
+
+    srand(1);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    while ((opt = getopt(argc, argv, "p:o:b:l:L:B:D:C:F:S:k:m:R:s:vh")) != -1) {
+        switch (opt) {
+        case 'p':
+            g_config.ports = atoi(optarg);
+            break;
+        case 'o':
+            g_config.link_prefix = optarg;
+            break;
+        case 'b':
+            g_config.baud = atoi(optarg);
+            break;
+        case 'l':
+            g_config.latency_ms = atoi(optarg);
+            break;
+        case 'L':
+            if (g_config.latency_override_count < MAX_LATENCY_OVERRIDES) {
+                latency_override_t *o = &g_config.latency_overrides[g_config.latency_override_count++];
+                if (sscanf(optarg, "%u:%u", &o->addr, &o->latency_ms) != 2) {
+                    usage(argv[0]);
+                    return 1;
+                }
+            }
+            break;
+        case 'B':
+            g_config.busy_percent = atoi(optarg);
+            break;
+        case 'D':
+            g_config.drop_percent = atoi(optarg);
+            break;
+        case 'C':
+            g_config.corrupt_percent = atoi(optarg);
+            break;
+        case 'F':
+            g_config.datalog_files = atoi(optarg);
+            break;
+        case 'S':
+            g_config.datalog_size = atoi(optarg);
+            break;
+        case 'k':
+            g_config.datalog_block = atoi(optarg);
+            break;
+        case 'm':
+            g_config.message_interval_ms = atoi(optarg);
+            break;
+        case 'R':
+            g_config.rcc_reset_interval_ms = atoi(optarg);
+            break;
+        case 's':
+            srand(atoi(optarg));
+            break;
+        case 'v':
+            g_config.verbose = 1;
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (g_config.ports < 1 || g_config.ports > MAX_PORTS || g_config.datalog_files > MAX_DATALOG_FILES || g_config.datalog_block < 1 ||
+        g_config.datalog_block > MAX_DATALOG_BLOCK) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (create_datalog_files() != 0) {
+        perror("malloc");
+        return 1;
+    }
+
+    for (unsigned i = 0; i < g_config.ports; i++) {
+        if (open_port(&g_ports[i], i) != 0) {
+            return 1;
+        }
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    g_start_ms = now_ms();
+
+    while (g_running) {
+        struct pollfd fds[MAX_PORTS];
+        int timeout = -1;
+        int64_t now = now_ms();
+
+        for (unsigned i = 0; i < g_config.ports; i++) {
+            int wait = transmit(&g_ports[i], now);
+            if (wait >= 0 && (timeout < 0 || wait < timeout)) {
+                timeout = wait;
+            }
+
+            fds[i].fd = g_ports[i].fd;
+            // requests arriving while a response is pending stay in the pty until it has been sent, those
+            // already read with the previous request wait in pending
+            fds[i].events = g_ports[i].tx_data ? 0 : POLLIN;
+            fds[i].revents = 0;
+
+            // POLLHUP is reported whatever the events, so a pty without a client is left out of the set
+            if (now < g_ports[i].hangup_until_ms) {
+                int wait = (int)(g_ports[i].hangup_until_ms - now);
+                fds[i].fd = -1;
+                if (timeout < 0 || wait < timeout) {
+                    timeout = wait;
+                }
+            }
+        }
+
+        if (poll(fds, g_config.ports, timeout) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll");
+            break;
+        }
+
+        for (unsigned i = 0; i < g_config.ports; i++) {
+            if (fds[i].revents & POLLIN) {
+                receive(&g_ports[i]);
+            } else if (fds[i].revents & POLLHUP) {
+                // no client has the pty open, don't spin on the hang-up nor hold up the other ports
+                g_ports[i].hangup_until_ms = now_ms() + HANGUP_RECHECK_MS;
+            }
+        }
+    }
+
+    for (unsigned i = 0; i < g_config.ports; i++) {
+        if (g_ports[i].link_path[0]) {
+            unlink(g_ports[i].link_path);
+        }
+        close(g_ports[i].fd);
+    }
+
+    return 0;
+}